@@ -0,0 +1,255 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include <cstdlib>
+
+#include "math/Allocator.hpp"
+
+using namespace Math;
+
+namespace
+{
+	std::size_t const PageSize = 4096;
+
+	inline std::size_t AlignUp(std::size_t Value, std::size_t Alignment)
+	{
+		return (Value + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	// Small blocks are rounded to a power of two so they pack into cache lines without straddling;
+	// anything larger is rounded to whole cache lines.
+	inline std::size_t PoolBlockSize(std::size_t Size)
+	{
+		if (Size > CacheLineSize)
+			return AlignUp(Size, CacheLineSize);
+
+		std::size_t Block = sizeof(void *);
+		while (Block < Size)
+			Block <<= 1;
+
+		return Block;
+	}
+
+	// Writes one byte per page so the kernel maps the memory now rather than on first use.
+	inline void TouchPages(char *Memory, std::size_t Size)
+	{
+		for (std::size_t Offset = 0; Offset < Size; Offset += PageSize)
+			Memory[Offset] = 0;
+	}
+}
+
+void *Math::AlignedAllocate(std::size_t Size, std::size_t Alignment)
+{
+	// Over-allocate and stash the original pointer just in front of the aligned block.
+	std::size_t Padding = Alignment - 1 + sizeof(void *);
+	char *Raw = static_cast<char *>(std::malloc(Size + Padding));
+
+	if (Raw == NULL)
+		throw std::bad_alloc();
+
+	std::size_t Address = reinterpret_cast<std::size_t>(Raw + sizeof(void *));
+	char *Aligned = reinterpret_cast<char *>(AlignUp(Address, Alignment));
+	reinterpret_cast<void **>(Aligned)[-1] = Raw;
+
+	return Aligned;
+}
+
+void Math::AlignedFree(void *Pointer)
+{
+	if (Pointer != NULL)
+		std::free(reinterpret_cast<void **>(Pointer)[-1]);
+}
+
+// Arena ==================================================
+
+Arena::Arena(std::size_t ChunkSize) :
+	ChunkSize(AlignUp(ChunkSize, CacheLineSize)),
+	CurrentChunk(0),
+	Offset(0)
+{
+
+}
+
+Arena::~Arena()
+{
+	this->Release();
+}
+
+void *Arena::Allocate(std::size_t Size, std::size_t Alignment)
+{
+	if (Size == 0)
+		Size = 1;
+
+	while (CurrentChunk < Chunks.size())
+	{
+		// Align the address rather than the offset: chunks are only cache line aligned, and
+		// Alignment may be larger.
+		Chunk &c = Chunks[CurrentChunk];
+		std::size_t Base = reinterpret_cast<std::size_t>(c.Memory);
+		std::size_t Start = AlignUp(Base + Offset, Alignment) - Base;
+
+		if (Start + Size <= c.Size)
+		{
+			Offset = Start + Size;
+			Stats.BytesInUse += Size;
+			Stats.AllocationCount++;
+			if (Stats.BytesInUse > Stats.HighWaterMark)
+				Stats.HighWaterMark = Stats.BytesInUse;
+
+			return c.Memory + Start;
+		}
+
+		// This chunk is exhausted; move on to the next one retained from a previous frame.
+		CurrentChunk++;
+		Offset = 0;
+	}
+
+	// Size + Alignment leaves room to align within a new chunk whatever its address.
+	this->AddChunk(Size + Alignment);
+	return this->Allocate(Size, Alignment);
+}
+
+void Arena::Reserve(std::size_t Size)
+{
+	std::size_t Available = 0;
+	for (std::size_t Index = CurrentChunk; Index < Chunks.size(); Index++)
+		Available += Chunks[Index].Size;
+
+	if (Available >= Offset + Size)
+		return;
+
+	this->AddChunk(Size);
+	TouchPages(Chunks.back().Memory, Chunks.back().Size);
+}
+
+void Arena::Reset()
+{
+	CurrentChunk = 0;
+	Offset = 0;
+	Stats.BytesInUse = 0;
+	Stats.AllocationCount = 0;
+	Stats.ResetCount++;
+}
+
+void Arena::Release()
+{
+	for (std::size_t Index = 0; Index < Chunks.size(); Index++)
+		AlignedFree(Chunks[Index].Memory);
+
+	Chunks.clear();
+	Stats.BytesReserved = 0;
+	this->Reset();
+}
+
+void Arena::AddChunk(std::size_t MinimumSize)
+{
+	Chunk c;
+	c.Size = (MinimumSize > ChunkSize ? AlignUp(MinimumSize, CacheLineSize) : ChunkSize);
+	c.Memory = static_cast<char *>(AlignedAllocate(c.Size));
+
+	Chunks.push_back(c);
+	Stats.BytesReserved += c.Size;
+}
+
+// Pool ===================================================
+
+Pool::Pool(std::size_t BlockSize, std::size_t BlocksPerChunk) :
+	Block(PoolBlockSize(BlockSize)),
+	BlocksPerChunk(BlocksPerChunk > 0 ? BlocksPerChunk : 1),
+	FreeList(NULL)
+{
+
+}
+
+Pool::~Pool()
+{
+	this->Release();
+}
+
+void *Pool::Allocate()
+{
+	if (FreeList == NULL)
+		this->AddChunk();
+
+	void *Result = FreeList;
+	FreeList = *static_cast<void **>(FreeList);
+
+	Stats.BytesInUse += Block;
+	Stats.AllocationCount++;
+	if (Stats.BytesInUse > Stats.HighWaterMark)
+		Stats.HighWaterMark = Stats.BytesInUse;
+
+	return Result;
+}
+
+void Pool::Free(void *Pointer)
+{
+	if (Pointer == NULL)
+		return;
+
+	*static_cast<void **>(Pointer) = FreeList;
+	FreeList = Pointer;
+	Stats.BytesInUse -= Block;
+}
+
+void Pool::Reset()
+{
+	// Rebuild the free list so blocks are handed out in address order again.
+	FreeList = NULL;
+	for (std::size_t Index = Chunks.size(); Index > 0; Index--)
+	{
+		char *Memory = Chunks[Index - 1];
+		for (std::size_t b = BlocksPerChunk; b > 0; b--)
+		{
+			void *p = Memory + (b - 1) * Block;
+			*static_cast<void **>(p) = FreeList;
+			FreeList = p;
+		}
+	}
+
+	Stats.BytesInUse = 0;
+	Stats.AllocationCount = 0;
+	Stats.ResetCount++;
+}
+
+void Pool::Release()
+{
+	for (std::size_t Index = 0; Index < Chunks.size(); Index++)
+		AlignedFree(Chunks[Index]);
+
+	Chunks.clear();
+	FreeList = NULL;
+	Stats.BytesInUse = 0;
+	Stats.BytesReserved = 0;
+	Stats.AllocationCount = 0;
+}
+
+void Pool::AddChunk()
+{
+	char *Memory = static_cast<char *>(AlignedAllocate(Block * BlocksPerChunk));
+	Chunks.push_back(Memory);
+	Stats.BytesReserved += Block * BlocksPerChunk;
+
+	for (std::size_t b = BlocksPerChunk; b > 0; b--)
+	{
+		void *p = Memory + (b - 1) * Block;
+		*static_cast<void **>(p) = FreeList;
+		FreeList = p;
+	}
+}
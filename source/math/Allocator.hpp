@@ -0,0 +1,252 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_ALLOCATOR
+#define SMALLMATH_ALLOCATOR
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "math/EulerAngles.hpp"
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Every block handed out by the allocators below starts on a cache line, so SIMD loads of
+	// Vector4/Matrix4/Quaternion arrays never straddle one.
+	static const std::size_t CacheLineSize = 64;
+
+	void *AlignedAllocate(std::size_t Size, std::size_t Alignment = CacheLineSize);
+	void AlignedFree(void *Pointer);
+
+	struct AllocatorStatistics
+	{
+		AllocatorStatistics() : BytesInUse(0), HighWaterMark(0), BytesReserved(0), AllocationCount(0), ResetCount(0) { }
+
+		std::size_t BytesInUse;			// Bytes handed out since the last reset
+		std::size_t HighWaterMark;		// Largest BytesInUse ever seen, across resets
+		std::size_t BytesReserved;		// Bytes currently owned by the allocator
+		std::size_t AllocationCount;	// Allocations since the last reset
+		std::size_t ResetCount;
+	};
+
+	// Linear frame allocator.  Allocations are bumped out of large chunks and are never freed
+	// individually; Reset() at the end of a frame releases everything at once while keeping the
+	// chunks (and their already faulted-in pages) for the next frame.
+	class Arena
+	{
+	public:
+		Arena(std::size_t ChunkSize = 1 << 20);
+		~Arena();
+
+		void *Allocate(std::size_t Size, std::size_t Alignment = CacheLineSize);	// Any power of two
+		void Reserve(std::size_t Size);		// Preallocates and touches Size bytes
+		void Reset();
+		void Release();						// Reset() and return all chunks to the system
+
+		inline AllocatorStatistics const &Statistics() const;
+
+	private:
+		Arena(Arena const &);
+		Arena &operator=(Arena const &);
+
+		struct Chunk
+		{
+			char *Memory;
+			std::size_t Size;
+		};
+
+		void AddChunk(std::size_t MinimumSize);
+
+		std::vector<Chunk> Chunks;
+		std::size_t ChunkSize;
+		std::size_t CurrentChunk;
+		std::size_t Offset;
+		AllocatorStatistics Stats;
+	};
+
+	// Fixed-size block allocator.  Freed blocks go onto an intrusive free list and are reused
+	// before any new chunk is requested.
+	class Pool
+	{
+	public:
+		Pool(std::size_t BlockSize, std::size_t BlocksPerChunk = 1024);
+		~Pool();
+
+		void *Allocate();
+		void Free(void *Pointer);
+		void Reset();						// Returns every block to the free list
+		void Release();
+
+		inline std::size_t BlockSize() const;
+		inline AllocatorStatistics const &Statistics() const;
+
+	private:
+		Pool(Pool const &);
+		Pool &operator=(Pool const &);
+
+		void AddChunk();
+
+		std::vector<char *> Chunks;
+		std::size_t Block;
+		std::size_t BlocksPerChunk;
+		void *FreeList;
+		AllocatorStatistics Stats;
+	};
+
+	// STL adapters ===========================================
+
+	template <typename T>
+	class AlignedAllocator
+	{
+	public:
+		typedef T value_type;
+
+		template <typename U>
+		struct rebind { typedef AlignedAllocator<U> other; };
+
+		AlignedAllocator() { }
+		template <typename U>
+		AlignedAllocator(AlignedAllocator<U> const &) { }
+
+		T *allocate(std::size_t n)
+		{
+			return static_cast<T *>(AlignedAllocate(n * sizeof(T)));
+		}
+
+		void deallocate(T *p, std::size_t)
+		{
+			AlignedFree(p);
+		}
+	};
+
+	// Deallocation is a no-op; memory comes back when the Arena is reset.
+	template <typename T>
+	class ArenaAllocator
+	{
+	public:
+		typedef T value_type;
+
+		template <typename U>
+		struct rebind { typedef ArenaAllocator<U> other; };
+
+		ArenaAllocator(Arena &Source) : Source(&Source) { }
+		template <typename U>
+		ArenaAllocator(ArenaAllocator<U> const &b) : Source(b.Source) { }
+
+		T *allocate(std::size_t n)
+		{
+			return static_cast<T *>(Source->Allocate(n * sizeof(T)));
+		}
+
+		void deallocate(T *, std::size_t) { }
+
+		Arena *Source;
+	};
+
+	// Single-object requests that fit the pool's block size are served from the Pool.  Anything
+	// else (array allocations, oversized rebinds) falls back to the aligned heap.
+	template <typename T>
+	class PoolAllocator
+	{
+	public:
+		typedef T value_type;
+
+		template <typename U>
+		struct rebind { typedef PoolAllocator<U> other; };
+
+		PoolAllocator(Pool &Source) : Source(&Source) { }
+		template <typename U>
+		PoolAllocator(PoolAllocator<U> const &b) : Source(b.Source) { }
+
+		T *allocate(std::size_t n)
+		{
+			if (n == 1 && sizeof(T) <= Source->BlockSize())
+				return static_cast<T *>(Source->Allocate());
+
+			return static_cast<T *>(AlignedAllocate(n * sizeof(T)));
+		}
+
+		void deallocate(T *p, std::size_t n)
+		{
+			if (n == 1 && sizeof(T) <= Source->BlockSize())
+				Source->Free(p);
+			else
+				AlignedFree(p);
+		}
+
+		Pool *Source;
+	};
+
+	template <typename T, typename U>
+	inline bool operator==(AlignedAllocator<T> const &, AlignedAllocator<U> const &) { return true; }
+	template <typename T, typename U>
+	inline bool operator!=(AlignedAllocator<T> const &, AlignedAllocator<U> const &) { return false; }
+
+	template <typename T, typename U>
+	inline bool operator==(ArenaAllocator<T> const &a, ArenaAllocator<U> const &b) { return a.Source == b.Source; }
+	template <typename T, typename U>
+	inline bool operator!=(ArenaAllocator<T> const &a, ArenaAllocator<U> const &b) { return a.Source != b.Source; }
+
+	template <typename T, typename U>
+	inline bool operator==(PoolAllocator<T> const &a, PoolAllocator<U> const &b) { return a.Source == b.Source; }
+	template <typename T, typename U>
+	inline bool operator!=(PoolAllocator<T> const &a, PoolAllocator<U> const &b) { return a.Source != b.Source; }
+
+	// Containers =============================================
+
+	// Array is the default container for SmallMath types: heap backed, cache line aligned.
+	// FrameArray is the per-frame variant, backed by an Arena and only valid until its Reset().
+	template <typename T>
+	struct Array { typedef std::vector<T, AlignedAllocator<T> > Type; };
+
+	template <typename T>
+	struct FrameArray { typedef std::vector<T, ArenaAllocator<T> > Type; };
+
+	typedef Array<Vector2>::Type Vector2Array;
+	typedef Array<Vector3>::Type Vector3Array;
+	typedef Array<Vector4>::Type Vector4Array;
+	typedef Array<Matrix2>::Type Matrix2Array;
+	typedef Array<Matrix3>::Type Matrix3Array;
+	typedef Array<Matrix4>::Type Matrix4Array;
+	typedef Array<Quaternion>::Type QuaternionArray;
+	typedef Array<EulerAngles>::Type EulerAnglesArray;
+
+	// Inline methods =====================================
+
+	inline AllocatorStatistics const &Arena::Statistics() const
+	{
+		return Stats;
+	}
+
+	inline std::size_t Pool::BlockSize() const
+	{
+		return Block;
+	}
+
+	inline AllocatorStatistics const &Pool::Statistics() const
+	{
+		return Stats;
+	}
+}
+
+#endif
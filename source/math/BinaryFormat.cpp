@@ -0,0 +1,468 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "math/BinaryFormat.hpp"
+
+using namespace Math;
+
+namespace
+{
+	char const Magic[8] = {'S', 'M', 'A', 'T', 'H', 'B', 'I', 'N'};
+
+	std::size_t const HeaderSize = 64;
+	std::size_t const EntrySize = 64;
+	std::size_t const NameSize = 32;
+
+	// Header field offsets
+	std::size_t const VersionOffset = 8;
+	std::size_t const SectionCountOffset = 12;
+	std::size_t const TableOffsetOffset = 16;
+	std::size_t const TableChecksumOffset = 24;
+	std::size_t const HeaderChecksumOffset = 28;
+
+	// Section entry field offsets
+	std::size_t const TypeOffset = 32;
+	std::size_t const ElementSizeOffset = 36;
+	std::size_t const DataOffsetOffset = 40;
+	std::size_t const CountOffset = 48;
+	std::size_t const ChecksumOffset = 56;
+
+	struct CrcTable
+	{
+		CrcTable()
+		{
+			for (unsigned int n = 0; n < 256; n++)
+			{
+				unsigned int c = n;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+
+				Entries[n] = c;
+			}
+		}
+
+		unsigned int Entries[256];
+	};
+
+	CrcTable const Crc;
+
+	inline void Store32(unsigned char *Destination, unsigned int Value)
+	{
+		for (int Byte = 0; Byte < 4; Byte++)
+			Destination[Byte] = static_cast<unsigned char>(Value >> (8 * Byte));
+	}
+
+	inline void Store64(unsigned char *Destination, unsigned long long Value)
+	{
+		for (int Byte = 0; Byte < 8; Byte++)
+			Destination[Byte] = static_cast<unsigned char>(Value >> (8 * Byte));
+	}
+
+	inline unsigned int Load32(unsigned char const *Source)
+	{
+		unsigned int Value = 0;
+		for (int Byte = 3; Byte >= 0; Byte--)
+			Value = (Value << 8) | Source[Byte];
+
+		return Value;
+	}
+
+	inline unsigned long long Load64(unsigned char const *Source)
+	{
+		unsigned long long Value = 0;
+		for (int Byte = 7; Byte >= 0; Byte--)
+			Value = (Value << 8) | Source[Byte];
+
+		return Value;
+	}
+
+	inline std::size_t Padding(unsigned long long Position)
+	{
+		return static_cast<std::size_t>((BinaryFormat::Alignment - Position % BinaryFormat::Alignment) % BinaryFormat::Alignment);
+	}
+}
+
+unsigned int BinaryFormat::Checksum(void const *Data, std::size_t Size, unsigned int Previous)
+{
+	unsigned char const *Bytes = static_cast<unsigned char const *>(Data);
+	unsigned int c = Previous ^ 0xFFFFFFFFu;
+
+	for (std::size_t Index = 0; Index < Size; Index++)
+		c = Crc.Entries[(c ^ Bytes[Index]) & 0xFF] ^ (c >> 8);
+
+	return c ^ 0xFFFFFFFFu;
+}
+
+bool BinaryFormat::HostIsLittleEndian()
+{
+	unsigned int One = 1;
+	return (*reinterpret_cast<unsigned char *>(&One) == 1);
+}
+
+// BinaryWriter ===========================================
+
+BinaryWriter::BinaryWriter() :
+	File(NULL),
+	Position(0),
+	SectionOpen(false)
+{
+
+}
+
+BinaryWriter::~BinaryWriter()
+{
+	this->Close();
+}
+
+bool BinaryWriter::Open(char const *Path)
+{
+	this->Close();
+
+	File = std::fopen(Path, "wb");
+	if (File == NULL)
+		return false;
+
+	// The real header is written by Close() once the section table is known.
+	unsigned char Header[HeaderSize] = {0};
+	if (std::fwrite(Header, 1, HeaderSize, File) != HeaderSize)
+		return false;
+
+	Position = HeaderSize;
+	Sections.clear();
+	SectionOpen = false;
+	return true;
+}
+
+bool BinaryWriter::Close()
+{
+	if (File == NULL)
+		return true;
+
+	bool Success = true;
+
+	if (SectionOpen)
+		Success = this->EndSection();
+
+	// Section table
+	unsigned long long TableOffset = Position;
+	unsigned int TableChecksum = 0;
+
+	for (std::size_t Index = 0; Index < Sections.size() && Success; Index++)
+	{
+		SectionInfo const &s = Sections[Index];
+		unsigned char Entry[EntrySize] = {0};
+
+		std::memcpy(Entry, s.Name.c_str(), s.Name.size());
+		Store32(Entry + TypeOffset, s.Type);
+		Store32(Entry + ElementSizeOffset, s.ElementSize);
+		Store64(Entry + DataOffsetOffset, s.Offset);
+		Store64(Entry + CountOffset, s.Count);
+		Store32(Entry + ChecksumOffset, s.Checksum);
+
+		TableChecksum = BinaryFormat::Checksum(Entry, EntrySize, TableChecksum);
+		Success = (std::fwrite(Entry, 1, EntrySize, File) == EntrySize);
+	}
+
+	// Header
+	unsigned char Header[HeaderSize] = {0};
+	std::memcpy(Header, Magic, sizeof(Magic));
+	Store32(Header + VersionOffset, BinaryFormat::Version);
+	Store32(Header + SectionCountOffset, static_cast<unsigned int>(Sections.size()));
+	Store64(Header + TableOffsetOffset, TableOffset);
+	Store32(Header + TableChecksumOffset, TableChecksum);
+	Store32(Header + HeaderChecksumOffset, BinaryFormat::Checksum(Header, HeaderChecksumOffset));
+
+	if (Success)
+		Success = (std::fseek(File, 0, SEEK_SET) == 0 && std::fwrite(Header, 1, HeaderSize, File) == HeaderSize);
+
+	Success = (std::fclose(File) == 0) && Success;
+	File = NULL;
+	return Success;
+}
+
+bool BinaryWriter::EndSection()
+{
+	if (!SectionOpen)
+		return false;
+
+	SectionOpen = false;
+	return this->Pad();
+}
+
+bool BinaryWriter::BeginSection(char const *Name, BinaryFormat::SectionType Type, unsigned int ElementSize)
+{
+	if (File == NULL || std::strlen(Name) > BinaryFormat::MaxNameLength)
+		return false;
+
+	if (SectionOpen && !this->EndSection())
+		return false;
+
+	SectionInfo s;
+	s.Name = Name;
+	s.Type = Type;
+	s.ElementSize = ElementSize;
+	s.Offset = Position;
+	s.Count = 0;
+	s.Checksum = 0;
+
+	Sections.push_back(s);
+	SectionOpen = true;
+	return true;
+}
+
+bool BinaryWriter::WriteBytes(BinaryFormat::SectionType Type, void const *Data, std::size_t Size)
+{
+	if (!SectionOpen || Sections.back().Type != Type)
+		return false;
+
+	SectionInfo &s = Sections.back();
+	unsigned char const *Bytes = static_cast<unsigned char const *>(Data);
+
+	if (BinaryFormat::HostIsLittleEndian())
+	{
+		if (std::fwrite(Bytes, 1, Size, File) != Size)
+			return false;
+
+		s.Checksum = BinaryFormat::Checksum(Bytes, Size, s.Checksum);
+	}
+	else
+	{
+		// Every supported element is made of 4 byte scalars, so swapping words is enough.
+		unsigned char Buffer[4096];
+
+		for (std::size_t Start = 0; Start < Size; Start += sizeof(Buffer))
+		{
+			std::size_t Length = (Size - Start < sizeof(Buffer) ? Size - Start : sizeof(Buffer));
+
+			for (std::size_t Index = 0; Index < Length; Index += 4)
+			{
+				Buffer[Index + 0] = Bytes[Start + Index + 3];
+				Buffer[Index + 1] = Bytes[Start + Index + 2];
+				Buffer[Index + 2] = Bytes[Start + Index + 1];
+				Buffer[Index + 3] = Bytes[Start + Index + 0];
+			}
+
+			if (std::fwrite(Buffer, 1, Length, File) != Length)
+				return false;
+
+			s.Checksum = BinaryFormat::Checksum(Buffer, Length, s.Checksum);
+		}
+	}
+
+	s.Count += Size / s.ElementSize;
+	Position += Size;
+	return true;
+}
+
+bool BinaryWriter::Pad()
+{
+	unsigned char Zero[BinaryFormat::Alignment] = {0};
+	std::size_t Length = Padding(Position);
+
+	if (std::fwrite(Zero, 1, Length, File) != Length)
+		return false;
+
+	Position += Length;
+	return true;
+}
+
+// MappedBinaryFile =======================================
+
+MappedBinaryFile::MappedBinaryFile() :
+	Data(NULL),
+	Size(0),
+	Handle(NULL)
+{
+
+}
+
+MappedBinaryFile::~MappedBinaryFile()
+{
+	this->Close();
+}
+
+bool MappedBinaryFile::Open(char const *Path, bool VerifyChecksums)
+{
+	this->Close();
+
+	// The sections are used in place, which only works if the host agrees with the file.
+	if (!BinaryFormat::HostIsLittleEndian())
+		return false;
+
+#if defined(_WIN32)
+	HANDLE FileHandle = CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (FileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(FileHandle, &FileSize) || FileSize.QuadPart < static_cast<LONGLONG>(HeaderSize))
+	{
+		CloseHandle(FileHandle);
+		return false;
+	}
+
+	HANDLE Mapping = CreateFileMappingA(FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(FileHandle);
+	if (Mapping == NULL)
+		return false;
+
+	void *View = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+	if (View == NULL)
+	{
+		CloseHandle(Mapping);
+		return false;
+	}
+
+	Handle = Mapping;
+	Data = static_cast<char const *>(View);
+	Size = static_cast<std::size_t>(FileSize.QuadPart);
+#else
+	int Descriptor = ::open(Path, O_RDONLY);
+	if (Descriptor < 0)
+		return false;
+
+	struct stat Status;
+	if (::fstat(Descriptor, &Status) != 0 || Status.st_size < static_cast<off_t>(HeaderSize))
+	{
+		::close(Descriptor);
+		return false;
+	}
+
+	void *View = ::mmap(NULL, static_cast<std::size_t>(Status.st_size), PROT_READ, MAP_SHARED, Descriptor, 0);
+	::close(Descriptor);
+	if (View == MAP_FAILED)
+		return false;
+
+	Data = static_cast<char const *>(View);
+	Size = static_cast<std::size_t>(Status.st_size);
+#endif
+
+	if (!this->ReadTables() || (VerifyChecksums && !this->Verify()))
+	{
+		this->Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedBinaryFile::Close()
+{
+	if (Data == NULL)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(Data);
+	CloseHandle(static_cast<HANDLE>(Handle));
+#else
+	::munmap(const_cast<char *>(Data), Size);
+#endif
+
+	Data = NULL;
+	Size = 0;
+	Handle = NULL;
+	Sections.clear();
+}
+
+bool MappedBinaryFile::Verify() const
+{
+	for (std::size_t Index = 0; Index < Sections.size(); Index++)
+	{
+		SectionInfo const &s = Sections[Index];
+		std::size_t Bytes = static_cast<std::size_t>(s.Count * s.ElementSize);
+
+		if (BinaryFormat::Checksum(Data + s.Offset, Bytes) != s.Checksum)
+			return false;
+	}
+
+	return true;
+}
+
+int MappedBinaryFile::FindSection(char const *Name) const
+{
+	for (std::size_t Index = 0; Index < Sections.size(); Index++)
+	{
+		if (Sections[Index].Name == Name)
+			return static_cast<int>(Index);
+	}
+
+	return -1;
+}
+
+// Private ================================================
+
+bool MappedBinaryFile::ReadTables()
+{
+	unsigned char const *Header = reinterpret_cast<unsigned char const *>(Data);
+
+	if (std::memcmp(Header, Magic, sizeof(Magic)) != 0)
+		return false;
+
+	if (Load32(Header + HeaderChecksumOffset) != BinaryFormat::Checksum(Header, HeaderChecksumOffset))
+		return false;
+
+	if (Load32(Header + VersionOffset) > BinaryFormat::Version)
+		return false;
+
+	unsigned long long Count = Load32(Header + SectionCountOffset);
+	unsigned long long TableOffset = Load64(Header + TableOffsetOffset);
+
+	if (TableOffset > Size || Count > (Size - TableOffset) / EntrySize)
+		return false;
+
+	unsigned char const *Table = Header + TableOffset;
+	if (Load32(Header + TableChecksumOffset) != BinaryFormat::Checksum(Table, static_cast<std::size_t>(Count * EntrySize)))
+		return false;
+
+	Sections.resize(static_cast<std::size_t>(Count));
+
+	for (std::size_t Index = 0; Index < Sections.size(); Index++)
+	{
+		unsigned char const *Entry = Table + Index * EntrySize;
+		SectionInfo &s = Sections[Index];
+
+		char Name[NameSize];
+		std::memcpy(Name, Entry, NameSize);
+		Name[NameSize - 1] = '\0';
+
+		s.Name = Name;
+		s.Type = static_cast<BinaryFormat::SectionType>(Load32(Entry + TypeOffset));
+		s.ElementSize = Load32(Entry + ElementSizeOffset);
+		s.Offset = Load64(Entry + DataOffsetOffset);
+		s.Count = Load64(Entry + CountOffset);
+		s.Checksum = Load32(Entry + ChecksumOffset);
+
+		if (s.ElementSize == 0 || s.Offset % BinaryFormat::Alignment != 0 || s.Offset > TableOffset ||
+			s.Count > (TableOffset - s.Offset) / s.ElementSize)
+			return false;
+	}
+
+	return true;
+}
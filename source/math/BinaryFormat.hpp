@@ -0,0 +1,235 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_BINARYFORMAT
+#define SMALLMATH_BINARYFORMAT
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "math/EulerAngles.hpp"
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// File layout (all integers little-endian, every section starts on a 64 byte boundary):
+	//
+	//   FileHeader                      64 bytes
+	//   section data ...                each padded to 64 bytes
+	//   SectionEntry[SectionCount]      64 bytes each
+	//
+	// The section table is written last so that a writer can stream an unbounded number of
+	// elements without knowing the counts ahead of time.  Element data is the in-memory layout of
+	// the SmallMath classes, so a mapped section can be used directly as an array.
+
+	namespace BinaryFormat
+	{
+		static const unsigned int Version = 1;
+		static const std::size_t Alignment = 64;
+		static const std::size_t MaxNameLength = 31;
+
+		enum SectionType
+		{
+			Float = 1,
+			UInt32,
+			Vector2Type,
+			Vector3Type,
+			Vector4Type,
+			Matrix2Type,
+			Matrix3Type,
+			Matrix4Type,
+			QuaternionType,
+			EulerAnglesType
+		};
+
+		template <typename T> struct TypeOf;
+		template <> struct TypeOf<float> { static const SectionType Value = Float; };
+		template <> struct TypeOf<unsigned int> { static const SectionType Value = UInt32; };
+		template <> struct TypeOf<Vector2> { static const SectionType Value = Vector2Type; };
+		template <> struct TypeOf<Vector3> { static const SectionType Value = Vector3Type; };
+		template <> struct TypeOf<Vector4> { static const SectionType Value = Vector4Type; };
+		template <> struct TypeOf<Matrix2> { static const SectionType Value = Matrix2Type; };
+		template <> struct TypeOf<Matrix3> { static const SectionType Value = Matrix3Type; };
+		template <> struct TypeOf<Matrix4> { static const SectionType Value = Matrix4Type; };
+		template <> struct TypeOf<Quaternion> { static const SectionType Value = QuaternionType; };
+		template <> struct TypeOf<EulerAngles> { static const SectionType Value = EulerAnglesType; };
+
+		unsigned int Checksum(void const *Data, std::size_t Size, unsigned int Previous = 0);	// CRC-32
+		bool HostIsLittleEndian();
+	}
+
+	struct SectionInfo
+	{
+		std::string Name;
+		BinaryFormat::SectionType Type;
+		unsigned int ElementSize;
+		unsigned long long Offset;
+		unsigned long long Count;
+		unsigned int Checksum;
+	};
+
+	// Streams sections to disk.  Only one section can be open at a time; call Write() as many
+	// times as needed between BeginSection() and EndSection().
+	class BinaryWriter
+	{
+	public:
+		BinaryWriter();
+		~BinaryWriter();
+
+		bool Open(char const *Path);
+		bool Close();
+
+		template <typename T>
+		bool BeginSection(char const *Name);
+		template <typename T>
+		bool Write(T const *Data, std::size_t Count);
+		template <typename T>
+		bool Write(T const &Element);
+		bool EndSection();
+
+		template <typename T>
+		bool WriteSection(char const *Name, T const *Data, std::size_t Count);
+
+	private:
+		BinaryWriter(BinaryWriter const &);
+		BinaryWriter &operator=(BinaryWriter const &);
+
+		bool BeginSection(char const *Name, BinaryFormat::SectionType Type, unsigned int ElementSize);
+		bool WriteBytes(BinaryFormat::SectionType Type, void const *Data, std::size_t Size);
+		bool Pad();
+
+		std::FILE *File;
+		unsigned long long Position;
+		std::vector<SectionInfo> Sections;
+		bool SectionOpen;
+	};
+
+	// Maps a file written by BinaryWriter read-only into memory.  Section<T>() returns a pointer
+	// straight into the mapping, valid until Close() or destruction.
+	class MappedBinaryFile
+	{
+	public:
+		MappedBinaryFile();
+		~MappedBinaryFile();
+
+		bool Open(char const *Path, bool VerifyChecksums = true);
+		void Close();
+		bool Verify() const;		// Checks every section's checksum
+
+		inline bool IsOpen() const;
+		inline std::size_t SectionCount() const;
+		inline SectionInfo const &Section(std::size_t Index) const;
+		int FindSection(char const *Name) const;	// Returns -1 if missing
+
+		template <typename T>
+		T const *Section(std::size_t Index, std::size_t &Count) const;
+		template <typename T>
+		T const *Section(char const *Name, std::size_t &Count) const;
+
+	private:
+		MappedBinaryFile(MappedBinaryFile const &);
+		MappedBinaryFile &operator=(MappedBinaryFile const &);
+
+		bool ReadTables();
+
+		char const *Data;
+		std::size_t Size;
+		void *Handle;
+		std::vector<SectionInfo> Sections;
+	};
+
+	// BinaryWriter =======================================
+
+	template <typename T>
+	inline bool BinaryWriter::BeginSection(char const *Name)
+	{
+		return this->BeginSection(Name, BinaryFormat::TypeOf<T>::Value, sizeof(T));
+	}
+
+	template <typename T>
+	inline bool BinaryWriter::Write(T const *Data, std::size_t Count)
+	{
+		return this->WriteBytes(BinaryFormat::TypeOf<T>::Value, Data, Count * sizeof(T));
+	}
+
+	template <typename T>
+	inline bool BinaryWriter::Write(T const &Element)
+	{
+		return this->WriteBytes(BinaryFormat::TypeOf<T>::Value, &Element, sizeof(T));
+	}
+
+	template <typename T>
+	inline bool BinaryWriter::WriteSection(char const *Name, T const *Data, std::size_t Count)
+	{
+		return this->BeginSection<T>(Name) && this->Write(Data, Count) && this->EndSection();
+	}
+
+	// MappedBinaryFile ===================================
+
+	inline bool MappedBinaryFile::IsOpen() const
+	{
+		return (Data != NULL);
+	}
+
+	inline std::size_t MappedBinaryFile::SectionCount() const
+	{
+		return Sections.size();
+	}
+
+	inline SectionInfo const &MappedBinaryFile::Section(std::size_t Index) const
+	{
+		return Sections[Index];
+	}
+
+	template <typename T>
+	inline T const *MappedBinaryFile::Section(std::size_t Index, std::size_t &Count) const
+	{
+		Count = 0;
+
+		if (Index >= Sections.size())
+			return NULL;
+
+		SectionInfo const &s = Sections[Index];
+		if (s.Type != BinaryFormat::TypeOf<T>::Value || s.ElementSize != sizeof(T))
+			return NULL;
+
+		Count = static_cast<std::size_t>(s.Count);
+		return reinterpret_cast<T const *>(Data + s.Offset);
+	}
+
+	template <typename T>
+	inline T const *MappedBinaryFile::Section(char const *Name, std::size_t &Count) const
+	{
+		int Index = this->FindSection(Name);
+
+		if (Index < 0)
+		{
+			Count = 0;
+			return NULL;
+		}
+
+		return this->Section<T>(static_cast<std::size_t>(Index), Count);
+	}
+}
+
+#endif
@@ -0,0 +1,582 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "math/Bounds.hpp"
+#include "math/Decomposition.hpp"
+#include "math/FloatingPoint.hpp"
+#include "math/Parallel.hpp"
+
+using namespace Math;
+
+namespace
+{
+	int const CullWidth = 8;
+	int const FitWidth = 8;
+	std::size_t const FitGrain = 16384;		// Points per thread
+	std::size_t const ClusterGrain = 64;	// Clusters per thread
+
+	// Each lane of Inside is left at 1 if the sphere in that lane is on the inner side of every plane.
+	inline void CullSpheres(Frustum const &f, float const *x, float const *y, float const *z, float const *r, int *Inside)
+	{
+		for (int Lane = 0; Lane < CullWidth; Lane++)
+			Inside[Lane] = 1;
+
+		for (int Index = 0; Index < 6; Index++)
+		{
+			Plane const &p = f.Planes[Index];
+
+			for (int Lane = 0; Lane < CullWidth; Lane++)
+				Inside[Lane] &= (p.Normal.x * x[Lane] + p.Normal.y * y[Lane] + p.Normal.z * z[Lane] + p.Distance >= -r[Lane]);
+		}
+	}
+
+	// Same for boxes, testing the corner furthest along each plane's normal.  The corner is picked
+	// per plane rather than per lane, so the lane loop stays branch-free.
+	inline void CullBoxes(Frustum const &f, float const *const Min[3], float const *const Max[3], int *Inside)
+	{
+		for (int Lane = 0; Lane < CullWidth; Lane++)
+			Inside[Lane] = 1;
+
+		for (int Index = 0; Index < 6; Index++)
+		{
+			Plane const &p = f.Planes[Index];
+			float const *x = (p.Normal.x > 0.0f ? Max[0] : Min[0]);
+			float const *y = (p.Normal.y > 0.0f ? Max[1] : Min[1]);
+			float const *z = (p.Normal.z > 0.0f ? Max[2] : Min[2]);
+
+			for (int Lane = 0; Lane < CullWidth; Lane++)
+				Inside[Lane] &= (p.Normal.x * x[Lane] + p.Normal.y * y[Lane] + p.Normal.z * z[Lane] + p.Distance >= 0.0f);
+		}
+	}
+
+	// Appends the indices of the inside lanes.  Every lane is written, but the cursor only advances
+	// past the inside ones, which keeps this free of unpredictable branches.
+	inline std::size_t Compact(int const *Inside, int Lanes, std::size_t Base, unsigned int *Visible, std::size_t Count)
+	{
+		for (int Lane = 0; Lane < Lanes; Lane++)
+		{
+			Visible[Count] = static_cast<unsigned int>(Base + Lane);
+			Count += Inside[Lane];
+		}
+
+		return Count;
+	}
+
+	// Copies the last partial block into full-width lanes.
+	inline void Pad(float const *Source, std::size_t First, std::size_t Count, float *Lanes)
+	{
+		for (int Lane = 0; Lane < CullWidth; Lane++)
+			Lanes[Lane] = (First + Lane < Count ? Source[First + Lane] : 0.0f);
+	}
+
+	// Oriented boxes, one per lane.
+	template <int Width>
+	struct BoxLanes
+	{
+		void Set(int Lane, OBB const &b)
+		{
+			Matrix3 m = b.Axes();
+			Vector3 c = b.Center, e = b.HalfExtents;
+
+			Center[0][Lane] = c.x; Center[1][Lane] = c.y; Center[2][Lane] = c.z;
+			Half[0][Lane] = e.x; Half[1][Lane] = e.y; Half[2][Lane] = e.z;
+			for (int i = 0; i < 3; i++)
+			{
+				for (int k = 0; k < 3; k++)
+					Axis[i][k][Lane] = m.m[k][i];
+			}
+		}
+
+		// Entries past Count are padded with empty boxes at the origin.
+		void Load(OBBArrays const &b, std::size_t First)
+		{
+			Pad(b.CenterX, First, b.Count, Center[0]);
+			Pad(b.CenterY, First, b.Count, Center[1]);
+			Pad(b.CenterZ, First, b.Count, Center[2]);
+			Pad(b.HalfX, First, b.Count, Half[0]);
+			Pad(b.HalfY, First, b.Count, Half[1]);
+			Pad(b.HalfZ, First, b.Count, Half[2]);
+			for (int i = 0; i < 3; i++)
+			{
+				for (int k = 0; k < 3; k++)
+					Pad(b.Axis[i][k], First, b.Count, Axis[i][k]);
+			}
+		}
+
+		float Center[3][Width];
+		float Axis[3][3][Width];
+		float Half[3][Width];
+	};
+
+	float const SatEpsilon = 1.0e-6f;
+
+	template <int Width>
+	inline bool Any(int const *Inside)
+	{
+		int r = 0;
+		for (int Lane = 0; Lane < Width; Lane++)
+			r |= Inside[Lane];
+		return (r != 0);
+	}
+
+	// Leaves each lane of Inside at 1 if no axis separates the lane's boxes.
+	template <int Width>
+	void Separate(BoxLanes<Width> const &a, BoxLanes<Width> const &b, int *Inside)
+	{
+		// R[i][j] = a_i . b_j, and t is b's center in a's frame.
+		float R[3][3][Width], AbsR[3][3][Width], t[3][Width];
+
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			float d[3];
+			for (int k = 0; k < 3; k++)
+				d[k] = b.Center[k][Lane] - a.Center[k][Lane];
+
+			for (int i = 0; i < 3; i++)
+			{
+				t[i][Lane] = a.Axis[i][0][Lane] * d[0] + a.Axis[i][1][Lane] * d[1] + a.Axis[i][2][Lane] * d[2];
+				for (int j = 0; j < 3; j++)
+				{
+					R[i][j][Lane] = a.Axis[i][0][Lane] * b.Axis[j][0][Lane] + a.Axis[i][1][Lane] * b.Axis[j][1][Lane] + a.Axis[i][2][Lane] * b.Axis[j][2][Lane];
+					AbsR[i][j][Lane] = std::abs(R[i][j][Lane]) + SatEpsilon;
+				}
+			}
+		}
+
+		// a's face axes
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			int r = 1;
+			for (int i = 0; i < 3; i++)
+			{
+				float rb = b.Half[0][Lane] * AbsR[i][0][Lane] + b.Half[1][Lane] * AbsR[i][1][Lane] + b.Half[2][Lane] * AbsR[i][2][Lane];
+				r &= (std::abs(t[i][Lane]) <= a.Half[i][Lane] + rb);
+			}
+			Inside[Lane] = r;
+		}
+
+		if (!Any<Width>(Inside))
+			return;
+
+		// b's face axes
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			int r = 1;
+			for (int j = 0; j < 3; j++)
+			{
+				float ra = a.Half[0][Lane] * AbsR[0][j][Lane] + a.Half[1][Lane] * AbsR[1][j][Lane] + a.Half[2][Lane] * AbsR[2][j][Lane];
+				float tb = t[0][Lane] * R[0][j][Lane] + t[1][Lane] * R[1][j][Lane] + t[2][Lane] * R[2][j][Lane];
+				r &= (std::abs(tb) <= ra + b.Half[j][Lane]);
+			}
+			Inside[Lane] &= r;
+		}
+
+		if (!Any<Width>(Inside))
+			return;
+
+		// a_i x b_j
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			int r = 1;
+			for (int i = 0; i < 3; i++)
+			{
+				int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+				for (int j = 0; j < 3; j++)
+				{
+					int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+					float ra = a.Half[i1][Lane] * AbsR[i2][j][Lane] + a.Half[i2][Lane] * AbsR[i1][j][Lane];
+					float rb = b.Half[j1][Lane] * AbsR[i][j2][Lane] + b.Half[j2][Lane] * AbsR[i][j1][Lane];
+					float d = t[i2][Lane] * R[i1][j][Lane] - t[i1][Lane] * R[i2][j][Lane];
+					r &= (std::abs(d) <= ra + rb);
+				}
+			}
+			Inside[Lane] &= r;
+		}
+	}
+
+	// First and second moments of Points[Begin, End) - Shift.  Cross holds xx, xy, xz, yy, yz, zz.
+	struct Moments
+	{
+		Moments()
+		{
+			for (int i = 0; i < 3; i++)
+				Sum[i] = 0.0;
+			for (int i = 0; i < 6; i++)
+				Cross[i] = 0.0;
+		}
+
+		void Add(Moments const &b)
+		{
+			for (int i = 0; i < 3; i++)
+				Sum[i] += b.Sum[i];
+			for (int i = 0; i < 6; i++)
+				Cross[i] += b.Cross[i];
+		}
+
+		double Sum[3];
+		double Cross[6];
+	};
+
+	Moments Accumulate(Vector3 const *Points, std::size_t Begin, std::size_t End, Vector3 const &Shift)
+	{
+		double s[3][FitWidth], c[6][FitWidth];
+		for (int Lane = 0; Lane < FitWidth; Lane++)
+		{
+			for (int i = 0; i < 3; i++)
+				s[i][Lane] = 0.0;
+			for (int i = 0; i < 6; i++)
+				c[i][Lane] = 0.0;
+		}
+
+		std::size_t Index = Begin;
+		for (; Index + FitWidth <= End; Index += FitWidth)
+		{
+			for (int Lane = 0; Lane < FitWidth; Lane++)
+			{
+				Vector3 const &p = Points[Index + Lane];
+				double x = p.x - Shift.x, y = p.y - Shift.y, z = p.z - Shift.z;
+
+				s[0][Lane] += x; s[1][Lane] += y; s[2][Lane] += z;
+				c[0][Lane] += x * x; c[1][Lane] += x * y; c[2][Lane] += x * z;
+				c[3][Lane] += y * y; c[4][Lane] += y * z; c[5][Lane] += z * z;
+			}
+		}
+
+		for (int Lane = 0; Index < End; Index++, Lane++)
+		{
+			Vector3 const &p = Points[Index];
+			double x = p.x - Shift.x, y = p.y - Shift.y, z = p.z - Shift.z;
+
+			s[0][Lane] += x; s[1][Lane] += y; s[2][Lane] += z;
+			c[0][Lane] += x * x; c[1][Lane] += x * y; c[2][Lane] += x * z;
+			c[3][Lane] += y * y; c[4][Lane] += y * z; c[5][Lane] += z * z;
+		}
+
+		Moments r;
+		for (int Lane = 0; Lane < FitWidth; Lane++)
+		{
+			for (int i = 0; i < 3; i++)
+				r.Sum[i] += s[i][Lane];
+			for (int i = 0; i < 6; i++)
+				r.Cross[i] += c[i][Lane];
+		}
+
+		return r;
+	}
+
+	// Range of (Points[Begin, End) - Shift) . Axes[i] for each i.
+	struct Range
+	{
+		Range()
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				Min[i] = std::numeric_limits<float>::max();
+				Max[i] = -std::numeric_limits<float>::max();
+			}
+		}
+
+		void Add(Range const &b)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				Min[i] = std::min(Min[i], b.Min[i]);
+				Max[i] = std::max(Max[i], b.Max[i]);
+			}
+		}
+
+		float Min[3], Max[3];
+	};
+
+	Range Project(Vector3 const *Points, std::size_t Begin, std::size_t End, Vector3 const &Shift, Vector3 const (&Axes)[3])
+	{
+		float Min[3][FitWidth], Max[3][FitWidth];
+		for (int i = 0; i < 3; i++)
+		{
+			for (int Lane = 0; Lane < FitWidth; Lane++)
+			{
+				Min[i][Lane] = std::numeric_limits<float>::max();
+				Max[i][Lane] = -std::numeric_limits<float>::max();
+			}
+		}
+
+		// Lanes past the end repeat the last point, which changes nothing.
+		for (std::size_t Index = Begin; Index < End; Index += FitWidth)
+		{
+			for (int Lane = 0; Lane < FitWidth; Lane++)
+			{
+				Vector3 const &p = Points[std::min(Index + Lane, End - 1)];
+				float x = p.x - Shift.x, y = p.y - Shift.y, z = p.z - Shift.z;
+
+				for (int i = 0; i < 3; i++)
+				{
+					float d = Axes[i].x * x + Axes[i].y * y + Axes[i].z * z;
+					Min[i][Lane] = std::min(Min[i][Lane], d);
+					Max[i][Lane] = std::max(Max[i][Lane], d);
+				}
+			}
+		}
+
+		Range r;
+		for (int i = 0; i < 3; i++)
+		{
+			for (int Lane = 0; Lane < FitWidth; Lane++)
+			{
+				r.Min[i] = std::min(r.Min[i], Min[i][Lane]);
+				r.Max[i] = std::max(r.Max[i], Max[i][Lane]);
+			}
+		}
+
+		return r;
+	}
+
+	OBB Fit(Vector3 const *Points, std::size_t Count, std::size_t Chunks)
+	{
+		if (Count == 0)
+			return OBB();
+
+		Vector3 Shift = Points[0];
+		Moments m;
+
+		if (Chunks <= 1)
+			m = Accumulate(Points, 0, Count, Shift);
+		else
+		{
+			std::vector<Moments> Partial(Chunks);
+			Parallel::For(Chunks, 1, [&](std::size_t Begin, std::size_t End)
+			{
+				for (std::size_t Chunk = Begin; Chunk < End; Chunk++)
+					Partial[Chunk] = Accumulate(Points, Count * Chunk / Chunks, Count * (Chunk + 1) / Chunks, Shift);
+			});
+
+			for (std::size_t Chunk = 0; Chunk < Chunks; Chunk++)
+				m.Add(Partial[Chunk]);
+		}
+
+		double n = double(Count);
+		double Mean[3] = {m.Sum[0] / n, m.Sum[1] / n, m.Sum[2] / n};
+		double Covariance[3][3];
+		int const Pair[3][3] = {{0, 1, 2}, {1, 3, 4}, {2, 4, 5}};
+
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+				Covariance[i][j] = m.Cross[Pair[i][j]] / n - Mean[i] * Mean[j];
+		}
+
+		double Values[3], Vectors[3][3];
+		SymmetricEigen(Covariance, Values, Vectors);
+
+		// Make the frame right-handed, then read the axes back from the quaternion so the extents
+		// are measured along exactly the orientation that is returned.
+		Vector3 u(static_cast<float>(Vectors[0][0]), static_cast<float>(Vectors[1][0]), static_cast<float>(Vectors[2][0]));
+		Vector3 v(static_cast<float>(Vectors[0][1]), static_cast<float>(Vectors[1][1]), static_cast<float>(Vectors[2][1]));
+		Matrix3 Frame;
+		Frame.SetColumn(0, u);
+		Frame.SetColumn(1, v);
+		Frame.SetColumn(2, u.Cross(v));
+
+		OBB r;
+		r.Orientation = Quaternion(Frame).Normalized();
+		Frame = Matrix3(r.Orientation);
+		Vector3 Axes[3] = {Frame.GetColumn(0), Frame.GetColumn(1), Frame.GetColumn(2)};
+
+		Range Extent;
+		if (Chunks <= 1)
+			Extent = Project(Points, 0, Count, Shift, Axes);
+		else
+		{
+			std::vector<Range> Partial(Chunks);
+			Parallel::For(Chunks, 1, [&](std::size_t Begin, std::size_t End)
+			{
+				for (std::size_t Chunk = Begin; Chunk < End; Chunk++)
+					Partial[Chunk] = Project(Points, Count * Chunk / Chunks, Count * (Chunk + 1) / Chunks, Shift, Axes);
+			});
+
+			for (std::size_t Chunk = 0; Chunk < Chunks; Chunk++)
+				Extent.Add(Partial[Chunk]);
+		}
+
+		Vector3 Middle(0.5f * (Extent.Min[0] + Extent.Max[0]), 0.5f * (Extent.Min[1] + Extent.Max[1]), 0.5f * (Extent.Min[2] + Extent.Max[2]));
+		r.Center = Shift + Frame * Middle;
+		r.HalfExtents = Vector3(0.5f * (Extent.Max[0] - Extent.Min[0]), 0.5f * (Extent.Max[1] - Extent.Min[1]), 0.5f * (Extent.Max[2] - Extent.Min[2]));
+		return r;
+	}
+}
+
+Frustum::Frustum(Matrix4 const &ViewProjection, ClipDepth Depth)
+{
+	Vector4 r0 = ViewProjection.GetRow(0);
+	Vector4 r1 = ViewProjection.GetRow(1);
+	Vector4 r2 = ViewProjection.GetRow(2);
+	Vector4 r3 = ViewProjection.GetRow(3);
+
+	Planes[Left] = Plane(r3 + r0);
+	Planes[Right] = Plane(r3 - r0);
+	Planes[Bottom] = Plane(r3 + r1);
+	Planes[Top] = Plane(r3 - r1);
+	if (Depth == ReversedZeroToOne)
+	{
+		Planes[Near] = Plane(r3 - r2);
+		Planes[Far] = Plane(r2);
+	}
+	else
+	{
+		Planes[Near] = Plane(Depth == ZeroToOne ? r2 : r3 + r2);
+		Planes[Far] = Plane(r3 - r2);
+	}
+
+	for (int Index = 0; Index < 6; Index++)
+		Planes[Index].Normalize();
+}
+
+std::size_t Math::Cull(Frustum const &f, SphereArrays const &Objects, unsigned int *Visible)
+{
+	std::size_t Count = 0;
+	std::size_t First = 0;
+	int Inside[CullWidth];
+
+	for (; First + CullWidth <= Objects.Count; First += CullWidth)
+	{
+		CullSpheres(f, Objects.x + First, Objects.y + First, Objects.z + First, Objects.Radius + First, Inside);
+		Count = Compact(Inside, CullWidth, First, Visible, Count);
+	}
+
+	if (First < Objects.Count)
+	{
+		float x[CullWidth], y[CullWidth], z[CullWidth], r[CullWidth];
+		Pad(Objects.x, First, Objects.Count, x);
+		Pad(Objects.y, First, Objects.Count, y);
+		Pad(Objects.z, First, Objects.Count, z);
+		Pad(Objects.Radius, First, Objects.Count, r);
+
+		CullSpheres(f, x, y, z, r, Inside);
+		Count = Compact(Inside, static_cast<int>(Objects.Count - First), First, Visible, Count);
+	}
+
+	return Count;
+}
+
+std::size_t Math::Cull(Frustum const &f, AABBArrays const &Objects, unsigned int *Visible)
+{
+	std::size_t Count = 0;
+	std::size_t First = 0;
+	int Inside[CullWidth];
+
+	for (; First + CullWidth <= Objects.Count; First += CullWidth)
+	{
+		float const *Min[3] = {Objects.MinX + First, Objects.MinY + First, Objects.MinZ + First};
+		float const *Max[3] = {Objects.MaxX + First, Objects.MaxY + First, Objects.MaxZ + First};
+
+		CullBoxes(f, Min, Max, Inside);
+		Count = Compact(Inside, CullWidth, First, Visible, Count);
+	}
+
+	if (First < Objects.Count)
+	{
+		float Lanes[6][CullWidth];
+		Pad(Objects.MinX, First, Objects.Count, Lanes[0]);
+		Pad(Objects.MinY, First, Objects.Count, Lanes[1]);
+		Pad(Objects.MinZ, First, Objects.Count, Lanes[2]);
+		Pad(Objects.MaxX, First, Objects.Count, Lanes[3]);
+		Pad(Objects.MaxY, First, Objects.Count, Lanes[4]);
+		Pad(Objects.MaxZ, First, Objects.Count, Lanes[5]);
+
+		float const *Min[3] = {Lanes[0], Lanes[1], Lanes[2]};
+		float const *Max[3] = {Lanes[3], Lanes[4], Lanes[5]};
+
+		CullBoxes(f, Min, Max, Inside);
+		Count = Compact(Inside, static_cast<int>(Objects.Count - First), First, Visible, Count);
+	}
+
+	return Count;
+}
+
+bool OBB::Overlaps(OBB const &b) const
+{
+	BoxLanes<1> x, y;
+	x.Set(0, *this);
+	y.Set(0, b);
+
+	int Inside;
+	Separate(x, y, &Inside);
+	return (Inside != 0);
+}
+
+std::size_t Math::Overlaps(OBB const &Box, OBBArrays const &Boxes, unsigned int *Hits)
+{
+	BoxLanes<CullWidth> a, b;
+	for (int Lane = 0; Lane < CullWidth; Lane++)
+		a.Set(Lane, Box);
+
+	std::size_t Count = 0;
+	int Inside[CullWidth];
+
+	for (std::size_t First = 0; First < Boxes.Count; First += CullWidth)
+	{
+		b.Load(Boxes, First);
+		Separate(a, b, Inside);
+		Count = Compact(Inside, static_cast<int>(std::min<std::size_t>(CullWidth, Boxes.Count - First)), First, Hits, Count);
+	}
+
+	return Count;
+}
+
+std::size_t Math::Overlaps(OBBArrays const &a, OBBArrays const &b, unsigned int *Hits)
+{
+	BoxLanes<CullWidth> x, y;
+	std::size_t Count = 0;
+	int Inside[CullWidth];
+
+	for (std::size_t First = 0; First < a.Count; First += CullWidth)
+	{
+		x.Load(a, First);
+		y.Load(b, First);
+		Separate(x, y, Inside);
+		Count = Compact(Inside, static_cast<int>(std::min<std::size_t>(CullWidth, a.Count - First)), First, Hits, Count);
+	}
+
+	return Count;
+}
+
+OBB Math::FitOBB(Vector3 const *Points, std::size_t Count)
+{
+	std::size_t Chunks = (Count + FitGrain - 1) / FitGrain;
+	if (Chunks > Parallel::ThreadCount())
+		Chunks = Parallel::ThreadCount();
+
+	return Fit(Points, Count, Chunks);
+}
+
+void Math::FitOBB(Vector3 const *Points, unsigned int const *Offsets, std::size_t SetCount, OBB *Results)
+{
+	Parallel::For(SetCount, ClusterGrain, [&](std::size_t Begin, std::size_t End)
+	{
+		for (std::size_t Set = Begin; Set < End; Set++)
+			Results[Set] = Fit(Points + Offsets[Set], Offsets[Set + 1] - Offsets[Set], 1);
+	});
+
+	static_assert(sizeof(OBB) == 10 * sizeof(float), "OBB is checked as plain floats");
+	CheckOutput("FitOBB", reinterpret_cast<float const *>(Results), SetCount, 10);
+}
@@ -0,0 +1,349 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_BOUNDS
+#define SMALLMATH_BOUNDS
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	class AABB
+	{
+	public:
+		// The default box is empty: extending it by anything yields that thing's bounds.
+		AABB() : Min(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()),
+				 Max(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()) { }
+		AABB(Vector3 const &Min, Vector3 const &Max) : Min(Min), Max(Max) { }
+
+		// General operations
+		inline void Extend(Vector3 const &b);
+		inline void Extend(AABB const &b);
+		inline Vector3 Center() const;
+		inline Vector3 Extent() const;		// Max - Min
+		inline float SurfaceArea() const;
+		inline bool IsEmpty() const;
+		inline bool Contains(Vector3 const &b) const;
+		inline bool Overlaps(AABB const &b) const;
+		inline Vector3 ClosestPoint(Vector3 const &b) const;
+		inline float DistanceSquared(Vector3 const &b) const;
+
+		Vector3 Min, Max;
+	};
+
+	class Sphere
+	{
+	public:
+		Sphere() : Radius(0.0f) { }
+		Sphere(Vector3 const &Center, float Radius) : Center(Center), Radius(Radius) { }
+
+		// General operations
+		inline bool Contains(Vector3 const &b) const;
+		inline bool Overlaps(Sphere const &b) const;
+		inline bool Overlaps(AABB const &b) const;
+
+		Vector3 Center;
+		float Radius;
+	};
+
+	// A box with its own frame: the local axes are the columns of Matrix3(Orientation), and the box
+	// spans Center +/- HalfExtents along them.
+	class OBB
+	{
+	public:
+		OBB() { }
+		OBB(Vector3 const &Center, Quaternion const &Orientation, Vector3 const &HalfExtents) :
+			Center(Center), Orientation(Orientation), HalfExtents(HalfExtents) { }
+		OBB(Vector3 const &Center, Matrix3 const &Rotation, Vector3 const &HalfExtents) :
+			Center(Center), Orientation(Rotation), HalfExtents(HalfExtents) { }
+
+		// General operations
+		inline Matrix3 Axes() const;		// Columns are the box axes
+		inline float Volume() const;
+		bool Overlaps(OBB const &b) const;	// Separating axis test, see the batched forms below
+
+		Vector3 Center;
+		Quaternion Orientation;
+		Vector3 HalfExtents;
+	};
+
+	// The points p with Normal.Dot(p) + Distance == 0.  SignedDistance() is positive on the side
+	// Normal points to, and is a true distance only once the plane is normalized.
+	class Plane
+	{
+	public:
+		Plane() : Normal(0.0f, 0.0f, 1.0f), Distance(0.0f) { }
+		Plane(Vector3 const &Normal, float Distance) : Normal(Normal), Distance(Distance) { }
+		Plane(Vector3 const &Normal, Vector3 const &Point) : Normal(Normal), Distance(-Normal.Dot(Point)) { }
+		Plane(Vector4 const &Vec) : Normal(Vec.x, Vec.y, Vec.z), Distance(Vec.w) { }
+
+		// General operations
+		inline float SignedDistance(Vector3 const &b) const;
+		inline void Normalize();
+		inline Plane Normalized() const;
+
+		Vector3 Normal;
+		float Distance;
+	};
+
+	// Six inward-facing planes.  Built from a view-projection matrix (Gribb/Hartmann), so the
+	// planes are in whatever space the matrix transforms from: pass Projection * View for world
+	// space, or Projection * View * Model for object space.
+	class Frustum
+	{
+	public:
+		enum PlaneIndex {Left, Right, Bottom, Top, Near, Far};
+		// OpenGL, Direct3D/Vulkan, and reverse-Z (near at 1, far at 0) clip space depth
+		enum ClipDepth {NegativeOneToOne, ZeroToOne, ReversedZeroToOne};
+
+		Frustum() { }
+		Frustum(Matrix4 const &ViewProjection, ClipDepth Depth = NegativeOneToOne);
+
+		// General operations
+		inline bool Contains(Vector3 const &b) const;
+		inline bool Overlaps(Sphere const &b) const;
+		inline bool Overlaps(AABB const &b) const;	// Conservative: may accept boxes near the corners
+
+		Plane Planes[6];
+	};
+
+	// Structure-of-arrays views ==========================
+
+	struct SphereArrays
+	{
+		float const *x, *y, *z;
+		float const *Radius;
+		std::size_t Count;
+	};
+
+	struct AABBArrays
+	{
+		float const *MinX, *MinY, *MinZ;
+		float const *MaxX, *MaxY, *MaxZ;
+		std::size_t Count;
+	};
+
+	// Box axes are given as Axis[i][k], component k of axis i, i.e. Axes().m[k][i].
+	struct OBBArrays
+	{
+		float const *CenterX, *CenterY, *CenterZ;
+		float const *Axis[3][3];
+		float const *HalfX, *HalfY, *HalfZ;
+		std::size_t Count;
+	};
+
+	// Culling ============================================
+
+	// Writes the indices of the objects that overlap the frustum to Visible, in increasing order,
+	// and returns how many there are.  Visible must have room for Objects.Count entries.  Objects are
+	// processed eight at a time; the box test is the same conservative one as Frustum::Overlaps().
+	std::size_t Cull(Frustum const &f, SphereArrays const &Objects, unsigned int *Visible);
+	std::size_t Cull(Frustum const &f, AABBArrays const &Objects, unsigned int *Visible);
+
+	// Oriented box overlap ===============================
+
+	// Separating axis tests over the 15 candidate axes (Gottschalk et al.).  The second box is taken
+	// into the first one's frame once, and every axis test reads the projections it needs from that
+	// relative rotation and its absolute value instead of forming the cross products; a small
+	// epsilon on the absolute value keeps near-parallel edge axes from reporting false separations.
+	// Boxes are processed eight at a time, and a block stops after the face axes of either box once
+	// every lane is separated.  Both forms write the indices of the overlapping entries to Hits, in
+	// increasing order, and return how many there are.  Hits must have room for Boxes.Count (or
+	// a.Count) entries.
+	std::size_t Overlaps(OBB const &Box, OBBArrays const &Boxes, unsigned int *Hits);
+	std::size_t Overlaps(OBBArrays const &a, OBBArrays const &b, unsigned int *Hits);	// a[i] against b[i]
+
+	// Fitting ============================================
+
+	// Principal component fit: the box axes are the eigenvectors of the points' covariance, and the
+	// extents are the points' range along them.  The mean and covariance come from one pass over
+	// the points (summed in double relative to the first point, which keeps the shortcut formula
+	// well conditioned) and the extents from a second; both keep eight independent lane
+	// accumulators and are split across threads for large inputs.  Degenerate inputs give flat or
+	// zero-sized boxes; no points give the default box.
+	OBB FitOBB(Vector3 const *Points, std::size_t Count);
+
+	// Many small clusters.  Cluster n is Points[Offsets[n], Offsets[n + 1]), so Offsets has
+	// SetCount + 1 entries.  Clusters are fitted serially, several per thread.
+	void FitOBB(Vector3 const *Points, unsigned int const *Offsets, std::size_t SetCount, OBB *Results);
+
+	// General operations =================================
+
+	inline void AABB::Extend(Vector3 const &b)
+	{
+		Min = Vector3(std::min(Min.x, b.x), std::min(Min.y, b.y), std::min(Min.z, b.z));
+		Max = Vector3(std::max(Max.x, b.x), std::max(Max.y, b.y), std::max(Max.z, b.z));
+	}
+
+	inline void AABB::Extend(AABB const &b)
+	{
+		Min = Vector3(std::min(Min.x, b.Min.x), std::min(Min.y, b.Min.y), std::min(Min.z, b.Min.z));
+		Max = Vector3(std::max(Max.x, b.Max.x), std::max(Max.y, b.Max.y), std::max(Max.z, b.Max.z));
+	}
+
+	inline Vector3 AABB::Center() const
+	{
+		return (Min + Max) * 0.5f;
+	}
+
+	inline Vector3 AABB::Extent() const
+	{
+		return Max - Min;
+	}
+
+	inline float AABB::SurfaceArea() const
+	{
+		if (this->IsEmpty())
+			return 0.0f;
+
+		Vector3 e = this->Extent();
+		return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+	}
+
+	inline bool AABB::IsEmpty() const
+	{
+		return (Min.x > Max.x || Min.y > Max.y || Min.z > Max.z);
+	}
+
+	inline bool AABB::Contains(Vector3 const &b) const
+	{
+		return (b.x >= Min.x && b.x <= Max.x &&
+				b.y >= Min.y && b.y <= Max.y &&
+				b.z >= Min.z && b.z <= Max.z);
+	}
+
+	inline bool AABB::Overlaps(AABB const &b) const
+	{
+		return (Min.x <= b.Max.x && Max.x >= b.Min.x &&
+				Min.y <= b.Max.y && Max.y >= b.Min.y &&
+				Min.z <= b.Max.z && Max.z >= b.Min.z);
+	}
+
+	inline Vector3 AABB::ClosestPoint(Vector3 const &b) const
+	{
+		return Vector3(std::min(std::max(b.x, Min.x), Max.x),
+					   std::min(std::max(b.y, Min.y), Max.y),
+					   std::min(std::max(b.z, Min.z), Max.z));
+	}
+
+	inline float AABB::DistanceSquared(Vector3 const &b) const
+	{
+		return (this->ClosestPoint(b) - b).LengthSquared();
+	}
+
+	inline bool Sphere::Contains(Vector3 const &b) const
+	{
+		return ((b - Center).LengthSquared() <= Radius * Radius);
+	}
+
+	inline bool Sphere::Overlaps(Sphere const &b) const
+	{
+		float r = Radius + b.Radius;
+		return ((b.Center - Center).LengthSquared() <= r * r);
+	}
+
+	inline bool Sphere::Overlaps(AABB const &b) const
+	{
+		return (b.DistanceSquared(Center) <= Radius * Radius);
+	}
+
+	inline Matrix3 OBB::Axes() const
+	{
+		return Matrix3(Orientation);
+	}
+
+	inline float OBB::Volume() const
+	{
+		return 8.0f * HalfExtents.x * HalfExtents.y * HalfExtents.z;
+	}
+
+	inline float Plane::SignedDistance(Vector3 const &b) const
+	{
+		return Normal.Dot(b) + Distance;
+	}
+
+	inline void Plane::Normalize()
+	{
+		float l = Normal.Length();
+
+		// A degenerate plane (the far plane of an infinite projection) accepts everything.
+		if (l == 0.0f)
+		{
+			Distance = std::numeric_limits<float>::max();
+			return;
+		}
+
+		Normal /= l;
+		Distance /= l;
+	}
+
+	inline Plane Plane::Normalized() const
+	{
+		Plane r(*this);
+		r.Normalize();
+		return r;
+	}
+
+	inline bool Frustum::Contains(Vector3 const &b) const
+	{
+		for (int Index = 0; Index < 6; Index++)
+		{
+			if (Planes[Index].SignedDistance(b) < 0.0f)
+				return false;
+		}
+
+		return true;
+	}
+
+	inline bool Frustum::Overlaps(Sphere const &b) const
+	{
+		for (int Index = 0; Index < 6; Index++)
+		{
+			if (Planes[Index].SignedDistance(b.Center) < -b.Radius)
+				return false;
+		}
+
+		return true;
+	}
+
+	inline bool Frustum::Overlaps(AABB const &b) const
+	{
+		// Test the corner furthest along each plane's normal.
+		for (int Index = 0; Index < 6; Index++)
+		{
+			Vector3 const &n = Planes[Index].Normal;
+			Vector3 p(n.x > 0.0f ? b.Max.x : b.Min.x,
+					  n.y > 0.0f ? b.Max.y : b.Min.y,
+					  n.z > 0.0f ? b.Max.z : b.Min.z);
+
+			if (Planes[Index].SignedDistance(p) < 0.0f)
+				return false;
+		}
+
+		return true;
+	}
+}
+
+#endif
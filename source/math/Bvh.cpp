@@ -0,0 +1,738 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "math/Bvh.hpp"
+#include "math/Parallel.hpp"
+
+using namespace Math;
+
+namespace
+{
+	int const BinCount = 16;
+	int const MaxDepth = 48;						// Binary depth; bounds the traversal stack below
+	int const StackSize = 3 * MaxDepth + 1;
+	unsigned int const ParallelThreshold = 4096;	// Smaller subtrees are built on the current thread
+	std::size_t const ParallelGrain = 16384;
+	int const ParallelBinDepth = 2;					// Below this, enough subtrees run at once to fill the threads
+	float const TraversalCost = 1.0f;				// Relative to one primitive test
+
+	struct BuildNode
+	{
+		AABB Bounds;
+		unsigned int Left, Right;
+		unsigned int First, Count;	// Count > 0 marks a leaf
+	};
+
+	struct Bin
+	{
+		AABB Bounds;
+		unsigned int Count;
+	};
+
+	class Builder
+	{
+	public:
+		Builder(AABB const *Boxes, std::size_t Count, unsigned int *Indices) :
+			Boxes(Boxes),
+			Indices(Indices),
+			Centroids(Count),
+			Nodes(Count > 0 ? 2 * Count - 1 : 0),
+			Used(1),
+			SpawnDepth(0)
+		{
+			// Fork subtrees until there is roughly one per thread.
+			while ((1u << SpawnDepth) < Parallel::ThreadCount())
+				SpawnDepth++;
+
+			Parallel::For(Count, ParallelGrain, [this](std::size_t Begin, std::size_t End)
+			{
+				for (std::size_t Index = Begin; Index < End; Index++)
+					Centroids[Index] = this->Boxes[Index].Center();
+			});
+		}
+
+		void Build(unsigned int NodeIndex, unsigned int First, unsigned int Count, int Depth)
+		{
+			BuildNode &n = Nodes[NodeIndex];
+
+			AABB CentroidBounds;
+			this->Bounds(First, Count, Depth, n.Bounds, CentroidBounds);
+
+			n.First = First;
+			n.Count = Count;
+
+			if (Count == 1 || Depth >= MaxDepth)
+				return;
+
+			Vector3 e = CentroidBounds.Extent();
+			int Axis = (e.x > e.y ? (e.x > e.z ? 0 : 2) : (e.y > e.z ? 1 : 2));
+			unsigned int Split = 0;
+
+			if (e[Axis] > 0.0f)
+			{
+				Bin Bins[BinCount];
+				this->Fill(First, Count, Depth, Axis, CentroidBounds, Bins);
+
+				// Sweep from the right to get suffix areas, then from the left to evaluate each plane.
+				float RightArea[BinCount];
+				AABB Right;
+				for (int b = BinCount - 1; b > 0; b--)
+				{
+					Right.Extend(Bins[b].Bounds);
+					RightArea[b] = Right.SurfaceArea();
+				}
+
+				float BestCost = std::numeric_limits<float>::max();
+				int BestBin = -1;
+				AABB Left;
+				unsigned int LeftCount = 0;
+
+				for (int b = 0; b < BinCount - 1; b++)
+				{
+					Left.Extend(Bins[b].Bounds);
+					LeftCount += Bins[b].Count;
+
+					unsigned int RightCount = Count - LeftCount;
+					if (LeftCount == 0 || RightCount == 0)
+						continue;
+
+					float Cost = Left.SurfaceArea() * LeftCount + RightArea[b + 1] * RightCount;
+					if (Cost < BestCost)
+					{
+						BestCost = Cost;
+						BestBin = b;
+					}
+				}
+
+				float Area = n.Bounds.SurfaceArea();
+				float SplitCost = TraversalCost + (Area > 0.0f ? BestCost / Area : 0.0f);
+
+				if (Count <= Bvh::MaxLeafSize && (BestBin < 0 || SplitCost >= static_cast<float>(Count)))
+					return;
+
+				if (BestBin >= 0)
+				{
+					float Origin = CentroidBounds.Min[Axis];
+					float Scale = BinCount / e[Axis];
+					unsigned int *Middle = std::partition(Indices + First, Indices + First + Count, [&](unsigned int i)
+					{
+						return (this->BinIndex(Centroids[i][Axis], Origin, Scale) <= BestBin);
+					});
+
+					Split = static_cast<unsigned int>(Middle - (Indices + First));
+				}
+			}
+			else if (Count <= Bvh::MaxLeafSize)
+				return;
+
+			// Coincident centroids, or every candidate plane left a side empty: split the range in half.
+			if (Split == 0 || Split == Count)
+				Split = Count / 2;
+
+			unsigned int Children = Used.fetch_add(2);
+			n.Left = Children;
+			n.Right = Children + 1;
+			n.Count = 0;
+
+			if (Count > ParallelThreshold && Depth < SpawnDepth)
+			{
+				Parallel::Invoke([=]() { this->Build(Children, First, Split, Depth + 1); },
+								 [=]() { this->Build(Children + 1, First + Split, Count - Split, Depth + 1); });
+			}
+			else
+			{
+				this->Build(Children, First, Split, Depth + 1);
+				this->Build(Children + 1, First + Split, Count - Split, Depth + 1);
+			}
+		}
+
+		std::vector<BuildNode> const &Result() const
+		{
+			return Nodes;
+		}
+
+	private:
+		static int BinIndex(float Centroid, float Origin, float Scale)
+		{
+			int b = static_cast<int>((Centroid - Origin) * Scale);
+			return (b < 0 ? 0 : (b >= BinCount ? BinCount - 1 : b));
+		}
+
+		void Bounds(unsigned int First, unsigned int Count, int Depth, AABB &Box, AABB &CentroidBox) const
+		{
+			std::size_t Chunks = (Count > ParallelGrain && Depth < ParallelBinDepth ? Parallel::ThreadCount() : 1);
+
+			if (Chunks == 1)
+			{
+				for (unsigned int Index = First; Index < First + Count; Index++)
+				{
+					Box.Extend(Boxes[Indices[Index]]);
+					CentroidBox.Extend(Centroids[Indices[Index]]);
+				}
+
+				return;
+			}
+
+			std::vector<AABB> Partial(2 * Chunks);
+
+			Parallel::For(Chunks, 1, [&](std::size_t FirstChunk, std::size_t LastChunk)
+			{
+				for (std::size_t Chunk = FirstChunk; Chunk < LastChunk; Chunk++)
+				{
+					AABB b, c;
+
+					for (std::size_t Index = Count * Chunk / Chunks; Index < Count * (Chunk + 1) / Chunks; Index++)
+					{
+						unsigned int i = Indices[First + Index];
+						b.Extend(Boxes[i]);
+						c.Extend(Centroids[i]);
+					}
+
+					Partial[2 * Chunk] = b;
+					Partial[2 * Chunk + 1] = c;
+				}
+			});
+
+			for (std::size_t Chunk = 0; Chunk < Chunks; Chunk++)
+			{
+				Box.Extend(Partial[2 * Chunk]);
+				CentroidBox.Extend(Partial[2 * Chunk + 1]);
+			}
+		}
+
+		void Fill(unsigned int First, unsigned int Count, int Depth, int Axis, AABB const &CentroidBounds, Bin *Bins) const
+		{
+			float Origin = CentroidBounds.Min[Axis];
+			float Scale = BinCount / CentroidBounds.Extent()[Axis];
+
+			std::size_t Chunks = (Count > ParallelGrain && Depth < ParallelBinDepth ? Parallel::ThreadCount() : 1);
+
+			if (Chunks == 1)
+			{
+				for (int b = 0; b < BinCount; b++)
+				{
+					Bins[b].Bounds = AABB();
+					Bins[b].Count = 0;
+				}
+
+				for (unsigned int Index = First; Index < First + Count; Index++)
+				{
+					unsigned int i = Indices[Index];
+					int b = BinIndex(Centroids[i][Axis], Origin, Scale);
+					Bins[b].Bounds.Extend(Boxes[i]);
+					Bins[b].Count++;
+				}
+
+				return;
+			}
+
+			std::vector<Bin> Partial(Chunks * BinCount);
+
+			for (std::size_t Index = 0; Index < Partial.size(); Index++)
+				Partial[Index].Count = 0;
+
+			Parallel::For(Chunks, 1, [&](std::size_t FirstChunk, std::size_t LastChunk)
+			{
+				for (std::size_t Chunk = FirstChunk; Chunk < LastChunk; Chunk++)
+				{
+					Bin *Local = &Partial[Chunk * BinCount];
+
+					for (std::size_t Index = Count * Chunk / Chunks; Index < Count * (Chunk + 1) / Chunks; Index++)
+					{
+						unsigned int i = Indices[First + Index];
+						int b = BinIndex(Centroids[i][Axis], Origin, Scale);
+						Local[b].Bounds.Extend(Boxes[i]);
+						Local[b].Count++;
+					}
+				}
+			});
+
+			for (int b = 0; b < BinCount; b++)
+			{
+				Bins[b] = Partial[b];
+				for (std::size_t Chunk = 1; Chunk < Chunks; Chunk++)
+				{
+					Bins[b].Bounds.Extend(Partial[Chunk * BinCount + b].Bounds);
+					Bins[b].Count += Partial[Chunk * BinCount + b].Count;
+				}
+			}
+		}
+
+		AABB const *Boxes;
+		unsigned int *Indices;
+		std::vector<Vector3> Centroids;
+		std::vector<BuildNode> Nodes;
+		std::atomic<unsigned int> Used;
+		int SpawnDepth;
+	};
+
+	void SetSlot(Bvh::Node &n, int Slot, AABB const &b)
+	{
+		n.MinX[Slot] = b.Min.x; n.MinY[Slot] = b.Min.y; n.MinZ[Slot] = b.Min.z;
+		n.MaxX[Slot] = b.Max.x; n.MaxY[Slot] = b.Max.y; n.MaxZ[Slot] = b.Max.z;
+	}
+
+	// Opens the largest inner grandchildren until four children are gathered, then recurses.
+	template <typename NodeArray>
+	unsigned int Collapse(std::vector<BuildNode> const &Binary, unsigned int Root, NodeArray &Nodes)
+	{
+		unsigned int Children[4] = {Binary[Root].Left, Binary[Root].Right, 0, 0};
+		int Used = 2;
+
+		if (Binary[Root].Count > 0)
+		{
+			Children[0] = Root;
+			Used = 1;
+		}
+
+		while (Used < 4)
+		{
+			int Largest = -1;
+			float LargestArea = -1.0f;
+
+			for (int Slot = 0; Slot < Used; Slot++)
+			{
+				BuildNode const &c = Binary[Children[Slot]];
+				if (c.Count == 0 && c.Bounds.SurfaceArea() > LargestArea)
+				{
+					Largest = Slot;
+					LargestArea = c.Bounds.SurfaceArea();
+				}
+			}
+
+			if (Largest < 0)
+				break;
+
+			BuildNode const &Open = Binary[Children[Largest]];
+			Children[Largest] = Open.Left;
+			Children[Used++] = Open.Right;
+		}
+
+		unsigned int Index = static_cast<unsigned int>(Nodes.size());
+		Nodes.push_back(Bvh::Node());
+
+		for (int Slot = 0; Slot < 4; Slot++)
+		{
+			if (Slot >= Used)
+			{
+				SetSlot(Nodes[Index], Slot, AABB());
+				Nodes[Index].Child[Slot] = Bvh::EmptySlot;
+				Nodes[Index].Count[Slot] = 0;
+				continue;
+			}
+
+			BuildNode const &c = Binary[Children[Slot]];
+			unsigned int Child = (c.Count > 0 ? c.First : Collapse(Binary, Children[Slot], Nodes));
+
+			SetSlot(Nodes[Index], Slot, c.Bounds);
+			Nodes[Index].Child[Slot] = Child;
+			Nodes[Index].Count[Slot] = c.Count;
+		}
+
+		return Index;
+	}
+
+	// Slab test of one ray against the four children of a node.  Near receives the entry distance
+	// of each child that is hit.
+	inline unsigned int IntersectSlots(Bvh::Node const &n, Vector3 const &Origin, Vector3 const &Inverse,
+									   float TMin, float TMax, float *Near)
+	{
+		unsigned int Mask = 0;
+
+		for (int Slot = 0; Slot < 4; Slot++)
+		{
+			float x0 = (n.MinX[Slot] - Origin.x) * Inverse.x, x1 = (n.MaxX[Slot] - Origin.x) * Inverse.x;
+			float y0 = (n.MinY[Slot] - Origin.y) * Inverse.y, y1 = (n.MaxY[Slot] - Origin.y) * Inverse.y;
+			float z0 = (n.MinZ[Slot] - Origin.z) * Inverse.z, z1 = (n.MaxZ[Slot] - Origin.z) * Inverse.z;
+
+			float Enter = std::max(std::max(std::min(x0, x1), std::min(y0, y1)), std::max(std::min(z0, z1), TMin));
+			float Exit = std::min(std::min(std::max(x0, x1), std::max(y0, y1)), std::min(std::max(z0, z1), TMax));
+
+			// Widen the exit slightly so rounding can never cull a box the ray actually grazes.
+			Exit *= 1.0000004f;
+
+			Near[Slot] = Enter;
+			Mask |= static_cast<unsigned int>(Enter <= Exit) << Slot;
+		}
+
+		return Mask;
+	}
+
+	inline float SlotDistanceSquared(Bvh::Node const &n, int Slot, Vector3 const &p)
+	{
+		float dx = std::max(std::max(n.MinX[Slot] - p.x, p.x - n.MaxX[Slot]), 0.0f);
+		float dy = std::max(std::max(n.MinY[Slot] - p.y, p.y - n.MaxY[Slot]), 0.0f);
+		float dz = std::max(std::max(n.MinZ[Slot] - p.z, p.z - n.MaxZ[Slot]), 0.0f);
+		return dx * dx + dy * dy + dz * dz;
+	}
+}
+
+Bvh::Bvh() :
+	Triangles(false)
+{
+
+}
+
+void Bvh::Build(Triangle const *Triangles, std::size_t Count)
+{
+	Boxes.resize(Count);
+
+	Parallel::For(Count, ParallelGrain, [&](std::size_t Begin, std::size_t End)
+	{
+		for (std::size_t Index = Begin; Index < End; Index++)
+		{
+			AABB b;
+			b.Extend(Triangles[Index].v0);
+			b.Extend(Triangles[Index].v1);
+			b.Extend(Triangles[Index].v2);
+			Boxes[Index] = b;
+		}
+	});
+
+	this->Build(Count);
+	this->ReorderTriangles(Triangles);
+	this->Triangles = true;
+}
+
+void Bvh::Build(AABB const *Boxes, std::size_t Count)
+{
+	this->Boxes.assign(Boxes, Boxes + Count);
+	this->Build(Count);
+
+	for (int Component = 0; Component < 9; Component++)
+		Vertices[Component].clear();
+
+	Triangles = false;
+}
+
+void Bvh::Clear()
+{
+	Nodes.clear();
+	Indices.clear();
+	Boxes.clear();
+
+	for (int Component = 0; Component < 9; Component++)
+		Vertices[Component].clear();
+
+	Triangles = false;
+}
+
+void Bvh::Refit(Triangle const *Triangles)
+{
+	Parallel::For(Indices.size(), ParallelGrain, [&](std::size_t Begin, std::size_t End)
+	{
+		for (std::size_t Index = Begin; Index < End; Index++)
+		{
+			Triangle const &t = Triangles[Indices[Index]];
+			AABB b;
+			b.Extend(t.v0);
+			b.Extend(t.v1);
+			b.Extend(t.v2);
+			Boxes[Index] = b;
+		}
+	});
+
+	this->ReorderTriangles(Triangles);
+	this->RefitNodes();
+}
+
+void Bvh::Refit(AABB const *Boxes)
+{
+	for (std::size_t Index = 0; Index < Indices.size(); Index++)
+		this->Boxes[Index] = Boxes[Indices[Index]];
+
+	this->RefitNodes();
+}
+
+// Queries ================================================
+
+bool Bvh::Intersect(Ray const &r, Hit &Result) const
+{
+	if (Nodes.empty() || !Triangles)
+		return false;
+
+	Vector3 Inverse(1.0f / r.Direction.x, 1.0f / r.Direction.y, 1.0f / r.Direction.z);
+	Ray Closest = r;
+	Closest.TMax = std::min(r.TMax, Result.Distance);
+	bool Found = false;
+
+	unsigned int Stack[StackSize];
+	int Top = 0;
+	Stack[Top++] = 0;
+
+	while (Top > 0)
+	{
+		Node const &n = Nodes[Stack[--Top]];
+
+		float Near[4];
+		unsigned int Mask = IntersectSlots(n, r.Origin, Inverse, Closest.TMin, Closest.TMax, Near);
+
+		// Visit leaves right away; queue inner children so the nearest is popped first.
+		int Order[4];
+		int Queued = 0;
+
+		for (int Slot = 0; Slot < 4; Slot++)
+		{
+			if (!(Mask & (1u << Slot)) || n.Child[Slot] == EmptySlot)
+				continue;
+
+			if (n.Count[Slot] > 0)
+			{
+				// Leaves cut off at MaxDepth can hold more than one packet of triangles.
+				TriangleArrays Leaf = this->Leaf(n.Child[Slot], n.Count[Slot]);
+				HitPacket<MaxLeafSize> Hits;
+
+				for (unsigned int First = 0; First < n.Count[Slot]; First += MaxLeafSize)
+				{
+					if (Math::Intersect(Closest, Leaf, First, Hits) == 0)
+						continue;
+
+					for (unsigned int Lane = 0; Lane < MaxLeafSize; Lane++)
+					{
+						if (Hits.Id[Lane] != NoHit && Hits.Distance[Lane] < Closest.TMax)
+						{
+							Result = Hits.Get(Lane);
+							Result.Id = Indices[n.Child[Slot] + Hits.Id[Lane]];
+							Closest.TMax = Result.Distance;
+							Found = true;
+						}
+					}
+				}
+			}
+			else
+			{
+				int Position = Queued++;
+				while (Position > 0 && Near[Order[Position - 1]] < Near[Slot])
+				{
+					Order[Position] = Order[Position - 1];
+					Position--;
+				}
+				Order[Position] = Slot;
+			}
+		}
+
+		for (int Index = 0; Index < Queued; Index++)
+			Stack[Top++] = n.Child[Order[Index]];
+	}
+
+	return Found;
+}
+
+bool Bvh::ClosestPoint(Vector3 const &Point, float MaxDistance, Vector3 &Closest, unsigned int &Id) const
+{
+	if (Nodes.empty())
+		return false;
+
+	float Best = MaxDistance * MaxDistance;
+	bool Found = false;
+
+	unsigned int Stack[StackSize];
+	int Top = 0;
+	Stack[Top++] = 0;
+
+	while (Top > 0)
+	{
+		Node const &n = Nodes[Stack[--Top]];
+
+		float Distance[4];
+		int Order[4];
+		int Queued = 0;
+
+		for (int Slot = 0; Slot < 4; Slot++)
+			Distance[Slot] = SlotDistanceSquared(n, Slot, Point);
+
+		for (int Slot = 0; Slot < 4; Slot++)
+		{
+			if (n.Child[Slot] == EmptySlot || Distance[Slot] > Best)
+				continue;
+
+			if (n.Count[Slot] > 0)
+			{
+				for (unsigned int Index = n.Child[Slot]; Index < n.Child[Slot] + n.Count[Slot]; Index++)
+				{
+					Vector3 c;
+
+					if (Triangles)
+					{
+						Triangle t(Vector3(Vertices[0][Index], Vertices[1][Index], Vertices[2][Index]),
+								   Vector3(Vertices[3][Index], Vertices[4][Index], Vertices[5][Index]),
+								   Vector3(Vertices[6][Index], Vertices[7][Index], Vertices[8][Index]));
+						c = Math::ClosestPoint(t, Point);
+					}
+					else
+						c = Boxes[Index].ClosestPoint(Point);
+
+					float d = (c - Point).LengthSquared();
+					if (d <= Best)
+					{
+						Best = d;
+						Closest = c;
+						Id = Indices[Index];
+						Found = true;
+					}
+				}
+			}
+			else
+			{
+				int Position = Queued++;
+				while (Position > 0 && Distance[Order[Position - 1]] < Distance[Slot])
+				{
+					Order[Position] = Order[Position - 1];
+					Position--;
+				}
+				Order[Position] = Slot;
+			}
+		}
+
+		for (int Index = 0; Index < Queued; Index++)
+			Stack[Top++] = n.Child[Order[Index]];
+	}
+
+	return Found;
+}
+
+std::size_t Bvh::Overlaps(AABB const &Box, std::vector<unsigned int> &Ids) const
+{
+	std::size_t Start = Ids.size();
+
+	if (Nodes.empty())
+		return 0;
+
+	unsigned int Stack[StackSize];
+	int Top = 0;
+	Stack[Top++] = 0;
+
+	while (Top > 0)
+	{
+		Node const &n = Nodes[Stack[--Top]];
+
+		unsigned int Mask = 0;
+		for (int Slot = 0; Slot < 4; Slot++)
+		{
+			bool Overlap = (n.MinX[Slot] <= Box.Max.x) & (n.MaxX[Slot] >= Box.Min.x) &
+						   (n.MinY[Slot] <= Box.Max.y) & (n.MaxY[Slot] >= Box.Min.y) &
+						   (n.MinZ[Slot] <= Box.Max.z) & (n.MaxZ[Slot] >= Box.Min.z);
+			Mask |= static_cast<unsigned int>(Overlap) << Slot;
+		}
+
+		for (int Slot = 0; Slot < 4; Slot++)
+		{
+			if (!(Mask & (1u << Slot)) || n.Child[Slot] == EmptySlot)
+				continue;
+
+			if (n.Count[Slot] > 0)
+			{
+				for (unsigned int Index = n.Child[Slot]; Index < n.Child[Slot] + n.Count[Slot]; Index++)
+				{
+					if (Boxes[Index].Overlaps(Box))
+						Ids.push_back(Indices[Index]);
+				}
+			}
+			else
+				Stack[Top++] = n.Child[Slot];
+		}
+	}
+
+	return Ids.size() - Start;
+}
+
+// Private ================================================
+
+void Bvh::Build(std::size_t Count)
+{
+	Nodes.clear();
+	Indices.resize(Count);
+
+	for (std::size_t Index = 0; Index < Count; Index++)
+		Indices[Index] = static_cast<unsigned int>(Index);
+
+	if (Count == 0)
+		return;
+
+	Builder b(&Boxes[0], Count, &Indices[0]);
+	b.Build(0, 0, static_cast<unsigned int>(Count), 0);
+
+	Nodes.reserve(Count / 2 + 1);
+	Collapse(b.Result(), 0, Nodes);
+
+	// Boxes now follow leaf order, like everything else.
+	std::vector<AABB> Ordered(Count);
+	for (std::size_t Index = 0; Index < Count; Index++)
+		Ordered[Index] = Boxes[Indices[Index]];
+
+	Boxes.swap(Ordered);
+}
+
+void Bvh::RefitNodes()
+{
+	// Children always come after their parent, so a reverse sweep sees them first.
+	for (std::size_t Index = Nodes.size(); Index > 0; Index--)
+	{
+		Node &n = Nodes[Index - 1];
+
+		for (int Slot = 0; Slot < 4; Slot++)
+		{
+			if (n.Child[Slot] == EmptySlot)
+				continue;
+
+			AABB b;
+
+			if (n.Count[Slot] > 0)
+			{
+				for (unsigned int Primitive = n.Child[Slot]; Primitive < n.Child[Slot] + n.Count[Slot]; Primitive++)
+					b.Extend(Boxes[Primitive]);
+			}
+			else
+			{
+				Node const &c = Nodes[n.Child[Slot]];
+				for (int ChildSlot = 0; ChildSlot < 4; ChildSlot++)
+				{
+					if (c.Child[ChildSlot] != EmptySlot)
+						b.Extend(AABB(Vector3(c.MinX[ChildSlot], c.MinY[ChildSlot], c.MinZ[ChildSlot]),
+									  Vector3(c.MaxX[ChildSlot], c.MaxY[ChildSlot], c.MaxZ[ChildSlot])));
+				}
+			}
+
+			SetSlot(n, Slot, b);
+		}
+	}
+}
+
+void Bvh::ReorderTriangles(Triangle const *Triangles)
+{
+	std::size_t Count = Indices.size();
+
+	for (int Component = 0; Component < 9; Component++)
+		Vertices[Component].resize(Count);
+
+	Parallel::For(Count, ParallelGrain, [&](std::size_t Begin, std::size_t End)
+	{
+		for (std::size_t Index = Begin; Index < End; Index++)
+		{
+			Triangle const &t = Triangles[Indices[Index]];
+			Vertices[0][Index] = t.v0.x; Vertices[1][Index] = t.v0.y; Vertices[2][Index] = t.v0.z;
+			Vertices[3][Index] = t.v1.x; Vertices[4][Index] = t.v1.y; Vertices[5][Index] = t.v1.z;
+			Vertices[6][Index] = t.v2.x; Vertices[7][Index] = t.v2.y; Vertices[8][Index] = t.v2.z;
+		}
+	});
+}
@@ -0,0 +1,135 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_BVH
+#define SMALLMATH_BVH
+
+#include <cstddef>
+#include <vector>
+
+#include "math/Allocator.hpp"
+#include "math/Bounds.hpp"
+#include "math/Geometry.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Four-wide bounding volume hierarchy over triangles or boxes.
+	//
+	// The tree is built top-down with binned SAH; subtrees above a size threshold are built on
+	// separate threads.  The binary result is collapsed into 4-wide nodes that hold their
+	// children's bounds as SoA lanes, so one node visit tests all four children at once.  Nodes
+	// are stored parents-first, which lets Refit() update bounds in a single reverse sweep when the
+	// geometry moves but the topology stays valid.
+	//
+	// Primitive ids reported by queries are indices into the array given to Build().
+
+	class Bvh
+	{
+	public:
+		static const unsigned int MaxLeafSize = 8;
+		static const unsigned int EmptySlot = 0xFFFFFFFFu;
+
+		struct Node
+		{
+			float MinX[4], MinY[4], MinZ[4];
+			float MaxX[4], MaxY[4], MaxZ[4];
+			unsigned int Child[4];	// Inner: node index.  Leaf: first primitive.  Unused: EmptySlot
+			unsigned int Count[4];	// Leaf primitive count, 0 for inner children
+		};
+
+		Bvh();
+
+		void Build(Triangle const *Triangles, std::size_t Count);
+		void Build(AABB const *Boxes, std::size_t Count);
+		void Clear();
+
+		// The input must be the same primitives, in the same order, as the last Build().
+		void Refit(Triangle const *Triangles);
+		void Refit(AABB const *Boxes);
+
+		// Queries
+		bool Intersect(Ray const &r, Hit &Result) const;	// Triangle hierarchies only
+		bool ClosestPoint(Vector3 const &Point, float MaxDistance, Vector3 &Closest, unsigned int &Id) const;
+		std::size_t Overlaps(AABB const &Box, std::vector<unsigned int> &Ids) const;	// Appends to Ids
+
+		inline AABB Bounds() const;
+		inline std::size_t NodeCount() const;
+		inline std::size_t PrimitiveCount() const;
+		inline bool HasTriangles() const;
+
+	private:
+		void Build(std::size_t Count);
+		void RefitNodes();
+		void ReorderTriangles(Triangle const *Triangles);
+		inline TriangleArrays Leaf(unsigned int First, unsigned int Count) const;
+
+		std::vector<Node, AlignedAllocator<Node> > Nodes;
+		std::vector<unsigned int> Indices;		// Leaf order -> input index
+		std::vector<AABB> Boxes;				// Leaf order
+		std::vector<float, AlignedAllocator<float> > Vertices[9];	// Leaf order SoA triangles
+		bool Triangles;
+	};
+
+	// Inline methods =====================================
+
+	inline AABB Bvh::Bounds() const
+	{
+		AABB r;
+
+		if (Nodes.empty())
+			return r;
+
+		Node const &n = Nodes[0];
+		for (int Slot = 0; Slot < 4; Slot++)
+		{
+			if (n.Child[Slot] != EmptySlot)
+				r.Extend(AABB(Vector3(n.MinX[Slot], n.MinY[Slot], n.MinZ[Slot]), Vector3(n.MaxX[Slot], n.MaxY[Slot], n.MaxZ[Slot])));
+		}
+
+		return r;
+	}
+
+	inline std::size_t Bvh::NodeCount() const
+	{
+		return Nodes.size();
+	}
+
+	inline std::size_t Bvh::PrimitiveCount() const
+	{
+		return Indices.size();
+	}
+
+	inline bool Bvh::HasTriangles() const
+	{
+		return Triangles;
+	}
+
+	inline TriangleArrays Bvh::Leaf(unsigned int First, unsigned int Count) const
+	{
+		TriangleArrays t;
+		t.x0 = &Vertices[0][First]; t.y0 = &Vertices[1][First]; t.z0 = &Vertices[2][First];
+		t.x1 = &Vertices[3][First]; t.y1 = &Vertices[4][First]; t.z1 = &Vertices[5][First];
+		t.x2 = &Vertices[6][First]; t.y2 = &Vertices[7][First]; t.z2 = &Vertices[8][First];
+		t.Count = Count;
+		return t;
+	}
+}
+
+#endif
@@ -0,0 +1,214 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "math/Camera.hpp"
+#include "math/FloatingPoint.hpp"
+
+using namespace Math;
+
+namespace
+{
+	std::size_t const ProjectBlock = 1024;		// Points per checked block
+
+	std::size_t ProjectRange(float const (&Row)[3][4], float const (&m)[4][4], Vector3 const *Points,
+							 std::size_t First, std::size_t Last, Vector3 *Screen)
+	{
+		float const Behind = -std::numeric_limits<float>::max();
+		std::size_t Visible = 0;
+
+		for (std::size_t Index = First; Index < Last; Index++)
+		{
+			Vector3 const &p = Points[Index];
+
+			float x = Row[0][0] * p.x + Row[0][1] * p.y + Row[0][2] * p.z + Row[0][3];
+			float y = Row[1][0] * p.x + Row[1][1] * p.y + Row[1][2] * p.z + Row[1][3];
+			float z = Row[2][0] * p.x + Row[2][1] * p.y + Row[2][2] * p.z + Row[2][3];
+			float w = m[3][0] * p.x + m[3][1] * p.y + m[3][2] * p.z + m[3][3];
+
+			bool Front = (w > 0.0f);
+			float InverseW = 1.0f / (Front ? w : 1.0f);
+
+			Screen[Index] = Vector3(Front ? x * InverseW : Behind,
+									Front ? y * InverseW : Behind,
+									Front ? z * InverseW : Behind);
+			Visible += Front;
+		}
+
+		return Visible;
+	}
+
+	// z' = A * z + B * w, w' = -z.  Both perspective forms share the same inverse layout.
+	Matrix4Pair PerspectivePair(float ScaleX, float ScaleY, float A, float B)
+	{
+		Matrix4 Projection(ScaleX, 0.0f,   0.0f,  0.0f,
+						   0.0f,   ScaleY, 0.0f,  0.0f,
+						   0.0f,   0.0f,   A,     B,
+						   0.0f,   0.0f,   -1.0f, 0.0f);
+
+		Matrix4 Inverse(1.0f / ScaleX, 0.0f,          0.0f,     0.0f,
+						0.0f,          1.0f / ScaleY, 0.0f,     0.0f,
+						0.0f,          0.0f,          0.0f,     -1.0f,
+						0.0f,          0.0f,          1.0f / B, A / B);
+
+		return Matrix4Pair(Projection, Inverse);
+	}
+}
+
+Matrix4Pair Math::Perspective(float VerticalFov, float Aspect, float Near, float Far, Frustum::ClipDepth Depth)
+{
+	float ScaleY = 1.0f / std::tan(VerticalFov * 0.5f);
+	float Range = 1.0f / (Far - Near);
+
+	switch (Depth)
+	{
+	case Frustum::ZeroToOne:
+		return PerspectivePair(ScaleY / Aspect, ScaleY, -Far * Range, -Far * Near * Range);
+	case Frustum::ReversedZeroToOne:
+		return PerspectivePair(ScaleY / Aspect, ScaleY, Near * Range, Far * Near * Range);
+	default:
+		return PerspectivePair(ScaleY / Aspect, ScaleY, -(Far + Near) * Range, -2.0f * Far * Near * Range);
+	}
+}
+
+Matrix4Pair Math::InfinitePerspective(float VerticalFov, float Aspect, float Near, Frustum::ClipDepth Depth)
+{
+	float ScaleY = 1.0f / std::tan(VerticalFov * 0.5f);
+
+	switch (Depth)
+	{
+	case Frustum::ZeroToOne:
+		return PerspectivePair(ScaleY / Aspect, ScaleY, -1.0f, -Near);
+	case Frustum::ReversedZeroToOne:
+		return PerspectivePair(ScaleY / Aspect, ScaleY, 0.0f, Near);
+	default:
+		return PerspectivePair(ScaleY / Aspect, ScaleY, -1.0f, -2.0f * Near);
+	}
+}
+
+Matrix4Pair Math::Orthographic(float Left, float Right, float Bottom, float Top, float Near, float Far, Frustum::ClipDepth Depth)
+{
+	float ScaleX = 2.0f / (Right - Left);
+	float ScaleY = 2.0f / (Top - Bottom);
+	float OffsetX = -(Right + Left) / (Right - Left);
+	float OffsetY = -(Top + Bottom) / (Top - Bottom);
+	float ScaleZ, OffsetZ;
+
+	switch (Depth)
+	{
+	case Frustum::ZeroToOne:
+		ScaleZ = -1.0f / (Far - Near);
+		OffsetZ = -Near / (Far - Near);
+		break;
+	case Frustum::ReversedZeroToOne:
+		ScaleZ = 1.0f / (Far - Near);
+		OffsetZ = Far / (Far - Near);
+		break;
+	default:
+		ScaleZ = -2.0f / (Far - Near);
+		OffsetZ = -(Far + Near) / (Far - Near);
+		break;
+	}
+
+	Matrix4 Projection(ScaleX, 0.0f,   0.0f,   OffsetX,
+					   0.0f,   ScaleY, 0.0f,   OffsetY,
+					   0.0f,   0.0f,   ScaleZ, OffsetZ,
+					   0.0f,   0.0f,   0.0f,   1.0f);
+
+	Matrix4 Inverse(1.0f / ScaleX, 0.0f,          0.0f,          -OffsetX / ScaleX,
+					0.0f,          1.0f / ScaleY, 0.0f,          -OffsetY / ScaleY,
+					0.0f,          0.0f,          1.0f / ScaleZ, -OffsetZ / ScaleZ,
+					0.0f,          0.0f,          0.0f,          1.0f);
+
+	return Matrix4Pair(Projection, Inverse);
+}
+
+Matrix4Pair Math::LookAt(Vector3 const &Eye, Vector3 const &Target, Vector3 const &Up)
+{
+	Vector3 f = Target - Eye;
+	Vector3 s = f.Cross(Up);
+
+	if (f.IsZero() || s.IsZero())
+	{
+		Matrix4 Identity;
+		return Matrix4Pair(Identity, Identity);
+	}
+
+	f.Normalize();
+	s.Normalize();
+	Vector3 u = s.Cross(f);
+
+	// The rotation part is orthonormal, so the inverse is its transpose plus the eye position.
+	Matrix4 View(s.x,  s.y,  s.z,  -s.Dot(Eye),
+				 u.x,  u.y,  u.z,  -u.Dot(Eye),
+				 -f.x, -f.y, -f.z, f.Dot(Eye),
+				 0.0f, 0.0f, 0.0f, 1.0f);
+
+	Matrix4 Inverse(s.x, u.x, -f.x, Eye.x,
+					s.y, u.y, -f.y, Eye.y,
+					s.z, u.z, -f.z, Eye.z,
+					0.0f, 0.0f, 0.0f, 1.0f);
+
+	return Matrix4Pair(View, Inverse);
+}
+
+std::size_t Math::Project(Matrix4 const &ViewProjection, Viewport const &View, Vector3 const *Points, std::size_t Count, Vector3 *Screen)
+{
+	float const (&m)[4][4] = ViewProjection.m;
+
+	// Fold the viewport mapping into the matrix rows so each point needs one reciprocal and no
+	// separate NDC step:  screen x = x + Width * (ndc x + 1) / 2 = (HalfWidth * cx + (x + HalfWidth) * cw) / cw
+	float HalfWidth = 0.5f * View.Width;
+	float HalfHeight = 0.5f * View.Height;
+	float CenterX = View.x + HalfWidth;
+	float CenterY = View.y + HalfHeight;
+
+	float Row[3][4];
+	for (int Column = 0; Column < 4; Column++)
+	{
+		Row[0][Column] = HalfWidth * m[0][Column] + CenterX * m[3][Column];
+		Row[1][Column] = -HalfHeight * m[1][Column] + CenterY * m[3][Column];
+		Row[2][Column] = m[2][Column];
+	}
+
+	DenormalGuard Guard;
+
+	if (!CheckedBuild())
+		return ProjectRange(Row, m, Points, 0, Count, Screen);
+
+	// Check each block while it is still in cache.  Under a guard that flushes, nothing computed
+	// here can be denormal, so the quicker NaN and infinity scan decides whether the full one is
+	// needed.
+	bool Flushed = DenormalGuard::Flushes();
+	std::size_t Visible = 0;
+
+	for (std::size_t First = 0; First < Count; First += ProjectBlock)
+	{
+		std::size_t Last = std::min(First + ProjectBlock, Count);
+		Visible += ProjectRange(Row, m, Points, First, Last, Screen);
+
+		if (!Flushed || AnyNonFinite(&Screen[First].x, 3 * (Last - First)))
+			CheckOutput("Project", &Screen[First].x, Last - First, 3, First);
+	}
+
+	return Visible;
+}
@@ -0,0 +1,80 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_CAMERA
+#define SMALLMATH_CAMERA
+
+#include <cstddef>
+
+#include "math/Bounds.hpp"
+#include "math/Matrix.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Camera and projection matrices, each returned together with its inverse.  The inverses are
+	// written out in closed form, so they are exact up to float rounding and avoid Inverted().
+	//
+	// Conventions follow OpenGL: right-handed view space looking down -z, angles in radians.  The
+	// depth range of the projection is picked with Frustum::ClipDepth; ReversedZeroToOne maps the
+	// near plane to 1 and the far plane to 0, which spreads float depth precision evenly.
+
+	class Matrix4Pair
+	{
+	public:
+		Matrix4Pair() { }
+		Matrix4Pair(Matrix4 const &Matrix, Matrix4 const &Inverse) : Matrix(Matrix), Inverse(Inverse) { }
+
+		Matrix4 Matrix;
+		Matrix4 Inverse;
+	};
+
+	class Viewport
+	{
+	public:
+		Viewport() : x(0.0f), y(0.0f), Width(1.0f), Height(1.0f) { }
+		Viewport(float Width, float Height) : x(0.0f), y(0.0f), Width(Width), Height(Height) { }
+		Viewport(float x, float y, float Width, float Height) : x(x), y(y), Width(Width), Height(Height) { }
+
+		float x, y;		// Top-left corner
+		float Width, Height;
+	};
+
+	// Builders ===========================================
+
+	Matrix4Pair Perspective(float VerticalFov, float Aspect, float Near, float Far,
+							Frustum::ClipDepth Depth = Frustum::NegativeOneToOne);
+	Matrix4Pair InfinitePerspective(float VerticalFov, float Aspect, float Near,
+									Frustum::ClipDepth Depth = Frustum::NegativeOneToOne);
+	Matrix4Pair Orthographic(float Left, float Right, float Bottom, float Top, float Near, float Far,
+							 Frustum::ClipDepth Depth = Frustum::NegativeOneToOne);
+
+	// World to view.  Returns identity pairs if Target == Eye or Up is parallel to the view direction.
+	Matrix4Pair LookAt(Vector3 const &Eye, Vector3 const &Target, Vector3 const &Up);
+
+	// Screen projection ==================================
+
+	// Transforms Count points by ViewProjection and maps them into the viewport, with screen y
+	// growing downward.  z of each result is the clip space depth.  Points at or behind the eye
+	// plane (w <= 0) have no screen position; their results are set to -max float.  Returns the
+	// number of points in front of the eye.  Screen may alias Points.
+	std::size_t Project(Matrix4 const &ViewProjection, Viewport const &View, Vector3 const *Points, std::size_t Count, Vector3 *Screen);
+}
+
+#endif
@@ -0,0 +1,626 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "math/Convex.hpp"
+
+using namespace Math;
+
+namespace
+{
+	int const HullWidth = 8;
+
+	unsigned int const GjkMaxIterations = 64;
+	float const GjkTolerance = 1.0e-6f;			// Stop when |v|^2 - v.w is this fraction of |v|^2
+	float const GjkTouching = 1.0e-10f;			// |v|^2 below this times the largest |w|^2 counts as contact
+
+	int const EpaMaxVertices = 128;
+	int const EpaMaxFaces = 2 * EpaMaxVertices;
+	int const EpaMaxEdges = 64;					// Horizon of a single expansion
+	float const EpaTolerance = 1.0e-4f;			// Relative to the size of a - b
+
+	// A point of the Minkowski difference a - b, with the shape points and search direction behind it.
+	struct Vertex
+	{
+		Vector3 w, a, b;
+		Vector3 Direction;
+	};
+
+	inline Vertex Support(Convex const &a, Convex const &b, Vector3 const &Direction)
+	{
+		Vertex v;
+		v.Direction = Direction;
+		v.a = a.Support(Direction);
+		v.b = b.Support(Direction * -1.0f);
+		v.w = v.a - v.b;
+		return v;
+	}
+
+	struct Simplex
+	{
+		Simplex() : Lambda(), Count(0) { }
+
+		inline void Set(Vertex const &v0)
+		{
+			v[0] = v0;
+			Lambda[0] = 1.0f;
+			Count = 1;
+		}
+
+		inline void Set(Vertex const &v0, Vertex const &v1, float t)
+		{
+			v[0] = v0; v[1] = v1;
+			Lambda[0] = 1.0f - t; Lambda[1] = t;
+			Count = 2;
+		}
+
+		inline void Set(Vertex const &v0, Vertex const &v1, Vertex const &v2, float s, float t)
+		{
+			v[0] = v0; v[1] = v1; v[2] = v2;
+			Lambda[0] = 1.0f - s - t; Lambda[1] = s; Lambda[2] = t;
+			Count = 3;
+		}
+
+		inline Vector3 Point() const
+		{
+			Vector3 r;
+			for (int i = 0; i < Count; i++)
+				r += v[i].w * Lambda[i];
+			return r;
+		}
+
+		inline void Witnesses(Vector3 &a, Vector3 &b) const
+		{
+			a = b = Vector3();
+			for (int i = 0; i < Count; i++)
+			{
+				a += v[i].a * Lambda[i];
+				b += v[i].b * Lambda[i];
+			}
+		}
+
+		Vertex v[4];
+		float Lambda[4];
+		int Count;
+	};
+
+	// Closest point of a segment or triangle to the origin (Ericson, Real-Time Collision Detection
+	// 5.1.2 and 5.1.5), reduced to the vertices of the feature it lies on.
+	void Closest(Vertex const &a, Vertex const &b, Simplex &Out)
+	{
+		Vector3 ab = b.w - a.w;
+		float t = -a.w.Dot(ab);
+		float Denominator = ab.LengthSquared();
+
+		if (t <= 0.0f)
+			Out.Set(a);
+		else if (t >= Denominator)
+			Out.Set(b);
+		else
+			Out.Set(a, b, t / Denominator);
+	}
+
+	void Closest(Vertex const &a, Vertex const &b, Vertex const &c, Simplex &Out)
+	{
+		Vector3 ab = b.w - a.w, ac = c.w - a.w;
+
+		float d1 = -ab.Dot(a.w), d2 = -ac.Dot(a.w);
+		if (d1 <= 0.0f && d2 <= 0.0f)
+			return Out.Set(a);
+
+		float d3 = -ab.Dot(b.w), d4 = -ac.Dot(b.w);
+		if (d3 >= 0.0f && d4 <= d3)
+			return Out.Set(b);
+
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			return Out.Set(a, b, d1 / (d1 - d3));
+
+		float d5 = -ab.Dot(c.w), d6 = -ac.Dot(c.w);
+		if (d6 >= 0.0f && d5 <= d6)
+			return Out.Set(c);
+
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			return Out.Set(a, c, d2 / (d2 - d6));
+
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+			return Out.Set(b, c, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		float Sum = va + vb + vc;
+		if (!(Sum > 0.0f))
+		{
+			// Collinear: the closest point is on one of the edges.
+			Simplex e;
+			Closest(a, b, Out);
+			Closest(b, c, e);
+			if (e.Point().LengthSquared() < Out.Point().LengthSquared())
+				Out = e;
+			Closest(a, c, e);
+			if (e.Point().LengthSquared() < Out.Point().LengthSquared())
+				Out = e;
+			return;
+		}
+
+		Out.Set(a, b, c, vb / Sum, vc / Sum);
+	}
+
+	// True unless p and d are strictly on the same side of the plane through a, b and c.
+	inline bool Outside(Vector3 const &p, Vector3 const &a, Vector3 const &b, Vector3 const &c, Vector3 const &d)
+	{
+		Vector3 n = (b - a).Cross(c - a);
+		float Sp = (p - a).Dot(n), Sd = (d - a).Dot(n);
+		return (Sp * Sd < 0.0f || Sd == 0.0f);
+	}
+
+	// Replaces s by the sub-simplex closest to the origin.  A tetrahedron containing the origin is
+	// left whole, with its weights set to the centroid; once the origin is enclosed the point means
+	// nothing, and callers only look at Count == 4.
+	void Reduce(Simplex &s)
+	{
+		Vertex const *v = s.v;
+
+		if (s.Count == 1)
+			s.Lambda[0] = 1.0f;
+		else if (s.Count == 2)
+			Closest(v[0], v[1], s);
+		else if (s.Count == 3)
+		{
+			Simplex Out;
+			Closest(v[0], v[1], v[2], Out);
+			s = Out;
+		}
+		else
+		{
+			static int const Faces[4][4] = {{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}};
+			Vector3 Origin;
+			Simplex Best;
+			float BestDistance = std::numeric_limits<float>::max();
+
+			// The side tests mean nothing for a tetrahedron that is flat to working precision, so
+			// such a simplex never contains the origin: all four faces are candidates.
+			Vector3 e1 = v[1].w - v[0].w, e2 = v[2].w - v[0].w, e3 = v[3].w - v[0].w;
+			float Edge = std::max(std::max(e1.LengthSquared(), e2.LengthSquared()), e3.LengthSquared());
+			bool Flat = (std::abs(e1.Cross(e2).Dot(e3)) <= 1.0e-5f * Edge * std::sqrt(Edge));
+
+			for (int f = 0; f < 4; f++)
+			{
+				int const *i = Faces[f];
+				if (!Flat && !Outside(Origin, v[i[0]].w, v[i[1]].w, v[i[2]].w, v[i[3]].w))
+					continue;
+
+				Simplex Out;
+				Closest(v[i[0]], v[i[1]], v[i[2]], Out);
+				float d = Out.Point().LengthSquared();
+				if (d < BestDistance)
+				{
+					BestDistance = d;
+					Best = Out;
+				}
+			}
+
+			if (Best.Count == 0)
+			{
+				for (int i = 0; i < 4; i++)
+					s.Lambda[i] = 0.25f;
+				return;
+			}
+
+			s = Best;
+		}
+	}
+
+	// Runs GJK and returns true if the shapes intersect.  On return s is the final simplex.  With
+	// Early set, stops as soon as a separating direction is found.
+	bool Gjk(Convex const &a, Convex const &b, GjkCache *Cache, bool Early, Simplex &s, unsigned int &Iterations, float &Scale)
+	{
+		if (Cache != NULL && Cache->Count > 0)
+		{
+			s.Count = 0;
+			for (unsigned int i = 0; i < Cache->Count && i < 4; i++)
+				s.v[s.Count++] = Support(a, b, Cache->Directions[i]);
+			Reduce(s);
+		}
+		else
+			s.Set(Support(a, b, Vector3(1.0f, 0.0f, 0.0f)));
+
+		Scale = 0.0f;
+		for (int i = 0; i < s.Count; i++)
+			Scale = std::max(Scale, s.v[i].w.LengthSquared());
+
+		Vector3 v = s.Point();
+		bool Intersecting = false;
+
+		for (Iterations = 0; Iterations < GjkMaxIterations; Iterations++)
+		{
+			float vv = v.LengthSquared();
+			if (s.Count == 4 || vv <= GjkTouching * Scale)
+			{
+				Intersecting = true;
+				break;
+			}
+
+			Vertex w = Support(a, b, v * -1.0f);
+			Scale = std::max(Scale, w.w.LengthSquared());
+
+			float vw = v.Dot(w.w);
+			if ((Early && vw > 0.0f) || vv - vw <= GjkTolerance * vv)
+				break;
+
+			bool Repeated = false;
+			for (int i = 0; i < s.Count; i++)
+				Repeated |= (s.v[i].w == w.w);
+			if (Repeated)
+				break;
+
+			Simplex Previous = s;
+			s.v[s.Count++] = w;
+			Reduce(s);
+
+			Vector3 Next = s.Point();
+			if (s.Count < 4 && Next.LengthSquared() >= vv)
+			{
+				// No progress; rounding has taken over.
+				s = Previous;
+				break;
+			}
+
+			v = Next;
+		}
+
+		if (Cache != NULL)
+		{
+			Cache->Count = s.Count;
+			for (int i = 0; i < s.Count; i++)
+				Cache->Directions[i] = s.v[i].Direction;
+		}
+
+		Scale = std::sqrt(Scale);
+		return Intersecting;
+	}
+
+	// Expanding polytope ==================================
+
+	struct Face
+	{
+		int v[3];
+		Vector3 Normal;		// Outward, unit
+		float Distance;		// From the origin to the face's plane
+	};
+
+	struct Polytope
+	{
+		Polytope() : VertexCount(0), FaceCount(0) { }
+
+		bool AddFace(int i, int j, int k)
+		{
+			if (FaceCount == EpaMaxFaces)
+				return false;
+
+			Face &f = Faces[FaceCount++];
+			f.v[0] = i; f.v[1] = j; f.v[2] = k;
+			f.Normal = (Vertices[j].w - Vertices[i].w).Cross(Vertices[k].w - Vertices[i].w);
+
+			// Slivers are kept for the topology but never expanded.
+			float l = f.Normal.Length();
+			if (l > 0.0f)
+			{
+				f.Normal /= l;
+				f.Distance = f.Normal.Dot(Vertices[i].w);
+			}
+			else
+				f.Distance = std::numeric_limits<float>::max();
+
+			return true;
+		}
+
+		Vertex Vertices[EpaMaxVertices];
+		Face Faces[EpaMaxFaces];
+		int VertexCount, FaceCount;
+	};
+
+	// Grows a contact simplex (the origin on or inside it) into a tetrahedron.  Fails for shapes
+	// that are flat in some direction.
+	bool Tetrahedron(Convex const &a, Convex const &b, Simplex &s, float Scale)
+	{
+		float Epsilon = 1.0e-5f * Scale;
+
+		if (s.Count == 1)
+		{
+			static float const Axes[6][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+			for (int i = 0; i < 6 && s.Count == 1; i++)
+			{
+				Vertex w = Support(a, b, Vector3(Axes[i][0], Axes[i][1], Axes[i][2]));
+				if ((w.w - s.v[0].w).Length() > Epsilon)
+					s.v[s.Count++] = w;
+			}
+		}
+
+		if (s.Count == 2)
+		{
+			Vector3 d = s.v[1].w - s.v[0].w;
+			Vector3 Axis = (std::abs(d.x) < std::abs(d.y) ? (std::abs(d.x) < std::abs(d.z) ? Vector3(1, 0, 0) : Vector3(0, 0, 1))
+														   : (std::abs(d.y) < std::abs(d.z) ? Vector3(0, 1, 0) : Vector3(0, 0, 1)));
+			Vector3 p = d.Cross(Axis).Normalized();
+			Vector3 q = d.Normalized().Cross(p);
+
+			for (int i = 0; i < 6 && s.Count == 2; i++)
+			{
+				float Angle = static_cast<float>(i) * 1.04719755f;
+				Vertex w = Support(a, b, p * std::cos(Angle) + q * std::sin(Angle));
+				if ((w.w - s.v[0].w).Cross(d).Length() > Epsilon * d.Length())
+					s.v[s.Count++] = w;
+			}
+		}
+
+		if (s.Count == 3)
+		{
+			Vector3 n = (s.v[1].w - s.v[0].w).Cross(s.v[2].w - s.v[0].w);
+			float l = n.Length();
+
+			for (int i = 0; i < 2 && s.Count == 3 && l > 0.0f; i++)
+			{
+				Vertex w = Support(a, b, n * (i == 0 ? 1.0f : -1.0f));
+				if (std::abs(n.Dot(w.w - s.v[0].w)) > Epsilon * l)
+					s.v[s.Count++] = w;
+			}
+		}
+
+		return (s.Count == 4);
+	}
+
+	void Epa(Convex const &a, Convex const &b, Simplex &s, float Scale, ConvexContact &r)
+	{
+		Polytope p;
+
+		// Order the tetrahedron so that the faces below wind outwards.
+		Vector3 const &w0 = s.v[0].w;
+		if ((s.v[1].w - w0).Cross(s.v[2].w - w0).Dot(s.v[3].w - w0) > 0.0f)
+			std::swap(s.v[1], s.v[2]);
+
+		for (int i = 0; i < 4; i++)
+			p.Vertices[i] = s.v[i];
+		p.VertexCount = 4;
+
+		p.AddFace(0, 1, 2);
+		p.AddFace(0, 3, 1);
+		p.AddFace(0, 2, 3);
+		p.AddFace(1, 3, 2);
+
+		Face Best = p.Faces[0];
+		int Edges[EpaMaxEdges][2];
+
+		for (;;)
+		{
+			int Nearest = 0;
+			for (int f = 1; f < p.FaceCount; f++)
+			{
+				if (p.Faces[f].Distance < p.Faces[Nearest].Distance)
+					Nearest = f;
+			}
+
+			Best = p.Faces[Nearest];
+			r.Iterations++;
+
+			if (Best.Distance == std::numeric_limits<float>::max() || p.VertexCount == EpaMaxVertices)
+				break;
+
+			Vertex w = Support(a, b, Best.Normal);
+			if (w.w.Dot(Best.Normal) - Best.Distance <= EpaTolerance * Scale)
+				break;
+
+			// Remove every face w can see, collecting the edges of the hole they leave.
+			int EdgeCount = 0;
+			bool Overflow = false;
+
+			for (int f = p.FaceCount - 1; f >= 0; f--)
+			{
+				Face const &Visible = p.Faces[f];
+				if (Visible.Normal.Dot(w.w - p.Vertices[Visible.v[0]].w) <= 0.0f)
+					continue;
+
+				for (int e = 0; e < 3; e++)
+				{
+					int From = Visible.v[e], To = Visible.v[(e + 1) % 3];
+
+					int Twin = 0;
+					while (Twin < EdgeCount && !(Edges[Twin][0] == To && Edges[Twin][1] == From))
+						Twin++;
+
+					if (Twin < EdgeCount)
+					{
+						EdgeCount--;
+						Edges[Twin][0] = Edges[EdgeCount][0];
+						Edges[Twin][1] = Edges[EdgeCount][1];
+					}
+					else if (EdgeCount < EpaMaxEdges)
+					{
+						Edges[EdgeCount][0] = From;
+						Edges[EdgeCount][1] = To;
+						EdgeCount++;
+					}
+					else
+						Overflow = true;
+				}
+
+				p.Faces[f] = p.Faces[--p.FaceCount];
+			}
+
+			if (Overflow || p.FaceCount + EdgeCount > EpaMaxFaces)
+				break;
+
+			int Index = p.VertexCount++;
+			p.Vertices[Index] = w;
+			for (int e = 0; e < EdgeCount; e++)
+				p.AddFace(Edges[e][0], Edges[e][1], Index);
+		}
+
+		// The contact is the origin's projection onto the nearest face.
+		Vector3 const &v0 = p.Vertices[Best.v[0]].w;
+		Vector3 const &v1 = p.Vertices[Best.v[1]].w;
+		Vector3 const &v2 = p.Vertices[Best.v[2]].w;
+		Vector3 Projected = Best.Normal * Best.Distance;
+
+		float Lambda[3] = {1.0f, 0.0f, 0.0f};
+		Vector3 e0 = v1 - v0, e1 = v2 - v0, e2 = Projected - v0;
+		float d00 = e0.Dot(e0), d01 = e0.Dot(e1), d11 = e1.Dot(e1), d20 = e2.Dot(e0), d21 = e2.Dot(e1);
+		float Denominator = d00 * d11 - d01 * d01;
+		if (Denominator > 0.0f)
+		{
+			Lambda[1] = (d11 * d20 - d01 * d21) / Denominator;
+			Lambda[2] = (d00 * d21 - d01 * d20) / Denominator;
+			Lambda[0] = 1.0f - Lambda[1] - Lambda[2];
+		}
+
+		r.Distance = std::max(Best.Distance, 0.0f);
+		r.Normal = Best.Normal;
+		r.PointA = r.PointB = Vector3();
+		for (int i = 0; i < 3; i++)
+		{
+			r.PointA += p.Vertices[Best.v[i]].a * Lambda[i];
+			r.PointB += p.Vertices[Best.v[i]].b * Lambda[i];
+		}
+	}
+
+	ConvexContact Query(Convex const &a, Convex const &b, GjkCache *Cache, bool Penetration)
+	{
+		ConvexContact r;
+		Simplex s;
+		float Scale;
+
+		r.Intersecting = Gjk(a, b, Cache, false, s, r.Iterations, Scale);
+		s.Witnesses(r.PointA, r.PointB);
+
+		if (!r.Intersecting)
+		{
+			Vector3 Separation = r.PointB - r.PointA;
+			r.Distance = Separation.Length();
+			if (r.Distance > 0.0f)
+				r.Normal = Separation / r.Distance;
+		}
+		else if (Penetration && Tetrahedron(a, b, s, Scale))
+			Epa(a, b, s, Scale, r);
+
+		return r;
+	}
+}
+
+Vector3 ConvexSphere::Support(Vector3 const &Direction) const
+{
+	float l = Direction.Length();
+	return (l > 0.0f ? Center + Direction * (Radius / l) : Center);
+}
+
+Vector3 ConvexCapsule::Support(Vector3 const &Direction) const
+{
+	float l = Direction.Length();
+	Vector3 End = (Direction.Dot(b - a) > 0.0f ? b : a);
+	return (l > 0.0f ? End + Direction * (Radius / l) : End);
+}
+
+Vector3 ConvexBox::Support(Vector3 const &Direction) const
+{
+	Vector3 Local = Axes.Transposed() * Direction;
+	return Center + Axes * Vector3(Local.x >= 0.0f ? HalfExtents.x : -HalfExtents.x,
+								   Local.y >= 0.0f ? HalfExtents.y : -HalfExtents.y,
+								   Local.z >= 0.0f ? HalfExtents.z : -HalfExtents.z);
+}
+
+Vector3 ConvexHull::Support(Vector3 const &Direction) const
+{
+	if (Count == 0)
+		return Vector3();
+
+	float Best[HullWidth];
+	unsigned int Index[HullWidth];
+	for (int Lane = 0; Lane < HullWidth; Lane++)
+	{
+		Best[Lane] = -std::numeric_limits<float>::max();
+		Index[Lane] = 0;
+	}
+
+	// Lanes past the end re-read the last vertex, which cannot change the answer.
+	for (std::size_t First = 0; First < Count; First += HullWidth)
+	{
+		for (int Lane = 0; Lane < HullWidth; Lane++)
+		{
+			unsigned int i = static_cast<unsigned int>(std::min(First + Lane, Count - 1));
+			float d = Direction.x * x[i] + Direction.y * y[i] + Direction.z * z[i];
+			bool Better = (d > Best[Lane]);
+			Best[Lane] = (Better ? d : Best[Lane]);
+			Index[Lane] = (Better ? i : Index[Lane]);
+		}
+	}
+
+	int Lane = 0;
+	for (int l = 1; l < HullWidth; l++)
+	{
+		if (Best[l] > Best[Lane])
+			Lane = l;
+	}
+
+	unsigned int i = Index[Lane];
+	return Vector3(x[i], y[i], z[i]);
+}
+
+ConvexTransform::ConvexTransform(Convex const &Shape, Quaternion const &Rotation, Vector3 const &Translation) :
+	Shape(Shape),
+	Linear(Rotation),
+	LinearTransposed(Linear.Transposed()),
+	Translation(Translation)
+{
+
+}
+
+ConvexTransform::ConvexTransform(Convex const &Shape, Matrix4 const &Transform) :
+	Shape(Shape),
+	Linear(Transform),
+	LinearTransposed(Linear.Transposed()),
+	Translation(Transform.m[0][3], Transform.m[1][3], Transform.m[2][3])
+{
+
+}
+
+Vector3 ConvexTransform::Support(Vector3 const &Direction) const
+{
+	return Linear * Shape.Support(LinearTransposed * Direction) + Translation;
+}
+
+bool Math::ConvexOverlap(Convex const &a, Convex const &b, GjkCache *Cache)
+{
+	Simplex s;
+	unsigned int Iterations;
+	float Scale;
+	return Gjk(a, b, Cache, true, s, Iterations, Scale);
+}
+
+ConvexContact Math::ConvexDistance(Convex const &a, Convex const &b, GjkCache *Cache)
+{
+	return Query(a, b, Cache, false);
+}
+
+ConvexContact Math::ConvexPenetration(Convex const &a, Convex const &b, GjkCache *Cache)
+{
+	return Query(a, b, Cache, true);
+}
@@ -0,0 +1,154 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#ifndef SMALLMATH_CONVEX
+#define SMALLMATH_CONVEX
+
+#include <cstddef>
+
+#include "math/Bounds.hpp"
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Convex shapes described by their support mapping: Support(d) returns a point of the shape
+	// furthest along d (d need not be unit length, and may be zero).  Any convex shape can take part
+	// in the queries below by deriving from Convex.
+
+	class Convex
+	{
+	public:
+		virtual ~Convex() { }
+
+		virtual Vector3 Support(Vector3 const &Direction) const = 0;
+	};
+
+	class ConvexSphere : public Convex
+	{
+	public:
+		ConvexSphere(Vector3 const &Center, float Radius) : Center(Center), Radius(Radius) { }
+
+		Vector3 Support(Vector3 const &Direction) const;
+
+		Vector3 Center;
+		float Radius;
+	};
+
+	// The points within Radius of the segment [a, b].
+	class ConvexCapsule : public Convex
+	{
+	public:
+		ConvexCapsule(Vector3 const &a, Vector3 const &b, float Radius) : a(a), b(b), Radius(Radius) { }
+
+		Vector3 Support(Vector3 const &Direction) const;
+
+		Vector3 a, b;
+		float Radius;
+	};
+
+	class ConvexBox : public Convex
+	{
+	public:
+		ConvexBox(OBB const &Box) : Center(Box.Center), Axes(Box.Axes()), HalfExtents(Box.HalfExtents) { }
+
+		Vector3 Support(Vector3 const &Direction) const;
+
+		Vector3 Center;
+		Matrix3 Axes;			// Columns are the box axes
+		Vector3 HalfExtents;
+	};
+
+	// The convex hull of Count points held as separate coordinate arrays.  The arrays are not
+	// copied.  Support() scans them eight lanes at a time.
+	class ConvexHull : public Convex
+	{
+	public:
+		ConvexHull(float const *x, float const *y, float const *z, std::size_t Count) : x(x), y(y), z(z), Count(Count) { }
+
+		Vector3 Support(Vector3 const &Direction) const;
+
+		float const *x, *y, *z;
+		std::size_t Count;
+	};
+
+	// Shape placed by an affine transform, Linear * p + Translation.  The shape is referenced, not
+	// copied.
+	class ConvexTransform : public Convex
+	{
+	public:
+		ConvexTransform(Convex const &Shape, Quaternion const &Rotation, Vector3 const &Translation);
+		ConvexTransform(Convex const &Shape, Matrix4 const &Transform);
+
+		Vector3 Support(Vector3 const &Direction) const;
+
+		Convex const &Shape;
+		Matrix3 Linear, LinearTransposed;
+		Vector3 Translation;
+	};
+
+	// Queries ============================================
+
+	// Pass the same cache to successive queries on the same pair.  It keeps the search directions that
+	// produced the last query's final simplex; re-evaluating them against the shapes' new poses gives
+	// the next query a starting simplex that is usually within an iteration or two of the answer.
+	class GjkCache
+	{
+	public:
+		GjkCache() : Count(0) { }
+
+		inline void Clear();
+
+		Vector3 Directions[4];
+		unsigned int Count;
+	};
+
+	class ConvexContact
+	{
+	public:
+		ConvexContact() : Intersecting(false), Distance(0.0f), Iterations(0) { }
+
+		bool Intersecting;
+		float Distance;			// Separation, or penetration depth when Intersecting
+		Vector3 Normal;			// Unit, from a towards b.  Moving b by Distance * Normal resolves a penetration
+		Vector3 PointA, PointB;	// Closest (or deepest) points on each shape
+		unsigned int Iterations;
+	};
+
+	// GJK (Gilbert-Johnson-Keerthi) on the Minkowski difference a - b.  ConvexOverlap() stops as soon
+	// as a separating direction turns up; ConvexDistance() reports the separation and closest points
+	// of disjoint shapes and only Intersecting (with zero distance) otherwise; ConvexPenetration()
+	// continues intersecting cases with EPA (the expanding polytope algorithm) for the depth, normal
+	// and deepest points.  Nothing is allocated: the simplex and polytope live in fixed-size arrays on
+	// the stack, and EPA returns its best estimate if the polytope runs out of room.
+	bool ConvexOverlap(Convex const &a, Convex const &b, GjkCache *Cache = NULL);
+	ConvexContact ConvexDistance(Convex const &a, Convex const &b, GjkCache *Cache = NULL);
+	ConvexContact ConvexPenetration(Convex const &a, Convex const &b, GjkCache *Cache = NULL);
+
+	// Inline methods =====================================
+
+	inline void GjkCache::Clear()
+	{
+		Count = 0;
+	}
+}
+
+#endif
@@ -0,0 +1,185 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_DECOMPOSITION
+#define SMALLMATH_DECOMPOSITION
+
+#include <cmath>
+
+namespace Math
+{
+	// Small dense solvers in double precision, for the fitting and registration code.
+
+	// Eigen-decomposition of a symmetric N x N matrix by cyclic Jacobi rotations.  a is destroyed.
+	// Values are sorted in decreasing order, and column i of Vectors is the unit eigenvector of
+	// Values[i].  Converges to full precision in a handful of sweeps for the sizes used here.
+	template <int N>
+	void SymmetricEigen(double (&a)[N][N], double (&Values)[N], double (&Vectors)[N][N])
+	{
+		for (int i = 0; i < N; i++)
+		{
+			for (int j = 0; j < N; j++)
+				Vectors[i][j] = (i == j ? 1.0 : 0.0);
+		}
+
+		for (int Sweep = 0; Sweep < 50; Sweep++)
+		{
+			double Off = 0.0, Total = 0.0;
+			for (int i = 0; i < N; i++)
+			{
+				for (int j = 0; j < N; j++)
+				{
+					Total += a[i][j] * a[i][j];
+					if (i != j)
+						Off += a[i][j] * a[i][j];
+				}
+			}
+
+			if (Off <= 1.0e-30 * Total || Off == 0.0)
+				break;
+
+			for (int p = 0; p < N - 1; p++)
+			{
+				for (int q = p + 1; q < N; q++)
+				{
+					if (a[p][q] == 0.0)
+						continue;
+
+					// Rotation that zeroes a[p][q] (Golub and Van Loan, 8.4.2)
+					double Theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+					double t = (Theta >= 0.0 ? 1.0 : -1.0) / (std::abs(Theta) + std::sqrt(Theta * Theta + 1.0));
+					double c = 1.0 / std::sqrt(t * t + 1.0);
+					double s = t * c;
+
+					for (int k = 0; k < N; k++)
+					{
+						double akp = a[k][p], akq = a[k][q];
+						a[k][p] = c * akp - s * akq;
+						a[k][q] = s * akp + c * akq;
+					}
+
+					for (int k = 0; k < N; k++)
+					{
+						double apk = a[p][k], aqk = a[q][k];
+						a[p][k] = c * apk - s * aqk;
+						a[q][k] = s * apk + c * aqk;
+					}
+
+					for (int k = 0; k < N; k++)
+					{
+						double vkp = Vectors[k][p], vkq = Vectors[k][q];
+						Vectors[k][p] = c * vkp - s * vkq;
+						Vectors[k][q] = s * vkp + c * vkq;
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < N; i++)
+			Values[i] = a[i][i];
+
+		// Selection sort, largest first
+		for (int i = 0; i < N - 1; i++)
+		{
+			int Largest = i;
+			for (int j = i + 1; j < N; j++)
+			{
+				if (Values[j] > Values[Largest])
+					Largest = j;
+			}
+
+			if (Largest == i)
+				continue;
+
+			double v = Values[i];
+			Values[i] = Values[Largest];
+			Values[Largest] = v;
+
+			for (int k = 0; k < N; k++)
+			{
+				double e = Vectors[k][i];
+				Vectors[k][i] = Vectors[k][Largest];
+				Vectors[k][Largest] = e;
+			}
+		}
+	}
+
+	// Solves a x = b by Gaussian elimination with partial pivoting.  a and b are destroyed.
+	// Returns false if a is singular to working precision.
+	template <int N>
+	bool Solve(double (&a)[N][N], double (&b)[N], double (&x)[N])
+	{
+		double Scale = 0.0;
+		for (int i = 0; i < N; i++)
+		{
+			for (int j = 0; j < N; j++)
+				Scale = (std::abs(a[i][j]) > Scale ? std::abs(a[i][j]) : Scale);
+		}
+
+		if (Scale == 0.0)
+			return false;
+
+		for (int Column = 0; Column < N; Column++)
+		{
+			int Pivot = Column;
+			for (int Row = Column + 1; Row < N; Row++)
+			{
+				if (std::abs(a[Row][Column]) > std::abs(a[Pivot][Column]))
+					Pivot = Row;
+			}
+
+			if (std::abs(a[Pivot][Column]) <= 1.0e-12 * Scale)
+				return false;
+
+			if (Pivot != Column)
+			{
+				for (int k = 0; k < N; k++)
+				{
+					double t = a[Column][k];
+					a[Column][k] = a[Pivot][k];
+					a[Pivot][k] = t;
+				}
+
+				double t = b[Column];
+				b[Column] = b[Pivot];
+				b[Pivot] = t;
+			}
+
+			for (int Row = Column + 1; Row < N; Row++)
+			{
+				double f = a[Row][Column] / a[Column][Column];
+				for (int k = Column; k < N; k++)
+					a[Row][k] -= f * a[Column][k];
+				b[Row] -= f * b[Column];
+			}
+		}
+
+		for (int Row = N - 1; Row >= 0; Row--)
+		{
+			double Sum = b[Row];
+			for (int k = Row + 1; k < N; k++)
+				Sum -= a[Row][k] * x[k];
+			x[Row] = Sum / a[Row][Row];
+		}
+
+		return true;
+	}
+}
+
+#endif
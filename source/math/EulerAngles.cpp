@@ -32,57 +32,283 @@ EulerAngles::EulerAngles(Vector3 const &Vec, TransformOrder Order)
 	EulerAngles::Order = Order;
 }
 
-EulerAngles::EulerAngles(Matrix3 const &Mat)
+EulerAngles::EulerAngles(Matrix3 const &Mat, TransformOrder Order)
 {
-	this->SetFromMatrix3(Mat);
+	switch (Order)
+	{
+	case XYZ:
+		*this = EulerAnglesT<XYZ>(Mat);
+		break;
+	case XZY:
+		*this = EulerAnglesT<XZY>(Mat);
+		break;
+	case YXZ:
+		*this = EulerAnglesT<YXZ>(Mat);
+		break;
+	case YZX:
+		*this = EulerAnglesT<YZX>(Mat);
+		break;
+	case ZXY:
+		*this = EulerAnglesT<ZXY>(Mat);
+		break;
+	default:
+		*this = EulerAnglesT<ZYX>(Mat);
+		break;
+	}
+}
+
+EulerAngles::EulerAngles(Quaternion const &Quat, TransformOrder Order)
+{
+	*this = EulerAngles(Matrix3(Quat), Order);
+}
+
+// Conversions ============================================
+
+Matrix3 EulerAngles::ToMatrix3() const
+{
+	switch (Order)
+	{
+	case XYZ:
+		return EulerAnglesT<XYZ>(x, y, z).ToMatrix3();
+	case XZY:
+		return EulerAnglesT<XZY>(x, y, z).ToMatrix3();
+	case YXZ:
+		return EulerAnglesT<YXZ>(x, y, z).ToMatrix3();
+	case YZX:
+		return EulerAnglesT<YZX>(x, y, z).ToMatrix3();
+	case ZXY:
+		return EulerAnglesT<ZXY>(x, y, z).ToMatrix3();
+	default:
+		return EulerAnglesT<ZYX>(x, y, z).ToMatrix3();
+	}
 }
 
-EulerAngles::EulerAngles(Quaternion const &Quat)
+Quaternion EulerAngles::ToQuaternion() const
 {
-	this->SetFromMatrix3(Matrix3(Quat));
+	switch (Order)
+	{
+	case XYZ:
+		return EulerAnglesT<XYZ>(x, y, z).ToQuaternion();
+	case XZY:
+		return EulerAnglesT<XZY>(x, y, z).ToQuaternion();
+	case YXZ:
+		return EulerAnglesT<YXZ>(x, y, z).ToQuaternion();
+	case YZX:
+		return EulerAnglesT<YZX>(x, y, z).ToQuaternion();
+	case ZXY:
+		return EulerAnglesT<ZXY>(x, y, z).ToQuaternion();
+	default:
+		return EulerAnglesT<ZYX>(x, y, z).ToQuaternion();
+	}
+}
+
+// Fixed order ============================================
+
+namespace
+{
+	// The axes of an order, first applied first, and whether they are an odd permutation of x, y, z.
+	template <EulerAngles::TransformOrder Order>
+	struct Axes
+	{
+		static constexpr int First = (Order == EulerAngles::XYZ || Order == EulerAngles::XZY ? 0 :
+									  Order == EulerAngles::YXZ || Order == EulerAngles::YZX ? 1 : 2);
+		static constexpr int Second = (Order == EulerAngles::YXZ || Order == EulerAngles::ZXY ? 0 :
+									   Order == EulerAngles::XYZ || Order == EulerAngles::ZYX ? 1 : 2);
+		static constexpr int Third = 3 - First - Second;
+		static constexpr float Sign = (Order == EulerAngles::XYZ || Order == EulerAngles::YZX ||
+									   Order == EulerAngles::ZXY ? 1.0f : -1.0f);
+	};
+
+	template <EulerAngles::TransformOrder Order>
+	float const &Angle(EulerAnglesT<Order> const &e, int Axis)
+	{
+		return (Axis == 0 ? e.x : (Axis == 1 ? e.y : e.z));
+	}
+
+	template <EulerAngles::TransformOrder Order>
+	float &Angle(EulerAnglesT<Order> &e, int Axis)
+	{
+		return (Axis == 0 ? e.x : (Axis == 1 ? e.y : e.z));
+	}
+
+	float &Component(Quaternion &q, int Axis)
+	{
+		return (Axis == 0 ? q.x : (Axis == 1 ? q.y : q.z));
+	}
 }
 
-// Private ================================================
+template <EulerAngles::TransformOrder Order>
+EulerAnglesT<Order>::EulerAnglesT(EulerAngles const &Euler)
+{
+	if (Euler.Order == Order)
+		*this = EulerAnglesT(Euler.x, Euler.y, Euler.z);
+	else
+		*this = EulerAnglesT(Euler.ToMatrix3());
+}
 
-void EulerAngles::SetFromMatrix3(Matrix3 const &Mat)
+template <EulerAngles::TransformOrder Order>
+EulerAnglesT<Order>::EulerAnglesT(Matrix3 const &Mat)
 {
+	typedef Axes<Order> A;
+	int const Index[3] = {A::First, A::Second, A::Third};
+
+	// Take the rotation into the frame where the order is XYZ, extract the XYZ angles there, and
+	// map them back.
 	Matrix3 Rotation = Mat.RotationComponent();
-	EulerAngles e1, e2;
+	Matrix3 c;
+	for (int Row = 0; Row < 3; Row++)
+	{
+		for (int Column = 0; Column < 3; Column++)
+			c.m[Row][Column] = Rotation.m[Index[Row]][Index[Column]];
+	}
+
+	float e1[3], e2[3];
 
-	float CosY = std::sqrt(Rotation.m[0][0] * Rotation.m[0][0] + Rotation.m[1][0] * Rotation.m[1][0]);
+	float CosY = std::sqrt(c.m[0][0] * c.m[0][0] + c.m[1][0] * c.m[1][0]);
 
 	if (CosY > 8.0f * std::numeric_limits<float>::epsilon())
 	{
-		e1.x = std::atan2(Rotation.m[2][1], Rotation.m[2][2]);
-		e1.y = std::atan2(-Rotation.m[2][0], CosY);
-		e1.z = std::atan2(Rotation.m[1][0], Rotation.m[0][0]);
+		e1[0] = std::atan2(c.m[2][1], c.m[2][2]);
+		e1[1] = std::atan2(-c.m[2][0], CosY);
+		e1[2] = std::atan2(c.m[1][0], c.m[0][0]);
 
-		e2.x = std::atan2(-Rotation.m[2][1], -Rotation.m[2][2]);
-		e2.y = std::atan2(-Rotation.m[2][0], -CosY);
-		e2.z = std::atan2(-Rotation.m[1][0], -Rotation.m[0][0]);
+		e2[0] = std::atan2(-c.m[2][1], -c.m[2][2]);
+		e2[1] = std::atan2(-c.m[2][0], -CosY);
+		e2[2] = std::atan2(-c.m[1][0], -c.m[0][0]);
 	}
 	else
 	{
-		e1.x = std::atan2(-Rotation.m[1][2], Rotation.m[1][1]);
-		e1.y = std::atan2(-Rotation.m[2][0], CosY);
-		e1.z = 0.0f;
+		e1[0] = std::atan2(-c.m[1][2], c.m[1][1]);
+		e1[1] = std::atan2(-c.m[2][0], CosY);
+		e1[2] = 0.0f;
 
-		e2 = e1;
+		e2[0] = e1[0];
+		e2[1] = e1[1];
+		e2[2] = e1[2];
 	}
 
 	// Select the one with the lowest values
-	if (std::abs(e1.x) + std::abs(e1.y) + std::abs(e1.z) > std::abs(e2.x) + std::abs(e2.y) + std::abs(e2.z))
+	float const *e = (std::abs(e1[0]) + std::abs(e1[1]) + std::abs(e1[2]) >
+					  std::abs(e2[0]) + std::abs(e2[1]) + std::abs(e2[2]) ? e2 : e1);
+
+	for (int Axis = 0; Axis < 3; Axis++)
+		Angle(*this, Index[Axis]) = A::Sign * e[Axis];
+}
+
+template <EulerAngles::TransformOrder Order>
+EulerAnglesT<Order>::EulerAnglesT(Quaternion const &Quat)
+{
+	*this = EulerAnglesT(Matrix3(Quat));
+}
+
+template <EulerAngles::TransformOrder Order>
+Matrix3 EulerAnglesT<Order>::ToMatrix3() const
+{
+	typedef Axes<Order> A;
+	int const Index[3] = {A::First, A::Second, A::Third};
+
+	// ZRotation(c) * YRotation(b) * XRotation(a), written into the permuted rows and columns
+	float a = A::Sign * Angle(*this, A::First);
+	float b = A::Sign * Angle(*this, A::Second);
+	float c = A::Sign * Angle(*this, A::Third);
+
+	float ca = std::cos(a), sa = std::sin(a);
+	float cb = std::cos(b), sb = std::sin(b);
+	float cc = std::cos(c), sc = std::sin(c);
+
+	float const XYZ[3][3] = {{cb * cc, sa * sb * cc - ca * sc, ca * sb * cc + sa * sc},
+							 {cb * sc, sa * sb * sc + ca * cc, ca * sb * sc - sa * cc},
+							 {-sb, sa * cb, ca * cb}};
+
+	Matrix3 r;
+	for (int Row = 0; Row < 3; Row++)
 	{
-		this->x = e2.x;
-		this->y = e2.y;
-		this->z = e2.z;
+		for (int Column = 0; Column < 3; Column++)
+			r.m[Index[Row]][Index[Column]] = XYZ[Row][Column];
 	}
-	else
+
+	return r;
+}
+
+template <EulerAngles::TransformOrder Order>
+Quaternion EulerAnglesT<Order>::ToQuaternion() const
+{
+	typedef Axes<Order> A;
+
+	// ZRotation(c) * YRotation(b) * XRotation(a) in the XYZ frame; the vector part is mapped back
+	// through the permutation, which flips it for odd orders along with the angles.
+	float a = 0.5f * A::Sign * Angle(*this, A::First);
+	float b = 0.5f * A::Sign * Angle(*this, A::Second);
+	float c = 0.5f * A::Sign * Angle(*this, A::Third);
+
+	float ca = std::cos(a), sa = std::sin(a);
+	float cb = std::cos(b), sb = std::sin(b);
+	float cc = std::cos(c), sc = std::sin(c);
+
+	Quaternion r;
+	r.w = ca * cb * cc + sa * sb * sc;
+	Component(r, A::First) = A::Sign * (sa * cb * cc - ca * sb * sc);
+	Component(r, A::Second) = A::Sign * (ca * sb * cc + sa * cb * sc);
+	Component(r, A::Third) = A::Sign * (ca * cb * sc - sa * sb * cc);
+	return r;
+}
+
+namespace Math
+{
+	template class EulerAnglesT<EulerAngles::XYZ>;
+	template class EulerAnglesT<EulerAngles::XZY>;
+	template class EulerAnglesT<EulerAngles::YXZ>;
+	template class EulerAnglesT<EulerAngles::YZX>;
+	template class EulerAnglesT<EulerAngles::ZXY>;
+	template class EulerAnglesT<EulerAngles::ZYX>;
+}
+
+// Text formatting ========================================
+
+namespace
+{
+	char const *const OrderNames[] = {"XYZ", "XZY", "YXZ", "YZX", "ZXY", "ZYX"};
+}
+
+char *Math::Format(char *First, char *Last, EulerAngles const &b)
+{
+	First = Text::Write(First, Last, "((");
+	First = Text::Write(First, Last, b.x);
+	First = Text::Write(First, Last, ", ");
+	First = Text::Write(First, Last, b.y);
+	First = Text::Write(First, Last, ", ");
+	First = Text::Write(First, Last, b.z);
+	First = Text::Write(First, Last, "), ");
+	First = Text::Write(First, Last, OrderNames[b.Order]);
+	return Text::Write(First, Last, ")");
+}
+
+char const *Math::Parse(char const *First, char const *Last, EulerAngles &b)
+{
+	EulerAngles r;
+
+	First = Text::Read(First, Last, " ( (");
+	First = Text::Read(First, Last, r.x);
+	First = Text::Read(First, Last, " , ");
+	First = Text::Read(First, Last, r.y);
+	First = Text::Read(First, Last, " , ");
+	First = Text::Read(First, Last, r.z);
+	First = Text::Read(First, Last, " ) , ");
+
+	if (First == NULL)
+		return NULL;
+
+	char const *End = NULL;
+	for (int Order = EulerAngles::XYZ; Order <= EulerAngles::ZYX && End == NULL; Order++)
 	{
-		this->x = e1.x;
-		this->y = e1.y;
-		this->z = e1.z;
+		End = Text::Read(First, Last, OrderNames[Order]);
+		r.Order = static_cast<EulerAngles::TransformOrder>(Order);
 	}
 
-	this->Order = XYZ;
+	First = Text::Read(End, Last, " )");
+
+	if (First != NULL)
+		b = r;
+
+	return First;
 }
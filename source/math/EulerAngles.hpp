@@ -24,6 +24,7 @@
 
 #include "math/Matrix.hpp"
 #include "math/Quaternion.hpp"
+#include "math/Text.hpp"
 #include "math/Vector.hpp"
 
 namespace Math
@@ -39,48 +40,66 @@ namespace Math
 		EulerAngles() : x(0.0f), y(0.0f), z(0.0f), Order(XYZ) { }
 		EulerAngles(float x, float y, float z, TransformOrder Order = XYZ) : x(x), y(y), z(z), Order(Order) { }
 		EulerAngles(Vector3 const &Vec, TransformOrder Order = XYZ);
-		EulerAngles(Matrix3 const &Mat);
-		EulerAngles(Quaternion const &Quat);
+		EulerAngles(Matrix3 const &Mat, TransformOrder Order = XYZ);
+		EulerAngles(Quaternion const &Quat, TransformOrder Order = XYZ);
 
 		// General operations
 		inline void Set(float x, float y, float z);
 		inline void SetZero();
 
+		// Conversions, dispatched to EulerAnglesT for the order
+		Matrix3 ToMatrix3() const;
+		Quaternion ToQuaternion() const;
+
 		float x, y, z;
 		TransformOrder Order;
+	};
+
+	// Euler angles with the order fixed at compile time: 12 bytes rather than 16, and conversions
+	// with the axis permutation folded into straight-line code.  The orders follow EulerAngles: XYZ
+	// rotates about x first, so its matrix is ZRotation * YRotation * XRotation.
+	//
+	// Every order is the XYZ formula conjugated by the axis permutation, with the angles negated for
+	// odd permutations (a reflection reverses the sense of rotation).  All six orders are
+	// instantiated in EulerAngles.cpp.
+	template <EulerAngles::TransformOrder Order>
+	class EulerAnglesT
+	{
+	public:
+		EulerAnglesT() : x(0.0f), y(0.0f), z(0.0f) { }
+		EulerAnglesT(float x, float y, float z) : x(x), y(y), z(z) { }
+		explicit EulerAnglesT(Vector3 const &Vec) : x(Vec.x), y(Vec.y), z(Vec.z) { }
+		explicit EulerAnglesT(EulerAngles const &Euler);	// Converts if Euler has another order
+		explicit EulerAnglesT(Matrix3 const &Mat);
+		explicit EulerAnglesT(Quaternion const &Quat);
+
+		// Conversions
+		Matrix3 ToMatrix3() const;
+		Quaternion ToQuaternion() const;
+		inline operator EulerAngles() const;
 
-	private:
-		void SetFromMatrix3(Matrix3 const &Mat);
+		float x, y, z;
 	};
 
+	extern template class EulerAnglesT<EulerAngles::XYZ>;
+	extern template class EulerAnglesT<EulerAngles::XZY>;
+	extern template class EulerAnglesT<EulerAngles::YXZ>;
+	extern template class EulerAnglesT<EulerAngles::YZX>;
+	extern template class EulerAnglesT<EulerAngles::ZXY>;
+	extern template class EulerAnglesT<EulerAngles::ZYX>;
+
+	// Text formatting ====================================
+
+	char *Format(char *First, char *Last, EulerAngles const &b);
+	char const *Parse(char const *First, char const *Last, EulerAngles &b);
+
 	// Stream print =======================================
 
 	inline std::ostream &operator<<(std::ostream &a, EulerAngles const &b)
 	{
-		a << "((" << b.x << ", " << b.y << ", " << b.z << "), ";
-
-		switch (b.Order)
-		{
-		case EulerAngles::XYZ:
-			a << "XYZ";
-			break;
-		case EulerAngles::XZY:
-			a << "XZY";
-			break;
-		case EulerAngles::YXZ:
-			a << "YXZ";
-			break;
-		case EulerAngles::YZX:
-			a << "YZX";
-			break;
-		case EulerAngles::ZXY:
-			a << "ZXY";
-			break;
-		case EulerAngles::ZYX:
-			a << "ZYX";
-		}
-
-		a << ")";
+		char Buffer[Text::MaxLength];
+		char *End = Format(Buffer, Buffer + sizeof(Buffer), b);
+		a.write(Buffer, End - Buffer);
 		return a;
 	}
 
@@ -99,6 +118,12 @@ namespace Math
 		y = 0.0f;
 		z = 0.0f;
 	}
+
+	template <EulerAngles::TransformOrder Order>
+	inline EulerAnglesT<Order>::operator EulerAngles() const
+	{
+		return EulerAngles(x, y, z, Order);
+	}
 }
 
 #endif
@@ -0,0 +1,365 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#ifndef SMALLMATH_EXPRESSION
+#define SMALLMATH_EXPRESSION
+
+#include <cstddef>
+#include <type_traits>
+
+#include "math/Matrix.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Opt-in expression templates for component-wise arithmetic.  Wrapping operands in Lazy() makes
+	// +, -, * and / build a description of the expression instead of a chain of temporaries; the
+	// whole expression is then computed in a single pass by Evaluate() or Assign():
+	//
+	//	Vector3 r = Evaluate<Vector3>(Lazy(a) * s + Lazy(b) * t - Lazy(c));
+	//
+	// The same expressions work over arrays: with float pointers wrapped in Lazy(),
+	// Evaluate(Out, Count, e) runs one loop over i computing e at element i, which the compiler can
+	// vectorize with no intermediate arrays.  Output may alias an input only if it is the same
+	// element of the same array.
+	//
+	// Unlike Vector4's operators, which treat it as a point and set w to 1, expressions act on all
+	// four components.  Expressions hold references to their vector and array operands, so evaluate
+	// them within the statement that builds them.
+
+	template <class Derived>
+	class VectorExpression
+	{
+	public:
+		inline Derived const &Self() const { return static_cast<Derived const &>(*this); }
+	};
+
+	// Number of components of a vector type.  Scalars and arrays have none: they fit any expression.
+	template <class V> struct Dimension;
+	template <> struct Dimension<Vector2> { static const int Value = 2; };
+	template <> struct Dimension<Vector3> { static const int Value = 3; };
+	template <> struct Dimension<Vector4> { static const int Value = 4; };
+
+	// Terminals ==========================================
+
+	template <class V>
+	class VectorTerminal : public VectorExpression<VectorTerminal<V> >
+	{
+	public:
+		static const int Size = Dimension<V>::Value;
+
+		explicit VectorTerminal(V const &v) : v(v) { }
+		inline float operator[](std::size_t Index) const { return v[static_cast<int>(Index)]; }
+
+	private:
+		V const &v;
+	};
+
+	class ScalarTerminal : public VectorExpression<ScalarTerminal>
+	{
+	public:
+		static const int Size = 0;
+
+		explicit ScalarTerminal(float Value) : Value(Value) { }
+		inline float operator[](std::size_t) const { return Value; }
+
+	private:
+		float Value;
+	};
+
+	class ArrayTerminal : public VectorExpression<ArrayTerminal>
+	{
+	public:
+		static const int Size = 0;
+
+		explicit ArrayTerminal(float const *Data) : Data(Data) { }
+		inline float operator[](std::size_t Index) const { return Data[Index]; }
+
+	private:
+		float const *Data;
+	};
+
+	inline VectorTerminal<Vector2> Lazy(Vector2 const &v) { return VectorTerminal<Vector2>(v); }
+	inline VectorTerminal<Vector3> Lazy(Vector3 const &v) { return VectorTerminal<Vector3>(v); }
+	inline VectorTerminal<Vector4> Lazy(Vector4 const &v) { return VectorTerminal<Vector4>(v); }
+	inline ArrayTerminal Lazy(float const *Data) { return ArrayTerminal(Data); }
+
+	// Operations =========================================
+
+	struct AddOperation { static inline float Apply(float a, float b) { return a + b; } };
+	struct SubtractOperation { static inline float Apply(float a, float b) { return a - b; } };
+	struct MultiplyOperation { static inline float Apply(float a, float b) { return a * b; } };
+	struct DivideOperation { static inline float Apply(float a, float b) { return a / b; } };
+
+	// Operands are held by value; terminals are only a reference or a float.
+	template <class L, class R, class Operation>
+	class BinaryExpression : public VectorExpression<BinaryExpression<L, R, Operation> >
+	{
+	public:
+		static_assert(L::Size == 0 || R::Size == 0 || L::Size == R::Size, "Operands have different dimensions");
+		static const int Size = (L::Size != 0 ? L::Size : R::Size);
+
+		BinaryExpression(L const &a, R const &b) : a(a), b(b) { }
+		inline float operator[](std::size_t Index) const { return Operation::Apply(a[Index], b[Index]); }
+
+	private:
+		L a;
+		R b;
+	};
+
+	template <class E>
+	class NegateExpression : public VectorExpression<NegateExpression<E> >
+	{
+	public:
+		static const int Size = E::Size;
+
+		explicit NegateExpression(E const &a) : a(a) { }
+		inline float operator[](std::size_t Index) const { return -a[Index]; }
+
+	private:
+		E a;
+	};
+
+	template <class E>
+	inline NegateExpression<E> operator-(VectorExpression<E> const &a)
+	{
+		return NegateExpression<E>(a.Self());
+	}
+
+	template <class L, class R>
+	inline BinaryExpression<L, R, AddOperation> operator+(VectorExpression<L> const &a, VectorExpression<R> const &b)
+	{
+		return BinaryExpression<L, R, AddOperation>(a.Self(), b.Self());
+	}
+
+	template <class L>
+	inline BinaryExpression<L, ScalarTerminal, AddOperation> operator+(VectorExpression<L> const &a, float b)
+	{
+		return BinaryExpression<L, ScalarTerminal, AddOperation>(a.Self(), ScalarTerminal(b));
+	}
+
+	template <class R>
+	inline BinaryExpression<ScalarTerminal, R, AddOperation> operator+(float a, VectorExpression<R> const &b)
+	{
+		return BinaryExpression<ScalarTerminal, R, AddOperation>(ScalarTerminal(a), b.Self());
+	}
+
+	template <class L, class R>
+	inline BinaryExpression<L, R, SubtractOperation> operator-(VectorExpression<L> const &a, VectorExpression<R> const &b)
+	{
+		return BinaryExpression<L, R, SubtractOperation>(a.Self(), b.Self());
+	}
+
+	template <class L>
+	inline BinaryExpression<L, ScalarTerminal, SubtractOperation> operator-(VectorExpression<L> const &a, float b)
+	{
+		return BinaryExpression<L, ScalarTerminal, SubtractOperation>(a.Self(), ScalarTerminal(b));
+	}
+
+	template <class R>
+	inline BinaryExpression<ScalarTerminal, R, SubtractOperation> operator-(float a, VectorExpression<R> const &b)
+	{
+		return BinaryExpression<ScalarTerminal, R, SubtractOperation>(ScalarTerminal(a), b.Self());
+	}
+
+	template <class L, class R>
+	inline BinaryExpression<L, R, MultiplyOperation> operator*(VectorExpression<L> const &a, VectorExpression<R> const &b)
+	{
+		return BinaryExpression<L, R, MultiplyOperation>(a.Self(), b.Self());
+	}
+
+	template <class L>
+	inline BinaryExpression<L, ScalarTerminal, MultiplyOperation> operator*(VectorExpression<L> const &a, float b)
+	{
+		return BinaryExpression<L, ScalarTerminal, MultiplyOperation>(a.Self(), ScalarTerminal(b));
+	}
+
+	template <class R>
+	inline BinaryExpression<ScalarTerminal, R, MultiplyOperation> operator*(float a, VectorExpression<R> const &b)
+	{
+		return BinaryExpression<ScalarTerminal, R, MultiplyOperation>(ScalarTerminal(a), b.Self());
+	}
+
+	template <class L, class R>
+	inline BinaryExpression<L, R, DivideOperation> operator/(VectorExpression<L> const &a, VectorExpression<R> const &b)
+	{
+		return BinaryExpression<L, R, DivideOperation>(a.Self(), b.Self());
+	}
+
+	template <class L>
+	inline BinaryExpression<L, ScalarTerminal, DivideOperation> operator/(VectorExpression<L> const &a, float b)
+	{
+		return BinaryExpression<L, ScalarTerminal, DivideOperation>(a.Self(), ScalarTerminal(b));
+	}
+
+	template <class R>
+	inline BinaryExpression<ScalarTerminal, R, DivideOperation> operator/(float a, VectorExpression<R> const &b)
+	{
+		return BinaryExpression<ScalarTerminal, R, DivideOperation>(ScalarTerminal(a), b.Self());
+	}
+
+	// Evaluation =========================================
+
+	template <class V, class E>
+	inline V &Assign(V &Out, VectorExpression<E> const &e)
+	{
+		static_assert(E::Size == Dimension<V>::Value, "Expression and vector have different dimensions");
+
+		// Compute every component before storing any, so Out may also appear in the expression.
+		float r[Dimension<V>::Value];
+		for (int Index = 0; Index < Dimension<V>::Value; Index++)
+			r[Index] = e.Self()[Index];
+		for (int Index = 0; Index < Dimension<V>::Value; Index++)
+			Out[Index] = r[Index];
+
+		return Out;
+	}
+
+	template <class V, class E>
+	inline V Evaluate(VectorExpression<E> const &e)
+	{
+		V r;
+		return Assign(r, e);
+	}
+
+	template <class E>
+	inline void Evaluate(float *Out, std::size_t Count, VectorExpression<E> const &e)
+	{
+		static_assert(E::Size == 0, "Array expressions cannot contain vectors");
+
+		E const &Expression = e.Self();
+		for (std::size_t Index = 0; Index < Count; Index++)
+			Out[Index] = Expression[Index];
+	}
+
+	// Matrix chains ======================================
+
+	// Lazy(A) * Lazy(B) * Lazy(C) records the chain without multiplying.  Applied to a vector it
+	// becomes successive matrix-vector products, A * (B * (C * v)), so a chain of k matrices costs k
+	// matrix-vector products instead of k - 1 matrix products plus one (48 multiplies rather than
+	// 144 for three Matrix4s).  TransformArray() applies a chain to an array, folding it into one
+	// matrix first whenever that is cheaper for the given count.  Evaluate<Matrix4>() folds it
+	// outright.  A Vector3 through a Matrix4 chain is a point: it goes in with w = 1 and, as with
+	// Vector3(Vector4), the w that comes out is dropped.  Like vector expressions, chains refer to
+	// their matrices, so use them within the statement.
+
+	template <class Derived>
+	class MatrixExpression
+	{
+	public:
+		inline Derived const &Self() const { return static_cast<Derived const &>(*this); }
+	};
+
+	// Multiplies in a product of two matrices, and in a matrix-vector product.
+	template <class M> struct MatrixCost;
+	template <> struct MatrixCost<Matrix3> { static const int Product = 27, Vector = 9; };
+	template <> struct MatrixCost<Matrix4> { static const int Product = 64, Vector = 16; };
+
+	// The vector a chain of M actually multiplies when applied to a V
+	template <class M, class V> struct ChainVector { typedef V Type; };
+	template <> struct ChainVector<Matrix4, Vector3> { typedef Vector4 Type; };
+
+	template <class M>
+	class MatrixTerminal : public MatrixExpression<MatrixTerminal<M> >
+	{
+	public:
+		typedef M Matrix;
+		static const int Length = 1;
+
+		explicit MatrixTerminal(M const &m) : m(m) { }
+
+		template <class V>
+		inline V Apply(V const &v) const { return m * v; }
+		inline M Fold() const { return m; }
+
+	private:
+		M const &m;
+	};
+
+	template <class L, class R>
+	class MatrixChain : public MatrixExpression<MatrixChain<L, R> >
+	{
+	public:
+		typedef typename L::Matrix Matrix;
+		static_assert(std::is_same<typename L::Matrix, typename R::Matrix>::value, "Chained matrices have different dimensions");
+		static const int Length = L::Length + R::Length;
+
+		MatrixChain(L const &a, R const &b) : a(a), b(b) { }
+
+		template <class V>
+		inline V Apply(V const &v) const { return a.Apply(b.Apply(v)); }
+		inline Matrix Fold() const { return a.Fold() * b.Fold(); }
+
+	private:
+		L a;
+		R b;
+	};
+
+	inline MatrixTerminal<Matrix3> Lazy(Matrix3 const &m) { return MatrixTerminal<Matrix3>(m); }
+	inline MatrixTerminal<Matrix4> Lazy(Matrix4 const &m) { return MatrixTerminal<Matrix4>(m); }
+
+	template <class L, class R>
+	inline MatrixChain<L, R> operator*(MatrixExpression<L> const &a, MatrixExpression<R> const &b)
+	{
+		return MatrixChain<L, R>(a.Self(), b.Self());
+	}
+
+	template <class E>
+	inline Vector3 operator*(MatrixExpression<E> const &e, Vector3 const &v)
+	{
+		typedef typename ChainVector<typename E::Matrix, Vector3>::Type Lifted;
+		return Vector3(e.Self().Apply(Lifted(v)));
+	}
+
+	template <class E>
+	inline Vector4 operator*(MatrixExpression<E> const &e, Vector4 const &v)
+	{
+		return e.Self().Apply(v);
+	}
+
+	template <class M, class E>
+	inline M Evaluate(MatrixExpression<E> const &e)
+	{
+		return e.Self().Fold();
+	}
+
+	template <class E, class V>
+	inline void TransformArray(MatrixExpression<E> const &e, V const *In, std::size_t Count, V *Out)
+	{
+		typedef typename E::Matrix Matrix;
+		typedef typename ChainVector<Matrix, V>::Type Lifted;
+		typedef MatrixCost<Matrix> Cost;
+
+		E const &Chain = e.Self();
+		if (E::Length > 1 && Count * (E::Length - 1) * Cost::Vector > (E::Length - 1) * Cost::Product)
+		{
+			Matrix m = Chain.Fold();
+			for (std::size_t Index = 0; Index < Count; Index++)
+				Out[Index] = V(m * Lifted(In[Index]));
+		}
+		else
+		{
+			for (std::size_t Index = 0; Index < Count; Index++)
+				Out[Index] = V(Chain.Apply(Lifted(In[Index])));
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,249 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#endif
+
+#include "math/FloatingPoint.hpp"
+
+using namespace Math;
+
+namespace
+{
+	// Control register access ============================
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	unsigned long long const FlushMode = 0x8040;		// FTZ (bit 15) and DAZ (bit 6) in MXCSR
+
+	unsigned long long ReadControl()
+	{
+		return _mm_getcsr();
+	}
+
+	void WriteControl(unsigned long long Value)
+	{
+		_mm_setcsr(static_cast<unsigned int>(Value));
+	}
+#elif defined(__aarch64__)
+	unsigned long long const FlushMode = 1ull << 24;	// FZ in FPCR, which covers inputs and results
+
+	unsigned long long ReadControl()
+	{
+		unsigned long long Value;
+		__asm__ __volatile__("mrs %0, fpcr" : "=r"(Value));
+		return Value;
+	}
+
+	void WriteControl(unsigned long long Value)
+	{
+		__asm__ __volatile__("msr fpcr, %0" : : "r"(Value));
+	}
+#else
+	unsigned long long const FlushMode = 0;
+
+	unsigned long long ReadControl()
+	{
+		return 0;
+	}
+
+	void WriteControl(unsigned long long)
+	{
+
+	}
+#endif
+
+	// Checked build ======================================
+
+#if defined(SMALLMATH_CHECKED)
+	bool const Checked = true;
+#else
+	bool const Checked = false;
+#endif
+
+	std::mutex ReportMutex;
+	FloatReport Report;
+
+	int const ScanWidth = 8;
+
+	std::uint32_t const MagnitudeMask = 0x7FFFFFFFu;
+	std::uint32_t const ExponentMask = 0x7F800000u;
+	std::uint32_t const MantissaMask = 0x007FFFFFu;
+}
+
+DenormalGuard::DenormalGuard() :
+	Saved(ReadControl())
+{
+	// Writing the register can stall the pipeline, so skip it when the mode is already set (as it
+	// is for nested guards).
+	if ((Saved & FlushMode) != FlushMode)
+		WriteControl(Saved | FlushMode);
+}
+
+DenormalGuard::~DenormalGuard()
+{
+	if ((Saved & FlushMode) != FlushMode)
+		WriteControl(Saved);
+}
+
+bool DenormalGuard::Flushes()
+{
+	return (FlushMode != 0);
+}
+
+FloatReport Math::CheckFloats(float const *Values, std::size_t Count, std::size_t Components)
+{
+	FloatReport r;
+	std::size_t Total = Count * Components;
+
+	// Classify by bit pattern, which is immune to the flush mode and to fast-math assumptions.  With
+	// the sign cleared, a value is a NaN or an infinity at or above ExponentMask, and a denormal if it
+	// is nonzero and below the smallest normal.  Clean output, the common case, costs one branch-free
+	// pass; the counts and First are only worked out once something has been found.
+	std::uint32_t Invalid[ScanWidth] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+	for (std::size_t Index = 0; Index < Total; Index += ScanWidth)
+	{
+		// The tail is padded with zeros, which are valid.
+		std::uint32_t Bits[ScanWidth] = {0, 0, 0, 0, 0, 0, 0, 0};
+		if (Total - Index >= static_cast<std::size_t>(ScanWidth))
+			std::memcpy(Bits, Values + Index, sizeof(Bits));
+		else
+			std::memcpy(Bits, Values + Index, (Total - Index) * sizeof(float));
+
+		std::uint32_t Magnitude[ScanWidth];
+		for (int Lane = 0; Lane < ScanWidth; Lane++)
+			Magnitude[Lane] = Bits[Lane] & MagnitudeMask;
+
+		for (int Lane = 0; Lane < ScanWidth; Lane++)
+			Invalid[Lane] |= (Magnitude[Lane] >= ExponentMask) | (Magnitude[Lane] - 1u < MantissaMask);
+	}
+
+	std::uint32_t Any = 0;
+	for (int Lane = 0; Lane < ScanWidth; Lane++)
+		Any |= Invalid[Lane];
+
+	if (Any == 0)
+		return r;
+
+	for (std::size_t Index = 0; Index < Total; Index++)
+	{
+		std::uint32_t Magnitude;
+		std::memcpy(&Magnitude, Values + Index, sizeof(float));
+		Magnitude &= MagnitudeMask;
+
+		bool Nan = (Magnitude > ExponentMask);
+		bool Infinity = (Magnitude == ExponentMask);
+		bool Denormal = (Magnitude - 1u < MantissaMask);
+
+		r.NaNs += Nan;
+		r.Infinities += Infinity;
+		r.Denormals += Denormal;
+
+		if ((Nan || Infinity || Denormal) && r.First == FloatReport::NoIndex)
+			r.First = Index / Components;
+	}
+
+	return r;
+}
+
+bool Math::AnyNonFinite(float const *Values, std::size_t Count)
+{
+	// v * 0 is a NaN exactly when v is a NaN or an infinity, and zero otherwise, so the sum of
+	// them is nonzero exactly when one was found.  Four independent sums hide the add latency.
+	std::size_t Blocked = Count / 16 * 16;
+	float Sum = 0.0f;
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	__m128 Zero = _mm_setzero_ps();
+	__m128 s0 = Zero, s1 = Zero, s2 = Zero, s3 = Zero;
+
+	for (std::size_t Index = 0; Index < Blocked; Index += 16)
+	{
+		s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(Values + Index), Zero));
+		s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(Values + Index + 4), Zero));
+		s2 = _mm_add_ps(s2, _mm_mul_ps(_mm_loadu_ps(Values + Index + 8), Zero));
+		s3 = _mm_add_ps(s3, _mm_mul_ps(_mm_loadu_ps(Values + Index + 12), Zero));
+	}
+
+	float Lanes[4];
+	_mm_storeu_ps(Lanes, _mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3)));
+	Sum = (Lanes[0] + Lanes[1]) + (Lanes[2] + Lanes[3]);
+#else
+	float Sums[ScanWidth] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+	for (std::size_t Index = 0; Index < Blocked; Index += ScanWidth)
+	{
+		for (int Lane = 0; Lane < ScanWidth; Lane++)
+			Sums[Lane] += Values[Index + Lane] * 0.0f;
+	}
+
+	for (int Lane = 0; Lane < ScanWidth; Lane++)
+		Sum += Sums[Lane];
+#endif
+
+	for (std::size_t Index = Blocked; Index < Count; Index++)
+		Sum += Values[Index] * 0.0f;
+
+	return (Sum != 0.0f);
+}
+
+bool Math::CheckedBuild()
+{
+	return Checked;
+}
+
+FloatReport Math::CheckedReport()
+{
+	std::lock_guard<std::mutex> Lock(ReportMutex);
+	return Report;
+}
+
+void Math::ResetCheckedReport()
+{
+	std::lock_guard<std::mutex> Lock(ReportMutex);
+	Report = FloatReport();
+}
+
+void Math::CheckOutput(char const *Kernel, float const *Values, std::size_t Count, std::size_t Components, std::size_t Offset)
+{
+	if (!Checked)
+		return;
+
+	FloatReport r = CheckFloats(Values, Count, Components);
+	if (r.IsClean())
+		return;
+
+	std::lock_guard<std::mutex> Lock(ReportMutex);
+
+	Report.NaNs += r.NaNs;
+	Report.Infinities += r.Infinities;
+	Report.Denormals += r.Denormals;
+
+	if (Report.First == FloatReport::NoIndex)
+	{
+		Report.Kernel = Kernel;
+		Report.First = Offset + r.First;
+	}
+}
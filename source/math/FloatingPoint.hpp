@@ -0,0 +1,96 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#ifndef SMALLMATH_FLOATINGPOINT
+#define SMALLMATH_FLOATINGPOINT
+
+#include <cstddef>
+
+namespace Math
+{
+	// Flushes denormal results to zero and treats denormal inputs as zero (FTZ and DAZ in the SSE
+	// control register, FZ in the ARM one) on the current thread until it goes out of scope, then
+	// restores the previous mode.  Denormal arithmetic is slower by an order of magnitude or more on
+	// most hardware, and values that small are noise in anything this library computes.  Every
+	// range handed out by Parallel::For() runs under one, so the batch routines flush on all of their
+	// threads; platforms without such a mode make it a no-op.
+	class DenormalGuard
+	{
+	public:
+		DenormalGuard();
+		~DenormalGuard();
+
+		static bool Flushes();		// False where the guard is a no-op
+
+	private:
+		DenormalGuard(DenormalGuard const &);
+		DenormalGuard &operator=(DenormalGuard const &);
+
+		unsigned long long Saved;
+	};
+
+	// Counts of invalid values in some output.  First is the index of the first element holding
+	// one, or NoIndex if there were none.
+	class FloatReport
+	{
+	public:
+		static const std::size_t NoIndex = static_cast<std::size_t>(-1);
+
+		FloatReport() : NaNs(0), Infinities(0), Denormals(0), Kernel(NULL), First(NoIndex) { }
+
+		inline bool IsClean() const;
+
+		std::size_t NaNs, Infinities, Denormals;
+		char const *Kernel;			// The routine that produced First, for the checked build report
+		std::size_t First;
+	};
+
+	// Scans Count elements of Components floats each, eight floats at a time, without branching on
+	// individual values.
+	FloatReport CheckFloats(float const *Values, std::size_t Count, std::size_t Components = 1);
+
+	// True if any of Count floats is a NaN or an infinity.  A cheaper first pass than CheckFloats()
+	// for output computed under a flushing DenormalGuard, which cannot hold denormals.
+	bool AnyNonFinite(float const *Values, std::size_t Count);
+
+	// Checked build ======================================
+
+	// Configuring with CHECKED_BUILD makes the batch routines (Project, KdTree::Nearest, FitRigid,
+	// FitOBB) scan their float outputs before returning and add what they find to a process-wide
+	// report.  The report keeps the totals and the kernel and element index of the first offense
+	// since the last reset.  Otherwise CheckOutput() does nothing and the report stays clean.
+	bool CheckedBuild();
+	FloatReport CheckedReport();
+	void ResetCheckedReport();
+
+	// Used by the batch routines; Values holds Count elements of Components floats each.  Routines
+	// that check their output a block at a time pass the block's first element as Offset.
+	void CheckOutput(char const *Kernel, float const *Values, std::size_t Count, std::size_t Components = 1,
+					 std::size_t Offset = 0);
+
+	// Inline methods =====================================
+
+	inline bool FloatReport::IsClean() const
+	{
+		return (NaNs == 0 && Infinities == 0 && Denormals == 0);
+	}
+}
+
+#endif
@@ -0,0 +1,40 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#include "math/Generic.hpp"
+
+namespace Math
+{
+	template class Vector<2, float>;
+	template class Vector<3, float>;
+	template class Vector<4, float>;
+	template class Vector<2, double>;
+	template class Vector<3, double>;
+	template class Vector<4, double>;
+	template class Vector<2, int>;
+	template class Vector<3, int>;
+	template class Vector<4, int>;
+	template class Matrix<2, 2, float>;
+	template class Matrix<3, 3, float>;
+	template class Matrix<4, 4, float>;
+	template class Matrix<2, 2, double>;
+	template class Matrix<3, 3, double>;
+	template class Matrix<4, 4, double>;
+}
@@ -0,0 +1,569 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#ifndef SMALLMATH_GENERIC
+#define SMALLMATH_GENERIC
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "math/Matrix.hpp"
+#include "math/Vector.hpp"
+
+// SSE kernels for four floats need to step aside during constant evaluation
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define SMALLMATH_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#elif defined(_MSC_VER) && _MSC_VER >= 1925
+#define SMALLMATH_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+#if defined(SMALLMATH_CONSTANT_EVALUATED) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define SMALLMATH_GENERIC_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Math
+{
+	// Dimension- and scalar-generic vectors and matrices, usable in constant expressions.  Every
+	// operation is written once as a compile-time unrolled loop over the components (a fold over an
+	// index sequence), so the same kernel serves every size and scalar type.  Matrices are arrays of
+	// row vectors and their products are sums of scaled rows, which keeps the inner loops in the
+	// vector kernels.
+	//
+	// Where SSE is available, Vector<4, float> and Matrix<4, 4, float> specialize their element-wise
+	// operators and the matrix product to work on whole registers (see the end of this file).
+	//
+	// These sit beside Vector2/3/4 and Matrix2/3/4 rather than replacing them: the fixed classes keep
+	// their behaviour (Vector4's point semantics in particular) and the two convert explicitly.
+	// Vector3d, Matrix4d and friends are the double precision instantiations.
+
+	// Storage alignment.  Four floats or two doubles fill a 16-byte SIMD register and four doubles a
+	// 32-byte one, so those vectors (and matrix rows of that size) load and store whole.
+	template <int N, class T> struct VectorAlignment { static const std::size_t Value = alignof(T); };
+	template <> struct VectorAlignment<4, float> { static const std::size_t Value = 16; };
+	template <> struct VectorAlignment<2, double> { static const std::size_t Value = 16; };
+	template <> struct VectorAlignment<4, double> { static const std::size_t Value = 32; };
+
+	template <int N, class T = float>
+	class alignas(VectorAlignment<N, T>::Value) Vector
+	{
+	public:
+		static_assert(N > 0, "Vectors need at least one component");
+		typedef T Scalar;
+		static const int Size = N;
+
+		constexpr Vector() : v{} { }
+		template <class... A, typename std::enable_if<sizeof...(A) == N, int>::type = 0>
+		constexpr Vector(A... a) : v{static_cast<T>(a)...} { }
+		template <class U>
+		constexpr explicit Vector(Vector<N, U> const &b) : Vector(Generate([&b](int i) { return static_cast<T>(b[i]); })) { }
+
+		// Conversions from and to the fixed float classes
+		template <int M = N, typename std::enable_if<M == 2, int>::type = 0>
+		constexpr explicit Vector(Vector2 const &b) : v{static_cast<T>(b.x), static_cast<T>(b.y)} { }
+		template <int M = N, typename std::enable_if<M == 3, int>::type = 0>
+		constexpr explicit Vector(Vector3 const &b) : v{static_cast<T>(b.x), static_cast<T>(b.y), static_cast<T>(b.z)} { }
+		template <int M = N, typename std::enable_if<M == 4, int>::type = 0>
+		constexpr explicit Vector(Vector4 const &b) : v{static_cast<T>(b.x), static_cast<T>(b.y), static_cast<T>(b.z), static_cast<T>(b.w)} { }
+		template <int M = N, typename std::enable_if<M == 2, int>::type = 0>
+		explicit operator Vector2() const { return Vector2(static_cast<float>(v[0]), static_cast<float>(v[1])); }
+		template <int M = N, typename std::enable_if<M == 3, int>::type = 0>
+		explicit operator Vector3() const { return Vector3(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2])); }
+		template <int M = N, typename std::enable_if<M == 4, int>::type = 0>
+		explicit operator Vector4() const { return Vector4(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]), static_cast<float>(v[3])); }
+
+		// Builds a vector from f(0), f(1), ..., f(N - 1).
+		template <class F>
+		static constexpr Vector Generate(F f) { return Generate(f, std::make_index_sequence<N>()); }
+		static constexpr Vector Filled(T Value) { return Generate([Value](int) { return Value; }); }
+
+		// General operations
+		constexpr T Dot(Vector const &b) const { return Sum([this, &b](int i) { return v[i] * b.v[i]; }); }
+		constexpr T LengthSquared() const { return this->Dot(*this); }
+		T Length() const { return static_cast<T>(std::sqrt(this->LengthSquared())); }
+		Vector Normalized() const { return *this / this->Length(); }
+		constexpr Vector Lerp(Vector const &b, T t) const { return *this + (b - *this) * t; }
+		template <int M = N>
+		constexpr typename std::enable_if<M == 3, Vector>::type Cross(Vector const &b) const
+		{
+			return Vector(v[1] * b.v[2] - v[2] * b.v[1], v[2] * b.v[0] - v[0] * b.v[2], v[0] * b.v[1] - v[1] * b.v[0]);
+		}
+
+		// Subscription operators
+		constexpr T operator[](int Index) const { return v[Index]; }
+		constexpr T &operator[](int Index) { return v[Index]; }
+
+		// Arithmetic operators
+		constexpr Vector operator-() const { return Generate([this](int i) { return -v[i]; }); }
+		constexpr Vector operator+(Vector const &b) const { return Generate([this, &b](int i) { return v[i] + b.v[i]; }); }
+		constexpr Vector operator-(Vector const &b) const { return Generate([this, &b](int i) { return v[i] - b.v[i]; }); }
+		constexpr Vector operator*(Vector const &b) const { return Generate([this, &b](int i) { return v[i] * b.v[i]; }); }
+		constexpr Vector operator/(Vector const &b) const { return Generate([this, &b](int i) { return v[i] / b.v[i]; }); }
+		constexpr Vector operator*(T b) const { return Generate([this, b](int i) { return v[i] * b; }); }
+		constexpr Vector operator/(T b) const { return Generate([this, b](int i) { return v[i] / b; }); }
+		constexpr Vector &operator+=(Vector const &b) { return *this = *this + b; }
+		constexpr Vector &operator-=(Vector const &b) { return *this = *this - b; }
+		constexpr Vector &operator*=(Vector const &b) { return *this = *this * b; }
+		constexpr Vector &operator/=(Vector const &b) { return *this = *this / b; }
+		constexpr Vector &operator*=(T b) { return *this = *this * b; }
+		constexpr Vector &operator/=(T b) { return *this = *this / b; }
+
+		// Equality operators
+		constexpr bool operator==(Vector const &b) const { return All([this, &b](int i) { return v[i] == b.v[i]; }); }
+		constexpr bool operator!=(Vector const &b) const { return !(*this == b); }
+
+		T v[N];
+
+	private:
+		template <class F, std::size_t... I>
+		static constexpr Vector Generate(F f, std::index_sequence<I...>) { return Vector(f(static_cast<int>(I))...); }
+		template <class F, std::size_t... I>
+		static constexpr T Sum(F f, std::index_sequence<I...>) { return (f(static_cast<int>(I)) + ...); }
+		template <class F, std::size_t... I>
+		static constexpr bool All(F f, std::index_sequence<I...>) { return (f(static_cast<int>(I)) && ...); }
+		template <class F>
+		static constexpr T Sum(F f) { return Sum(f, std::make_index_sequence<N>()); }
+		template <class F>
+		static constexpr bool All(F f) { return All(f, std::make_index_sequence<N>()); }
+	};
+
+	template <int N, class T>
+	constexpr Vector<N, T> operator*(T a, Vector<N, T> const &b)
+	{
+		return b * a;
+	}
+
+	// R rows by C columns.  Default constructed matrices are the identity (ones on the diagonal).
+	template <int R, int C, class T = float>
+	class Matrix
+	{
+	public:
+		static_assert(R > 0 && C > 0, "Matrices need at least one row and column");
+		typedef T Scalar;
+		typedef Vector<C, T> Row;
+		static const int Rows = R, Columns = C;
+
+		constexpr Matrix() : m{}
+		{
+			for (int i = 0; i < R && i < C; i++)
+				m[i][i] = T(1);
+		}
+
+		// Row-major element list
+		template <class... A, typename std::enable_if<sizeof...(A) == R * C && (R * C > 1), int>::type = 0>
+		constexpr Matrix(A... a) : m{}
+		{
+			T const e[] = {static_cast<T>(a)...};
+			for (int i = 0; i < R; i++)
+			{
+				for (int j = 0; j < C; j++)
+					m[i][j] = e[i * C + j];
+			}
+		}
+
+		template <class U>
+		constexpr explicit Matrix(Matrix<R, C, U> const &b) : m{}
+		{
+			for (int i = 0; i < R; i++)
+				m[i] = Row(b[i]);
+		}
+
+		// Conversions from and to the fixed float classes
+		template <int M = R, typename std::enable_if<M == 2 && C == 2, int>::type = 0>
+		explicit Matrix(Matrix2 const &b) : m{} { Load(b); }
+		template <int M = R, typename std::enable_if<M == 3 && C == 3, int>::type = 0>
+		explicit Matrix(Matrix3 const &b) : m{} { Load(b); }
+		template <int M = R, typename std::enable_if<M == 4 && C == 4, int>::type = 0>
+		explicit Matrix(Matrix4 const &b) : m{} { Load(b); }
+		template <int M = R, typename std::enable_if<M == 2 && C == 2, int>::type = 0>
+		explicit operator Matrix2() const { Matrix2 r; Store(r); return r; }
+		template <int M = R, typename std::enable_if<M == 3 && C == 3, int>::type = 0>
+		explicit operator Matrix3() const { Matrix3 r; Store(r); return r; }
+		template <int M = R, typename std::enable_if<M == 4 && C == 4, int>::type = 0>
+		explicit operator Matrix4() const { Matrix4 r; Store(r); return r; }
+
+		static constexpr Matrix Zero()
+		{
+			Matrix r;
+			for (int i = 0; i < R; i++)
+				r.m[i] = Row();
+			return r;
+		}
+
+		// General operations
+		constexpr Matrix<C, R, T> Transposed() const
+		{
+			Matrix<C, R, T> r;
+			for (int i = 0; i < C; i++)
+			{
+				for (int j = 0; j < R; j++)
+					r[i][j] = m[j][i];
+			}
+			return r;
+		}
+
+		// The matrix without one row and column
+		template <int M = R, typename std::enable_if<(M > 1 && C > 1), int>::type = 0>
+		constexpr Matrix<R - 1, C - 1, T> Minor(int Row, int Column) const
+		{
+			Matrix<R - 1, C - 1, T> r;
+			for (int i = 0, a = 0; i < R; i++)
+			{
+				if (i == Row)
+					continue;
+				for (int j = 0, b = 0; j < C; j++)
+				{
+					if (j != Column)
+						r[a][b++] = m[i][j];
+				}
+				a++;
+			}
+			return r;
+		}
+
+		// Cofactor expansion along the first row, unrolled at compile time
+		template <int M = R>
+		constexpr typename std::enable_if<M == C, T>::type Determinant() const
+		{
+			if constexpr (R == 1)
+				return m[0][0];
+			else if constexpr (R == 2)
+				return m[0][0] * m[1][1] - m[0][1] * m[1][0];
+			else
+			{
+				T d = T(0);
+				for (int j = 0; j < C; j++)
+				{
+					T Term = m[0][j] * this->Minor(0, j).Determinant();
+					d += (j & 1 ? -Term : Term);
+				}
+				return d;
+			}
+		}
+
+		// The permanent of |M|: the determinant's expansion with every product taken positively, which
+		// bounds its rounding error
+		template <int M = R>
+		constexpr typename std::enable_if<M == C, T>::type Magnitude() const
+		{
+			if constexpr (R == 1)
+				return (m[0][0] < T(0) ? -m[0][0] : m[0][0]);
+			else
+			{
+				T p = T(0);
+				for (int j = 0; j < C; j++)
+				{
+					T e = (m[0][j] < T(0) ? -m[0][j] : m[0][j]);
+					p += e * this->Minor(0, j).Magnitude();
+				}
+				return p;
+			}
+		}
+
+		// Adjugate over determinant.  Returns the identity if the matrix is singular, meaning its
+		// determinant is within R epsilon of Magnitude().  The test scales with the matrix, so small
+		// invertible matrices are kept, and rank-deficient ones whose determinant rounds to a small
+		// nonzero value are caught.
+		template <int M = R>
+		constexpr typename std::enable_if<M == C, Matrix>::type Inverted() const
+		{
+			T d = this->Determinant();
+			if ((d < T(0) ? -d : d) <= std::numeric_limits<T>::epsilon() * T(R) * this->Magnitude())
+				return Matrix();
+
+			Matrix r;
+			if constexpr (R == 1)
+				r.m[0][0] = T(1) / d;
+			else
+			{
+				for (int i = 0; i < R; i++)
+				{
+					for (int j = 0; j < C; j++)
+					{
+						T Cofactor = this->Minor(j, i).Determinant();
+						r.m[i][j] = ((i + j) & 1 ? -Cofactor : Cofactor) / d;
+					}
+				}
+			}
+			return r;
+		}
+
+		// Access methods
+		constexpr Row const &operator[](int Index) const { return m[Index]; }
+		constexpr Row &operator[](int Index) { return m[Index]; }
+		constexpr Row GetRow(int Index) const { return m[Index]; }
+		constexpr void SetRow(int Index, Row const &b) { m[Index] = b; }
+		constexpr Vector<R, T> GetColumn(int Index) const { return Vector<R, T>::Generate([this, Index](int i) { return m[i][Index]; }); }
+		constexpr void SetColumn(int Index, Vector<R, T> const &b)
+		{
+			for (int i = 0; i < R; i++)
+				m[i][Index] = b[i];
+		}
+
+		// Arithmetic operators
+		constexpr Matrix operator+(Matrix const &b) const
+		{
+			Matrix r;
+			for (int i = 0; i < R; i++)
+				r.m[i] = m[i] + b.m[i];
+			return r;
+		}
+
+		constexpr Matrix operator-(Matrix const &b) const
+		{
+			Matrix r;
+			for (int i = 0; i < R; i++)
+				r.m[i] = m[i] - b.m[i];
+			return r;
+		}
+
+		constexpr Matrix operator*(T b) const
+		{
+			Matrix r;
+			for (int i = 0; i < R; i++)
+				r.m[i] = m[i] * b;
+			return r;
+		}
+
+		// Row i of the product is the rows of b weighted by row i of this matrix.
+		template <int K>
+		constexpr Matrix<R, K, T> operator*(Matrix<C, K, T> const &b) const
+		{
+			Matrix<R, K, T> r;
+			for (int i = 0; i < R; i++)
+			{
+				Vector<K, T> Sum = b[0] * m[i][0];
+				for (int k = 1; k < C; k++)
+					Sum += b[k] * m[i][k];
+				r[i] = Sum;
+			}
+			return r;
+		}
+
+		constexpr Vector<R, T> operator*(Vector<C, T> const &b) const
+		{
+			return Vector<R, T>::Generate([this, &b](int i) { return m[i].Dot(b); });
+		}
+
+		constexpr Matrix &operator+=(Matrix const &b) { return *this = *this + b; }
+		constexpr Matrix &operator-=(Matrix const &b) { return *this = *this - b; }
+		constexpr Matrix &operator*=(T b) { return *this = *this * b; }
+		template <int M = R>
+		constexpr typename std::enable_if<M == C, Matrix &>::type operator*=(Matrix const &b) { return *this = *this * b; }
+
+		// Equality operators
+		constexpr bool operator==(Matrix const &b) const
+		{
+			for (int i = 0; i < R; i++)
+			{
+				if (m[i] != b.m[i])
+					return false;
+			}
+			return true;
+		}
+
+		constexpr bool operator!=(Matrix const &b) const { return !(*this == b); }
+
+		Row m[R];
+
+	private:
+		template <class F>
+		void Load(F const &b)
+		{
+			for (int i = 0; i < R; i++)
+			{
+				for (int j = 0; j < C; j++)
+					m[i][j] = static_cast<T>(b.m[i][j]);
+			}
+		}
+
+		template <class F>
+		void Store(F &b) const
+		{
+			for (int i = 0; i < R; i++)
+			{
+				for (int j = 0; j < C; j++)
+					b.m[i][j] = static_cast<float>(m[i][j]);
+			}
+		}
+	};
+
+#if defined(SMALLMATH_GENERIC_SSE)
+	// SSE specializations ================================
+
+	// Each lane does the same operations in the same order as the generic kernel, so results are
+	// bit-identical to it, and tables built at compile time match those built at run time.  Rows
+	// of four floats are 16-byte aligned (VectorAlignment above), so they load and store whole.
+	// Matrix * Vector stays generic: it would need a transpose per call, and the compiler already
+	// vectorizes the generic loop across calls.
+
+	template <>
+	constexpr Vector<4, float> Vector<4, float>::operator-() const
+	{
+		if (SMALLMATH_CONSTANT_EVALUATED())
+			return Vector(-v[0], -v[1], -v[2], -v[3]);
+
+		Vector r;
+		_mm_store_ps(r.v, _mm_xor_ps(_mm_load_ps(v), _mm_set1_ps(-0.0f)));
+		return r;
+	}
+
+	template <>
+	constexpr Vector<4, float> Vector<4, float>::operator+(Vector const &b) const
+	{
+		if (SMALLMATH_CONSTANT_EVALUATED())
+			return Vector(v[0] + b.v[0], v[1] + b.v[1], v[2] + b.v[2], v[3] + b.v[3]);
+
+		Vector r;
+		_mm_store_ps(r.v, _mm_add_ps(_mm_load_ps(v), _mm_load_ps(b.v)));
+		return r;
+	}
+
+	template <>
+	constexpr Vector<4, float> Vector<4, float>::operator-(Vector const &b) const
+	{
+		if (SMALLMATH_CONSTANT_EVALUATED())
+			return Vector(v[0] - b.v[0], v[1] - b.v[1], v[2] - b.v[2], v[3] - b.v[3]);
+
+		Vector r;
+		_mm_store_ps(r.v, _mm_sub_ps(_mm_load_ps(v), _mm_load_ps(b.v)));
+		return r;
+	}
+
+	template <>
+	constexpr Vector<4, float> Vector<4, float>::operator*(Vector const &b) const
+	{
+		if (SMALLMATH_CONSTANT_EVALUATED())
+			return Vector(v[0] * b.v[0], v[1] * b.v[1], v[2] * b.v[2], v[3] * b.v[3]);
+
+		Vector r;
+		_mm_store_ps(r.v, _mm_mul_ps(_mm_load_ps(v), _mm_load_ps(b.v)));
+		return r;
+	}
+
+	template <>
+	constexpr Vector<4, float> Vector<4, float>::operator/(Vector const &b) const
+	{
+		if (SMALLMATH_CONSTANT_EVALUATED())
+			return Vector(v[0] / b.v[0], v[1] / b.v[1], v[2] / b.v[2], v[3] / b.v[3]);
+
+		Vector r;
+		_mm_store_ps(r.v, _mm_div_ps(_mm_load_ps(v), _mm_load_ps(b.v)));
+		return r;
+	}
+
+	template <>
+	constexpr Vector<4, float> Vector<4, float>::operator*(float b) const
+	{
+		if (SMALLMATH_CONSTANT_EVALUATED())
+			return Vector(v[0] * b, v[1] * b, v[2] * b, v[3] * b);
+
+		Vector r;
+		_mm_store_ps(r.v, _mm_mul_ps(_mm_load_ps(v), _mm_set1_ps(b)));
+		return r;
+	}
+
+	template <>
+	constexpr Vector<4, float> Vector<4, float>::operator/(float b) const
+	{
+		if (SMALLMATH_CONSTANT_EVALUATED())
+			return Vector(v[0] / b, v[1] / b, v[2] / b, v[3] / b);
+
+		Vector r;
+		_mm_store_ps(r.v, _mm_div_ps(_mm_load_ps(v), _mm_set1_ps(b)));
+		return r;
+	}
+
+	template <>
+	constexpr bool Vector<4, float>::operator==(Vector const &b) const
+	{
+		if (SMALLMATH_CONSTANT_EVALUATED())
+			return (v[0] == b.v[0] && v[1] == b.v[1] && v[2] == b.v[2] && v[3] == b.v[3]);
+
+		return (_mm_movemask_ps(_mm_cmpeq_ps(_mm_load_ps(v), _mm_load_ps(b.v))) == 0xF);
+	}
+
+	// Row i of the product is the rows of b weighted by row i of this matrix, as in the generic
+	// kernel, with the weights broadcast across the lanes.
+	template <>
+	template <>
+	constexpr Matrix<4, 4, float> Matrix<4, 4, float>::operator*<4>(Matrix const &b) const
+	{
+		Matrix r;
+
+		if (SMALLMATH_CONSTANT_EVALUATED())
+		{
+			for (int i = 0; i < 4; i++)
+				r.m[i] = b.m[0] * m[i][0] + b.m[1] * m[i][1] + b.m[2] * m[i][2] + b.m[3] * m[i][3];
+			return r;
+		}
+
+		__m128 b0 = _mm_load_ps(b.m[0].v);
+		__m128 b1 = _mm_load_ps(b.m[1].v);
+		__m128 b2 = _mm_load_ps(b.m[2].v);
+		__m128 b3 = _mm_load_ps(b.m[3].v);
+
+		for (int i = 0; i < 4; i++)
+		{
+			__m128 Sum = _mm_mul_ps(b0, _mm_set1_ps(m[i][0]));
+			Sum = _mm_add_ps(Sum, _mm_mul_ps(b1, _mm_set1_ps(m[i][1])));
+			Sum = _mm_add_ps(Sum, _mm_mul_ps(b2, _mm_set1_ps(m[i][2])));
+			Sum = _mm_add_ps(Sum, _mm_mul_ps(b3, _mm_set1_ps(m[i][3])));
+			_mm_store_ps(r.m[i].v, Sum);
+		}
+
+		return r;
+	}
+#endif
+
+	typedef Vector<2, double> Vector2d;
+	typedef Vector<3, double> Vector3d;
+	typedef Vector<4, double> Vector4d;
+	typedef Vector<2, int> Vector2i;
+	typedef Vector<3, int> Vector3i;
+	typedef Vector<4, int> Vector4i;
+	typedef Matrix<2, 2, double> Matrix2d;
+	typedef Matrix<3, 3, double> Matrix3d;
+	typedef Matrix<4, 4, double> Matrix4d;
+
+	// Compiled once in Generic.cpp
+	extern template class Vector<2, float>;
+	extern template class Vector<3, float>;
+	extern template class Vector<4, float>;
+	extern template class Vector<2, double>;
+	extern template class Vector<3, double>;
+	extern template class Vector<4, double>;
+	extern template class Vector<2, int>;
+	extern template class Vector<3, int>;
+	extern template class Vector<4, int>;
+	extern template class Matrix<2, 2, float>;
+	extern template class Matrix<3, 3, float>;
+	extern template class Matrix<4, 4, float>;
+	extern template class Matrix<2, 2, double>;
+	extern template class Matrix<3, 3, double>;
+	extern template class Matrix<4, 4, double>;
+}
+
+#endif
@@ -0,0 +1,327 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "math/Geometry.hpp"
+
+using namespace Math;
+
+namespace
+{
+	// The ray's dominant axis becomes z, and the triangle is sheared so the ray points straight
+	// down it.  Intersection then reduces to 2D edge functions around the origin.
+	struct ShearedRay
+	{
+		ShearedRay(Vector3 const &Direction)
+		{
+			float ax = std::abs(Direction.x);
+			float ay = std::abs(Direction.y);
+			float az = std::abs(Direction.z);
+
+			kz = (ax > ay ? (ax > az ? 0 : 2) : (ay > az ? 1 : 2));
+			kx = (kz + 1) % 3;
+			ky = (kx + 1) % 3;
+
+			// Keep the winding of the edge functions consistent.
+			if (Direction[kz] < 0.0f)
+				std::swap(kx, ky);
+
+			Sx = Direction[kx] / Direction[kz];
+			Sy = Direction[ky] / Direction[kz];
+			Sz = 1.0f / Direction[kz];
+		}
+
+		int kx, ky, kz;
+		float Sx, Sy, Sz;
+	};
+
+	inline float Pick(int k, float x, float y, float z)
+	{
+		return (k == 0 ? x : (k == 1 ? y : z));
+	}
+
+	// Triangle vertices in ray space, one lane per ray/triangle pair.
+	template <int Width>
+	struct Lanes
+	{
+		float Ax[Width], Ay[Width], Az[Width];
+		float Bx[Width], By[Width], Bz[Width];
+		float Cx[Width], Cy[Width], Cz[Width];
+		float TMin[Width], TMax[Width];
+	};
+
+	template <int Width>
+	unsigned int Resolve(Lanes<Width> const &l, unsigned int const *Ids, HitPacket<Width> &Hits)
+	{
+		float U[Width], V[Width], W[Width];
+
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			U[Lane] = l.Cx[Lane] * l.By[Lane] - l.Cy[Lane] * l.Bx[Lane];
+			V[Lane] = l.Ax[Lane] * l.Cy[Lane] - l.Ay[Lane] * l.Cx[Lane];
+			W[Lane] = l.Bx[Lane] * l.Ay[Lane] - l.By[Lane] * l.Ax[Lane];
+		}
+
+		// An exactly zero edge function means the ray is on (or within rounding of) an edge, which
+		// is where float cancellation could let a ray slip between two triangles.
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			if (U[Lane] == 0.0f || V[Lane] == 0.0f || W[Lane] == 0.0f)
+			{
+				U[Lane] = static_cast<float>(static_cast<double>(l.Cx[Lane]) * l.By[Lane] - static_cast<double>(l.Cy[Lane]) * l.Bx[Lane]);
+				V[Lane] = static_cast<float>(static_cast<double>(l.Ax[Lane]) * l.Cy[Lane] - static_cast<double>(l.Ay[Lane]) * l.Cx[Lane]);
+				W[Lane] = static_cast<float>(static_cast<double>(l.Bx[Lane]) * l.Ay[Lane] - static_cast<double>(l.By[Lane]) * l.Ax[Lane]);
+			}
+		}
+
+		unsigned int Mask = 0;
+
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			bool Negative = (U[Lane] < 0.0f) | (V[Lane] < 0.0f) | (W[Lane] < 0.0f);
+			bool Positive = (U[Lane] > 0.0f) | (V[Lane] > 0.0f) | (W[Lane] > 0.0f);
+
+			float Det = U[Lane] + V[Lane] + W[Lane];
+			float T = U[Lane] * l.Az[Lane] + V[Lane] * l.Bz[Lane] + W[Lane] * l.Cz[Lane];
+			float Rcp = 1.0f / (Det != 0.0f ? Det : 1.0f);
+			float t = T * Rcp;
+
+			bool Valid = !(Negative & Positive) & (Det != 0.0f) &
+						 (t >= l.TMin[Lane]) & (t <= l.TMax[Lane]) & (t < Hits.Distance[Lane]);
+
+			Hits.Distance[Lane] = (Valid ? t : Hits.Distance[Lane]);
+			Hits.u[Lane] = (Valid ? V[Lane] * Rcp : Hits.u[Lane]);
+			Hits.v[Lane] = (Valid ? W[Lane] * Rcp : Hits.v[Lane]);
+			Hits.Id[Lane] = (Valid ? Ids[Lane] : Hits.Id[Lane]);
+
+			Mask |= static_cast<unsigned int>(Valid) << Lane;
+		}
+
+		return Mask;
+	}
+}
+
+bool Math::Intersect(Ray const &r, Triangle const &t, unsigned int Id, Hit &Result)
+{
+	ShearedRay s(r.Direction);
+
+	Vector3 A = t.v0 - r.Origin;
+	Vector3 B = t.v1 - r.Origin;
+	Vector3 C = t.v2 - r.Origin;
+
+	Lanes<1> l;
+	l.Ax[0] = A[s.kx] - s.Sx * A[s.kz];
+	l.Ay[0] = A[s.ky] - s.Sy * A[s.kz];
+	l.Az[0] = s.Sz * A[s.kz];
+	l.Bx[0] = B[s.kx] - s.Sx * B[s.kz];
+	l.By[0] = B[s.ky] - s.Sy * B[s.kz];
+	l.Bz[0] = s.Sz * B[s.kz];
+	l.Cx[0] = C[s.kx] - s.Sx * C[s.kz];
+	l.Cy[0] = C[s.ky] - s.Sy * C[s.kz];
+	l.Cz[0] = s.Sz * C[s.kz];
+	l.TMin[0] = r.TMin;
+	l.TMax[0] = r.TMax;
+
+	HitPacket<1> h;
+	h.Distance[0] = Result.Distance;
+	h.u[0] = Result.u;
+	h.v[0] = Result.v;
+	h.Id[0] = Result.Id;
+
+	if (Resolve(l, &Id, h) == 0)
+		return false;
+
+	Result = h.Get(0);
+	return true;
+}
+
+template <int Width>
+unsigned int Math::Intersect(RayPacket<Width> const &Rays, Triangle const &t, unsigned int Id, HitPacket<Width> &Hits)
+{
+	Lanes<Width> l;
+	unsigned int Ids[Width];
+
+	for (int Lane = 0; Lane < Width; Lane++)
+	{
+		// Each lane has its own shear; pick the permuted components with selects.
+		float dx = Rays.DirectionX[Lane], dy = Rays.DirectionY[Lane], dz = Rays.DirectionZ[Lane];
+		float ax = std::abs(dx), ay = std::abs(dy), az = std::abs(dz);
+
+		int kz = (ax > ay ? (ax > az ? 0 : 2) : (ay > az ? 1 : 2));
+		int kx = (kz == 2 ? 0 : kz + 1);
+		int ky = (kx == 2 ? 0 : kx + 1);
+
+		float DirZ = Pick(kz, dx, dy, dz);
+		int Swap = (DirZ < 0.0f);
+		int sx = (Swap ? ky : kx);
+		int sy = (Swap ? kx : ky);
+
+		float Sz = 1.0f / DirZ;
+		float Sx = Pick(sx, dx, dy, dz) * Sz;
+		float Sy = Pick(sy, dx, dy, dz) * Sz;
+
+		float Ax = t.v0.x - Rays.OriginX[Lane], Ay = t.v0.y - Rays.OriginY[Lane], Az = t.v0.z - Rays.OriginZ[Lane];
+		float Bx = t.v1.x - Rays.OriginX[Lane], By = t.v1.y - Rays.OriginY[Lane], Bz = t.v1.z - Rays.OriginZ[Lane];
+		float Cx = t.v2.x - Rays.OriginX[Lane], Cy = t.v2.y - Rays.OriginY[Lane], Cz = t.v2.z - Rays.OriginZ[Lane];
+
+		float Akz = Pick(kz, Ax, Ay, Az), Bkz = Pick(kz, Bx, By, Bz), Ckz = Pick(kz, Cx, Cy, Cz);
+
+		l.Ax[Lane] = Pick(sx, Ax, Ay, Az) - Sx * Akz;
+		l.Ay[Lane] = Pick(sy, Ax, Ay, Az) - Sy * Akz;
+		l.Az[Lane] = Sz * Akz;
+		l.Bx[Lane] = Pick(sx, Bx, By, Bz) - Sx * Bkz;
+		l.By[Lane] = Pick(sy, Bx, By, Bz) - Sy * Bkz;
+		l.Bz[Lane] = Sz * Bkz;
+		l.Cx[Lane] = Pick(sx, Cx, Cy, Cz) - Sx * Ckz;
+		l.Cy[Lane] = Pick(sy, Cx, Cy, Cz) - Sy * Ckz;
+		l.Cz[Lane] = Sz * Ckz;
+		l.TMin[Lane] = Rays.TMin[Lane];
+		l.TMax[Lane] = Rays.TMax[Lane];
+
+		Ids[Lane] = Id;
+	}
+
+	return Resolve(l, Ids, Hits);
+}
+
+template <int Width>
+unsigned int Math::Intersect(Ray const &r, TriangleArrays const &Triangles, std::size_t First, HitPacket<Width> &Hits)
+{
+	ShearedRay s(r.Direction);
+
+	float Origin[3] = {r.Origin.x, r.Origin.y, r.Origin.z};
+	float const *v0[3] = {Triangles.x0, Triangles.y0, Triangles.z0};
+	float const *v1[3] = {Triangles.x1, Triangles.y1, Triangles.z1};
+	float const *v2[3] = {Triangles.x2, Triangles.y2, Triangles.z2};
+
+	std::size_t Active = (First < Triangles.Count ? Triangles.Count - First : 0);
+	if (Active > static_cast<std::size_t>(Width))
+		Active = Width;
+
+	Lanes<Width> l;
+	unsigned int Ids[Width];
+
+	Hits.Clear();
+
+	if (Active == 0)
+		return 0;
+
+	for (int Lane = 0; Lane < Width; Lane++)
+	{
+		// Lanes past the end reread the last triangle and are masked off through TMax.
+		bool Inside = (static_cast<std::size_t>(Lane) < Active);
+		std::size_t Index = First + (Inside ? Lane : Active - 1);
+
+		float Akz = v0[s.kz][Index] - Origin[s.kz];
+		float Bkz = v1[s.kz][Index] - Origin[s.kz];
+		float Ckz = v2[s.kz][Index] - Origin[s.kz];
+
+		l.Ax[Lane] = (v0[s.kx][Index] - Origin[s.kx]) - s.Sx * Akz;
+		l.Ay[Lane] = (v0[s.ky][Index] - Origin[s.ky]) - s.Sy * Akz;
+		l.Az[Lane] = s.Sz * Akz;
+		l.Bx[Lane] = (v1[s.kx][Index] - Origin[s.kx]) - s.Sx * Bkz;
+		l.By[Lane] = (v1[s.ky][Index] - Origin[s.ky]) - s.Sy * Bkz;
+		l.Bz[Lane] = s.Sz * Bkz;
+		l.Cx[Lane] = (v2[s.kx][Index] - Origin[s.kx]) - s.Sx * Ckz;
+		l.Cy[Lane] = (v2[s.ky][Index] - Origin[s.ky]) - s.Sy * Ckz;
+		l.Cz[Lane] = s.Sz * Ckz;
+		l.TMin[Lane] = r.TMin;
+		l.TMax[Lane] = (Inside ? r.TMax : -std::numeric_limits<float>::max());
+
+		Ids[Lane] = static_cast<unsigned int>(First + Lane);
+	}
+
+	return Resolve(l, Ids, Hits);
+}
+
+bool Math::IntersectClosest(Ray const &r, TriangleArrays const &Triangles, Hit &Result)
+{
+	Ray Shrinking = r;
+	HitPacket<8> Hits;
+	bool Found = false;
+
+	for (std::size_t First = 0; First < Triangles.Count; First += 8)
+	{
+		if (Intersect(Shrinking, Triangles, First, Hits) == 0)
+			continue;
+
+		for (int Lane = 0; Lane < 8; Lane++)
+		{
+			if (Hits.Id[Lane] != NoHit && Hits.Distance[Lane] < Result.Distance)
+			{
+				Result = Hits.Get(Lane);
+				Shrinking.TMax = Result.Distance;
+				Found = true;
+			}
+		}
+	}
+
+	return Found;
+}
+
+// Closest point ==========================================
+
+// Voronoi region walk from Ericson's Real-Time Collision Detection, 5.1.5.
+Vector3 Math::ClosestPoint(Triangle const &t, Vector3 const &p)
+{
+	Vector3 ab = t.v1 - t.v0;
+	Vector3 ac = t.v2 - t.v0;
+	Vector3 ap = p - t.v0;
+
+	float d1 = ab.Dot(ap);
+	float d2 = ac.Dot(ap);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+		return t.v0;
+
+	Vector3 bp = p - t.v1;
+	float d3 = ab.Dot(bp);
+	float d4 = ac.Dot(bp);
+	if (d3 >= 0.0f && d4 <= d3)
+		return t.v1;
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		return t.v0 + ab * (d1 / (d1 - d3));
+
+	Vector3 cp = p - t.v2;
+	float d5 = ab.Dot(cp);
+	float d6 = ac.Dot(cp);
+	if (d6 >= 0.0f && d5 <= d6)
+		return t.v2;
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		return t.v0 + ac * (d2 / (d2 - d6));
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		return t.v1 + (t.v2 - t.v1) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	float Denominator = 1.0f / (va + vb + vc);
+	return t.v0 + ab * (vb * Denominator) + ac * (vc * Denominator);
+}
+
+// Explicit instantiations ================================
+
+template unsigned int Math::Intersect<4>(RayPacket<4> const &, Triangle const &, unsigned int, HitPacket<4> &);
+template unsigned int Math::Intersect<8>(RayPacket<8> const &, Triangle const &, unsigned int, HitPacket<8> &);
+template unsigned int Math::Intersect<4>(Ray const &, TriangleArrays const &, std::size_t, HitPacket<4> &);
+template unsigned int Math::Intersect<8>(Ray const &, TriangleArrays const &, std::size_t, HitPacket<8> &);
@@ -0,0 +1,199 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_GEOMETRY
+#define SMALLMATH_GEOMETRY
+
+#include <cstddef>
+#include <limits>
+
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Ray/triangle queries.  Barycentrics follow Moller-Trumbore: a hit point is
+	// (1 - u - v) * v0 + u * v1 + v * v2.  Edge tests use the watertight formulation of Woop et al.
+	// (ray-space shear, edge functions recomputed in double when they come out exactly zero), so a
+	// ray through a shared edge or vertex hits at least one of the adjacent triangles.
+	//
+	// The packet kernels are written as fixed-width lane loops over SoA data so that the compiler
+	// can keep each stage in 4 or 8 wide vector registers.
+
+	static const unsigned int NoHit = 0xFFFFFFFFu;
+
+	class Ray
+	{
+	public:
+		Ray() : TMin(0.0f), TMax(std::numeric_limits<float>::max()) { }
+		Ray(Vector3 const &Origin, Vector3 const &Direction,
+			float TMin = 0.0f, float TMax = std::numeric_limits<float>::max()) :
+			Origin(Origin), Direction(Direction), TMin(TMin), TMax(TMax) { }
+
+		inline Vector3 At(float t) const;
+
+		Vector3 Origin;
+		Vector3 Direction;
+		float TMin, TMax;
+	};
+
+	class Triangle
+	{
+	public:
+		Triangle() { }
+		Triangle(Vector3 const &v0, Vector3 const &v1, Vector3 const &v2) : v0(v0), v1(v1), v2(v2) { }
+
+		inline Vector3 Normal() const;		// Unnormalized, (v1 - v0) x (v2 - v0)
+		inline Vector3 Point(float u, float v) const;
+
+		Vector3 v0, v1, v2;
+	};
+
+	struct Hit
+	{
+		Hit() : Distance(std::numeric_limits<float>::max()), u(0.0f), v(0.0f), Id(NoHit) { }
+
+		float Distance;
+		float u, v;
+		unsigned int Id;
+	};
+
+	// Structure-of-arrays views ==========================
+
+	// A triangle soup with every vertex component in its own array, Count entries each.
+	struct TriangleArrays
+	{
+		float const *x0, *y0, *z0;
+		float const *x1, *y1, *z1;
+		float const *x2, *y2, *z2;
+		std::size_t Count;
+	};
+
+	template <int Width>
+	struct RayPacket
+	{
+		inline void Set(int Lane, Ray const &r);
+		inline Ray Get(int Lane) const;
+
+		float OriginX[Width], OriginY[Width], OriginZ[Width];
+		float DirectionX[Width], DirectionY[Width], DirectionZ[Width];
+		float TMin[Width], TMax[Width];
+	};
+
+	template <int Width>
+	struct HitPacket
+	{
+		inline void Clear();
+		inline Hit Get(int Lane) const;
+
+		float Distance[Width];
+		float u[Width], v[Width];
+		unsigned int Id[Width];
+	};
+
+	typedef RayPacket<4> RayPacket4;
+	typedef RayPacket<8> RayPacket8;
+	typedef HitPacket<4> HitPacket4;
+	typedef HitPacket<8> HitPacket8;
+
+	// Intersection =======================================
+
+	// Single ray, single triangle.  Updates Result and returns true on a hit closer than Result
+	// (and within the ray's [TMin, TMax]).
+	bool Intersect(Ray const &r, Triangle const &t, unsigned int Id, Hit &Result);
+
+	// Many rays against one triangle.  Lanes whose ray hits closer than the lane's current hit
+	// are updated; the returned bitmask has bit n set for every lane that was.
+	template <int Width>
+	unsigned int Intersect(RayPacket<Width> const &Rays, Triangle const &t, unsigned int Id, HitPacket<Width> &Hits);
+
+	// One ray against Triangles[First, First + Width).  Lane n of Hits receives the result for
+	// triangle First + n (Id is NoHit on a miss); missing triangles past Count never hit.
+	template <int Width>
+	unsigned int Intersect(Ray const &r, TriangleArrays const &Triangles, std::size_t First, HitPacket<Width> &Hits);
+
+	// One ray against every triangle in the arrays, keeping the closest hit.
+	bool IntersectClosest(Ray const &r, TriangleArrays const &Triangles, Hit &Result);
+
+	// Closest point ======================================
+
+	Vector3 ClosestPoint(Triangle const &t, Vector3 const &p);
+
+	// Inline methods =====================================
+
+	inline Vector3 Ray::At(float t) const
+	{
+		return Origin + Direction * t;
+	}
+
+	inline Vector3 Triangle::Normal() const
+	{
+		return (v1 - v0).Cross(v2 - v0);
+	}
+
+	inline Vector3 Triangle::Point(float u, float v) const
+	{
+		return v0 * (1.0f - u - v) + v1 * u + v2 * v;
+	}
+
+	template <int Width>
+	inline void RayPacket<Width>::Set(int Lane, Ray const &r)
+	{
+		OriginX[Lane] = r.Origin.x;
+		OriginY[Lane] = r.Origin.y;
+		OriginZ[Lane] = r.Origin.z;
+		DirectionX[Lane] = r.Direction.x;
+		DirectionY[Lane] = r.Direction.y;
+		DirectionZ[Lane] = r.Direction.z;
+		TMin[Lane] = r.TMin;
+		TMax[Lane] = r.TMax;
+	}
+
+	template <int Width>
+	inline Ray RayPacket<Width>::Get(int Lane) const
+	{
+		return Ray(Vector3(OriginX[Lane], OriginY[Lane], OriginZ[Lane]),
+				   Vector3(DirectionX[Lane], DirectionY[Lane], DirectionZ[Lane]),
+				   TMin[Lane], TMax[Lane]);
+	}
+
+	template <int Width>
+	inline void HitPacket<Width>::Clear()
+	{
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			Distance[Lane] = std::numeric_limits<float>::max();
+			u[Lane] = 0.0f;
+			v[Lane] = 0.0f;
+			Id[Lane] = NoHit;
+		}
+	}
+
+	template <int Width>
+	inline Hit HitPacket<Width>::Get(int Lane) const
+	{
+		Hit h;
+		h.Distance = Distance[Lane];
+		h.u = u[Lane];
+		h.v = v[Lane];
+		h.Id = Id[Lane];
+		return h;
+	}
+}
+
+#endif
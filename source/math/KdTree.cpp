@@ -0,0 +1,507 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include <algorithm>
+#include <limits>
+
+#include "math/BinaryFormat.hpp"
+#include "math/KdTree.hpp"
+#include "math/FloatingPoint.hpp"
+#include "math/Parallel.hpp"
+#include "math/RadixSort.hpp"
+#include "math/SpaceCurve.hpp"
+
+using namespace Math;
+
+namespace
+{
+	int const StackSize = 128;						// Enough for any tree with 32-bit ids
+	std::size_t const ParallelThreshold = 65536;	// Smaller subtrees are built on the current thread
+	std::size_t const ParallelGrain = 65536;
+	std::size_t const QueryGrain = 1024;
+
+	struct Entry
+	{
+		float x, y, z;
+		unsigned int Id;
+	};
+
+	float Entry::*const Coordinate[3] = {&Entry::x, &Entry::y, &Entry::z};
+
+	class Builder
+	{
+	public:
+		Builder(Entry *Entries, unsigned char *Axes) :
+			Entries(Entries),
+			Axes(Axes),
+			SpawnDepth(0)
+		{
+			// Fork subtrees until there is roughly one per thread.
+			while ((1u << SpawnDepth) < Parallel::ThreadCount())
+				SpawnDepth++;
+		}
+
+		// Region bounds the points in [First, Last); it is narrowed at each split rather than
+		// recomputed, which keeps the build at one partition per level.
+		void Build(std::size_t First, std::size_t Last, AABB const &Region, int Depth)
+		{
+			std::size_t Count = Last - First;
+			if (Count <= KdTree::LeafSize)
+				return;
+
+			Vector3 e = Region.Extent();
+			int Axis = (e.x >= e.y && e.x >= e.z ? 0 : (e.y >= e.z ? 1 : 2));
+			float Entry::*c = Coordinate[Axis];
+
+			std::size_t Mid = First + Count / 2;
+			std::nth_element(Entries + First, Entries + Mid, Entries + Last,
+							 [c](Entry const &a, Entry const &b) { return a.*c < b.*c; });
+			Axes[Mid] = static_cast<unsigned char>(Axis);
+
+			AABB Left(Region), Right(Region);
+			Left.Max[Axis] = Entries[Mid].*c;
+			Right.Min[Axis] = Entries[Mid].*c;
+
+			if (Count > ParallelThreshold && Depth < SpawnDepth)
+			{
+				Parallel::Invoke([=]() { this->Build(First, Mid, Left, Depth + 1); },
+								 [=]() { this->Build(Mid + 1, Last, Right, Depth + 1); });
+			}
+			else
+			{
+				this->Build(First, Mid, Left, Depth + 1);
+				this->Build(Mid + 1, Last, Right, Depth + 1);
+			}
+		}
+
+	private:
+		Entry *Entries;
+		unsigned char *Axes;
+		int SpawnDepth;
+	};
+
+	struct Range
+	{
+		std::size_t First, Last;
+		float Distance;		// Squared distance from the query to the range's side of the split
+	};
+}
+
+// Bounded max-heap of (squared distance, tree slot) pairs, kept in the caller's output arrays.
+class KdTree::Heap
+{
+public:
+	Heap(unsigned int *Slots, float *Distances, std::size_t Capacity) :
+		Slots(Slots),
+		Distances(Distances),
+		Capacity(Capacity),
+		Size(0),
+		Seeded(false)
+	{
+
+	}
+
+	inline float Worst() const
+	{
+		return (Size < Capacity ? std::numeric_limits<float>::max() : Distances[0]);
+	}
+
+	inline void Push(float Distance, unsigned int Slot)
+	{
+		if (Size == Capacity && !(Distance < Distances[0]))
+			return;
+
+		// A seeded heap may already hold this point.
+		if (Seeded)
+		{
+			for (std::size_t Index = 0; Index < Size; Index++)
+			{
+				if (Slots[Index] == Slot)
+					return;
+			}
+		}
+
+		if (Size < Capacity)
+		{
+			this->SiftUp(Size++, Distance, Slot);
+		}
+		else
+		{
+			this->SiftDown(0, Size, Distance, Slot);
+		}
+	}
+
+	// Sorts the contents closest first and returns how many there are.
+	std::size_t Sort()
+	{
+		for (std::size_t End = Size; End > 1; End--)
+		{
+			float Distance = Distances[End - 1];
+			unsigned int Slot = Slots[End - 1];
+			Distances[End - 1] = Distances[0];
+			Slots[End - 1] = Slots[0];
+			this->SiftDown(0, End - 1, Distance, Slot);
+		}
+
+		return Size;
+	}
+
+	unsigned int *Slots;
+	float *Distances;
+	std::size_t Capacity, Size;
+	bool Seeded;
+
+private:
+	inline void SiftUp(std::size_t Index, float Distance, unsigned int Slot)
+	{
+		while (Index > 0)
+		{
+			std::size_t Parent = (Index - 1) / 2;
+			if (!(Distances[Parent] < Distance))
+				break;
+
+			Distances[Index] = Distances[Parent];
+			Slots[Index] = Slots[Parent];
+			Index = Parent;
+		}
+
+		Distances[Index] = Distance;
+		Slots[Index] = Slot;
+	}
+
+	inline void SiftDown(std::size_t Index, std::size_t End, float Distance, unsigned int Slot)
+	{
+		for (;;)
+		{
+			std::size_t Child = 2 * Index + 1;
+			if (Child >= End)
+				break;
+
+			if (Child + 1 < End && Distances[Child] < Distances[Child + 1])
+				Child++;
+
+			if (!(Distance < Distances[Child]))
+				break;
+
+			Distances[Index] = Distances[Child];
+			Slots[Index] = Slots[Child];
+			Index = Child;
+		}
+
+		Distances[Index] = Distance;
+		Slots[Index] = Slot;
+	}
+};
+
+KdTree::KdTree()
+{
+
+}
+
+void KdTree::Build(Vector3 const *Points, std::size_t Count)
+{
+	std::vector<Entry, AlignedAllocator<Entry> > Entries(Count);
+	AABB Region;
+
+	for (std::size_t Index = 0; Index < Count; Index++)
+	{
+		Entry &e = Entries[Index];
+		e.x = Points[Index].x;
+		e.y = Points[Index].y;
+		e.z = Points[Index].z;
+		e.Id = static_cast<unsigned int>(Index);
+		Region.Extend(Points[Index]);
+	}
+
+	Axes.assign(Count, 0);
+
+	if (Count > 0)
+	{
+		Builder b(&Entries[0], &Axes[0]);
+		b.Build(0, Count, Region, 0);
+	}
+
+	x.resize(Count);
+	y.resize(Count);
+	z.resize(Count);
+	Indices.resize(Count);
+
+	Parallel::For(Count, ParallelGrain, [&](std::size_t Begin, std::size_t End)
+	{
+		for (std::size_t Index = Begin; Index < End; Index++)
+		{
+			x[Index] = Entries[Index].x;
+			y[Index] = Entries[Index].y;
+			z[Index] = Entries[Index].z;
+			Indices[Index] = Entries[Index].Id;
+		}
+	});
+}
+
+void KdTree::Clear()
+{
+	x.clear();
+	y.clear();
+	z.clear();
+	Indices.clear();
+	Axes.clear();
+}
+
+std::size_t KdTree::Nearest(Vector3 const &Point, std::size_t k, unsigned int *Ids, float *DistancesSquared) const
+{
+	if (k == 0)
+		return 0;
+
+	Heap h(Ids, DistancesSquared, k);
+	this->Search(Point, h);
+	return this->Finish(h, h.Sort());
+}
+
+void KdTree::Nearest(Vector3 const *Points, std::size_t Count, std::size_t k, unsigned int *Ids, float *DistancesSquared) const
+{
+	if (Count == 0 || k == 0)
+		return;
+
+	// Visit the queries along a Morton curve so that consecutive ones are close together.
+	AABB Bounds;
+	for (std::size_t Index = 0; Index < Count; Index++)
+		Bounds.Extend(Points[Index]);
+
+	std::vector<unsigned int> Codes(Count), Order(Count);
+	Morton30(Points, Count, Bounds, &Codes[0]);
+	RadixSort(&Codes[0], Count, &Order[0]);
+
+	Parallel::For(Count, QueryGrain, [&](std::size_t Begin, std::size_t End)
+	{
+		std::vector<unsigned int> Previous;
+		Previous.reserve(k);
+
+		for (std::size_t Index = Begin; Index < End; Index++)
+		{
+			std::size_t Query = Order[Index];
+			Vector3 const &p = Points[Query];
+			unsigned int *QueryIds = Ids + Query * k;
+			float *QueryDistances = DistancesSquared + Query * k;
+
+			// The previous query's neighbors are real points, so their distances to this query
+			// already bound the kth nearest distance from above.
+			Heap h(QueryIds, QueryDistances, k);
+			for (std::size_t Slot = 0; Slot < Previous.size(); Slot++)
+			{
+				unsigned int s = Previous[Slot];
+				float dx = x[s] - p.x, dy = y[s] - p.y, dz = z[s] - p.z;
+				h.Push(dx * dx + dy * dy + dz * dz, s);
+			}
+			h.Seeded = !Previous.empty();
+
+			this->Search(p, h);
+			std::size_t Found = h.Sort();
+			Previous.assign(h.Slots, h.Slots + Found);
+			this->Finish(h, Found);
+		}
+	});
+
+	CheckOutput("KdTree::Nearest", DistancesSquared, Count, k);
+}
+
+std::size_t KdTree::Query(Vector3 const &Center, float Radius, std::vector<unsigned int> &Ids) const
+{
+	std::size_t Found = Ids.size();
+
+	if (Indices.empty() || !(Radius >= 0.0f))
+		return 0;
+
+	float const Point[3] = {Center.x, Center.y, Center.z};
+	float const *Coordinates[3] = {&x[0], &y[0], &z[0]};
+	float RadiusSquared = Radius * Radius;
+
+	Range Stack[StackSize];
+	int Top = 0;
+	Stack[Top++] = Range{0, Indices.size(), 0.0f};
+
+	while (Top > 0)
+	{
+		Range r = Stack[--Top];
+
+		for (;;)
+		{
+			std::size_t Count = r.Last - r.First;
+
+			if (Count <= LeafSize)
+			{
+				for (std::size_t Slot = r.First; Slot < r.Last; Slot++)
+				{
+					float dx = x[Slot] - Center.x, dy = y[Slot] - Center.y, dz = z[Slot] - Center.z;
+					if (dx * dx + dy * dy + dz * dz <= RadiusSquared)
+						Ids.push_back(Indices[Slot]);
+				}
+
+				break;
+			}
+
+			std::size_t Mid = r.First + Count / 2;
+			int Axis = Axes[Mid];
+			float d = Point[Axis] - Coordinates[Axis][Mid];
+
+			float dx = x[Mid] - Center.x, dy = y[Mid] - Center.y, dz = z[Mid] - Center.z;
+			if (dx * dx + dy * dy + dz * dz <= RadiusSquared)
+				Ids.push_back(Indices[Mid]);
+
+			Range Far = (d < 0.0f ? Range{Mid + 1, r.Last, d * d} : Range{r.First, Mid, d * d});
+			if (d < 0.0f)
+				r.Last = Mid;
+			else
+				r.First = Mid + 1;
+
+			if (Far.Distance <= RadiusSquared && Far.First < Far.Last)
+				Stack[Top++] = Far;
+		}
+	}
+
+	return Ids.size() - Found;
+}
+
+bool KdTree::Save(char const *Path) const
+{
+	std::size_t Count = Indices.size();
+
+	// Four split axes to a word
+	std::vector<unsigned int> Packed((Count + 3) / 4, 0);
+	for (std::size_t Index = 0; Index < Count; Index++)
+		Packed[Index / 4] |= static_cast<unsigned int>(Axes[Index]) << (8 * (Index % 4));
+
+	BinaryWriter w;
+	return (w.Open(Path) &&
+			w.WriteSection("kdtree.x", x.data(), Count) &&
+			w.WriteSection("kdtree.y", y.data(), Count) &&
+			w.WriteSection("kdtree.z", z.data(), Count) &&
+			w.WriteSection("kdtree.ids", Indices.data(), Count) &&
+			w.WriteSection("kdtree.axes", Packed.data(), Packed.size()) &&
+			w.Close());
+}
+
+bool KdTree::Load(char const *Path)
+{
+	MappedBinaryFile f;
+	if (!f.Open(Path))
+		return false;
+
+	std::size_t Counts[5];
+	float const *px = f.Section<float>("kdtree.x", Counts[0]);
+	float const *py = f.Section<float>("kdtree.y", Counts[1]);
+	float const *pz = f.Section<float>("kdtree.z", Counts[2]);
+	unsigned int const *pIds = f.Section<unsigned int>("kdtree.ids", Counts[3]);
+	unsigned int const *pAxes = f.Section<unsigned int>("kdtree.axes", Counts[4]);
+
+	std::size_t Count = Counts[0];
+	if (px == NULL || py == NULL || pz == NULL || pIds == NULL || pAxes == NULL ||
+		Counts[1] != Count || Counts[2] != Count || Counts[3] != Count || Counts[4] != (Count + 3) / 4)
+		return false;
+
+	// A stored axis above 2 would index past the coordinate arrays in Search and Query
+	for (std::size_t Index = 0; Index < Count; Index++)
+		if (((pAxes[Index / 4] >> (8 * (Index % 4))) & 0xFF) > 2)
+			return false;
+
+	x.assign(px, px + Count);
+	y.assign(py, py + Count);
+	z.assign(pz, pz + Count);
+	Indices.assign(pIds, pIds + Count);
+	Axes.resize(Count);
+
+	for (std::size_t Index = 0; Index < Count; Index++)
+		Axes[Index] = static_cast<unsigned char>((pAxes[Index / 4] >> (8 * (Index % 4))) & 0xFF);
+
+	return true;
+}
+
+// Private ================================================
+
+void KdTree::Search(Vector3 const &Center, Heap &h) const
+{
+	if (Indices.empty())
+		return;
+
+	float const Point[3] = {Center.x, Center.y, Center.z};
+	float const *Coordinates[3] = {&x[0], &y[0], &z[0]};
+
+	Range Stack[StackSize];
+	int Top = 0;
+	Stack[Top++] = Range{0, Indices.size(), 0.0f};
+
+	while (Top > 0)
+	{
+		Range r = Stack[--Top];
+		if (!(r.Distance < h.Worst()))
+			continue;
+
+		for (;;)
+		{
+			std::size_t Count = r.Last - r.First;
+
+			if (Count <= LeafSize)
+			{
+				// Distances for the whole leaf first, as one lane loop
+				float Distances[LeafSize];
+				for (std::size_t Lane = 0; Lane < Count; Lane++)
+				{
+					std::size_t Slot = r.First + Lane;
+					float dx = x[Slot] - Center.x, dy = y[Slot] - Center.y, dz = z[Slot] - Center.z;
+					Distances[Lane] = dx * dx + dy * dy + dz * dz;
+				}
+
+				for (std::size_t Lane = 0; Lane < Count; Lane++)
+					h.Push(Distances[Lane], static_cast<unsigned int>(r.First + Lane));
+
+				break;
+			}
+
+			std::size_t Mid = r.First + Count / 2;
+			int Axis = Axes[Mid];
+			float d = Point[Axis] - Coordinates[Axis][Mid];
+
+			float dx = x[Mid] - Center.x, dy = y[Mid] - Center.y, dz = z[Mid] - Center.z;
+			h.Push(dx * dx + dy * dy + dz * dz, static_cast<unsigned int>(Mid));
+
+			Range Far = (d < 0.0f ? Range{Mid + 1, r.Last, d * d} : Range{r.First, Mid, d * d});
+			if (d < 0.0f)
+				r.Last = Mid;
+			else
+				r.First = Mid + 1;
+
+			if (Far.Distance < h.Worst() && Far.First < Far.Last)
+				Stack[Top++] = Far;
+		}
+	}
+}
+
+// Turns the sorted heap's tree slots into input ids and pads the rest of the output.
+std::size_t KdTree::Finish(Heap &h, std::size_t Found) const
+{
+	for (std::size_t Index = 0; Index < Found; Index++)
+		h.Slots[Index] = Indices[h.Slots[Index]];
+
+	for (std::size_t Index = Found; Index < h.Capacity; Index++)
+	{
+		h.Slots[Index] = EmptySlot;
+		h.Distances[Index] = std::numeric_limits<float>::max();
+	}
+
+	return Found;
+}
@@ -0,0 +1,108 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_KDTREE
+#define SMALLMATH_KDTREE
+
+#include <cstddef>
+#include <vector>
+
+#include "math/Allocator.hpp"
+#include "math/Bounds.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Implicit k-d tree over a static point set.
+	//
+	// There are no node records: Build() reorders the points so that every range [First, Last)
+	// of the tree keeps its median at First + (Last - First) / 2, with the smaller half to the left
+	// and the larger half to the right, down to leaf ranges of at most LeafSize points.  The only
+	// extra data is the split axis at each median.  Points are stored in tree order in SoA form, so
+	// leaves are scanned as contiguous lanes.
+	//
+	// Nearest() keeps a bounded max-heap of the best k candidates in the caller's output arrays
+	// and visits the near side of each split first, pruning the far side against the current kth
+	// distance.  The batch form sorts its queries along a Morton curve, splits them across threads,
+	// and seeds each query's heap with the previous query's results.  Neighboring queries then
+	// start with a tight bound and prune most of the tree straight away.
+	//
+	// Point ids reported by queries are indices into the array given to Build().
+
+	class KdTree
+	{
+	public:
+		static const unsigned int LeafSize = 8;
+
+		KdTree();
+
+		void Build(Vector3 const *Points, std::size_t Count);
+		void Clear();
+
+		// Writes the k nearest points to Ids and their squared distances to DistancesSquared, closest
+		// first, and returns how many were found (less than k only if the tree has fewer points).
+		std::size_t Nearest(Vector3 const &Point, std::size_t k, unsigned int *Ids, float *DistancesSquared) const;
+
+		// k results per query, stored query by query.  Slots past the end of a short result get
+		// EmptySlot and max float.
+		void Nearest(Vector3 const *Points, std::size_t Count, std::size_t k, unsigned int *Ids, float *DistancesSquared) const;
+
+		// Appends to Ids every point within Radius of Center, and returns how many were appended.
+		std::size_t Query(Vector3 const &Center, float Radius, std::vector<unsigned int> &Ids) const;
+
+		// Stores the tree with BinaryWriter, so that Load() can restore it without rebuilding.
+		bool Save(char const *Path) const;
+		bool Load(char const *Path);
+
+		inline std::size_t PointCount() const;
+		inline Vector3 Point(std::size_t Index) const;	// Tree order
+		inline unsigned int Id(std::size_t Index) const;	// Tree order -> input index
+
+		static const unsigned int EmptySlot = 0xFFFFFFFFu;
+
+	private:
+		class Heap;
+
+		void Search(Vector3 const &Point, Heap &h) const;
+		std::size_t Finish(Heap &h, std::size_t Found) const;
+
+		std::vector<float, AlignedAllocator<float> > x, y, z;	// Tree order
+		std::vector<unsigned int> Indices;						// Tree order -> input index
+		std::vector<unsigned char> Axes;						// Split axis of the median at each slot
+	};
+
+	// Inline methods =====================================
+
+	inline std::size_t KdTree::PointCount() const
+	{
+		return Indices.size();
+	}
+
+	inline Vector3 KdTree::Point(std::size_t Index) const
+	{
+		return Vector3(x[Index], y[Index], z[Index]);
+	}
+
+	inline unsigned int KdTree::Id(std::size_t Index) const
+	{
+		return Indices[Index];
+	}
+}
+
+#endif
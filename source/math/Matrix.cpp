@@ -169,7 +169,11 @@ Matrix3::Matrix3(Vector3 const &Scale, EulerAngles const &Rotation)
 
 Matrix3::Matrix3(Vector3 const &Scale, Quaternion const &Rotation)
 {
-	Matrix3 r = Matrix3(Rotation) * Matrix3(Scale);
+	// Rotation * Scale just scales the rotation's columns.
+	Matrix3 r(Rotation);
+	r.m[0][0] *= Scale.x; r.m[0][1] *= Scale.y; r.m[0][2] *= Scale.z;
+	r.m[1][0] *= Scale.x; r.m[1][1] *= Scale.y; r.m[1][2] *= Scale.z;
+	r.m[2][0] *= Scale.x; r.m[2][1] *= Scale.y; r.m[2][2] *= Scale.z;
 
 	m[0][0] = r.m[0][0]; m[0][1] = r.m[0][1]; m[0][2] = r.m[0][2];
 	m[1][0] = r.m[1][0]; m[1][1] = r.m[1][1]; m[1][2] = r.m[1][2];
@@ -206,7 +210,7 @@ Matrix4::Matrix4(Vector4 const &r0, Vector4 const &r1, Vector4 const &r2, Vector
 Matrix4::Matrix4(Matrix2 const &Mat)
 {
 	m[0][0] = Mat.m[0][0]; m[0][1] = Mat.m[0][1]; m[0][2] = 0.0f; m[0][3] = 0.0f;
-	m[1][0] = Mat.m[1][0]; m[1][1] = Mat.m[1][1]; m[1][2] = 0.0f; m[2][3] = 0.0f;
+	m[1][0] = Mat.m[1][0]; m[1][1] = Mat.m[1][1]; m[1][2] = 0.0f; m[1][3] = 0.0f;
 	m[2][0] = 0.0f; m[2][1] = 0.0f; m[2][2] = 1.0f; m[2][3] = 0.0f;
 	m[3][0] = 0.0f; m[3][1] = 0.0f; m[3][2] = 0.0f; m[3][3] = 1.0f;
 }
@@ -214,7 +218,7 @@ Matrix4::Matrix4(Matrix2 const &Mat)
 Matrix4::Matrix4(Matrix3 const &Mat)
 {
 	m[0][0] = Mat.m[0][0]; m[0][1] = Mat.m[0][1]; m[0][2] = Mat.m[0][2]; m[0][3] = 0.0f;
-	m[1][0] = Mat.m[1][0]; m[1][1] = Mat.m[1][1]; m[1][2] = Mat.m[1][2]; m[2][3] = 0.0f;
+	m[1][0] = Mat.m[1][0]; m[1][1] = Mat.m[1][1]; m[1][2] = Mat.m[1][2]; m[1][3] = 0.0f;
 	m[2][0] = Mat.m[2][0]; m[2][1] = Mat.m[2][1]; m[2][2] = Mat.m[2][2]; m[2][3] = 0.0f;
 	m[3][0] = 0.0f; m[3][1] = 0.0f; m[3][2] = 0.0f; m[3][3] = 1.0f;
 }
@@ -286,12 +290,12 @@ Matrix4::Matrix4(Vector3 const &Scale, EulerAngles const &Rotation, Vector3 cons
 
 Matrix4::Matrix4(Vector3 const &Scale, Quaternion const &Rotation, Vector3 const &Translation)
 {
-	Matrix4 r = TranslationMatrix(Translation) * Matrix4(Rotation) * Matrix4(Scale);
+	Matrix3 r(Scale, Rotation);
 
-	m[0][0] = r.m[0][0]; m[0][1] = r.m[0][1]; m[0][2] = r.m[0][2]; m[0][3] = r.m[0][3];
-	m[1][0] = r.m[1][0]; m[1][1] = r.m[1][1]; m[1][2] = r.m[1][2]; m[1][3] = r.m[1][3];
-	m[2][0] = r.m[2][0]; m[2][1] = r.m[2][1]; m[2][2] = r.m[2][2]; m[2][3] = r.m[2][3];
-	m[3][0] = r.m[3][0]; m[3][1] = r.m[3][1]; m[3][2] = r.m[3][2]; m[3][3] = r.m[3][3];
+	m[0][0] = r.m[0][0]; m[0][1] = r.m[0][1]; m[0][2] = r.m[0][2]; m[0][3] = Translation.x;
+	m[1][0] = r.m[1][0]; m[1][1] = r.m[1][1]; m[1][2] = r.m[1][2]; m[1][3] = Translation.y;
+	m[2][0] = r.m[2][0]; m[2][1] = r.m[2][1]; m[2][2] = r.m[2][2]; m[2][3] = Translation.z;
+	m[3][0] = 0.0f; m[3][1] = 0.0f; m[3][2] = 0.0f; m[3][3] = 1.0f;
 }
 
 // General operations =====================================
@@ -307,25 +311,47 @@ Matrix2 Matrix2::Adjugate() const
 				   -m[1][0], m[0][0]);
 }
 
-Matrix2 Matrix2::Invert()
+Matrix2 &Matrix2::Invert()
 {
-	*this = this->Inverted();
+	this->InvertInto(*this);
 	return *this;
 }
 
 Matrix2 Matrix2::Inverted() const
+{
+	Matrix2 r(*this);
+	r.InvertInto(r);
+	return r;
+}
+
+bool Matrix2::InvertInto(Matrix2 &Result) const
 {
 	float d = this->Determinant();
 
 	if (std::abs(d) < std::numeric_limits<float>::epsilon())
-		return Matrix2(); // The matrix is uninvertible
+	{
+		Result.SetIdentity(); // The matrix is uninvertible
+		return false;
+	}
+
+	float a00 = m[1][1], a01 = -m[0][1];
+	float a10 = -m[1][0], a11 = m[0][0];
 
-	return this->Adjugate() / d;
+	Result.m[0][0] = a00 / d; Result.m[0][1] = a01 / d;
+	Result.m[1][0] = a10 / d; Result.m[1][1] = a11 / d;
+
+	return true;
 }
 
-Matrix2 Matrix2::Normalize()
+Matrix2 &Matrix2::Normalize()
 {
-	*this = this->Normalized();
+	for (int Row = 0; Row < 2; Row++)
+	{
+		float l = std::sqrt(m[Row][0] * m[Row][0] + m[Row][1] * m[Row][1]);
+		m[Row][0] /= l;
+		m[Row][1] /= l;
+	}
+
 	return *this;
 }
 
@@ -361,25 +387,58 @@ Matrix3 Matrix3::Adjugate() const
 	return a;
 }
 
-Matrix3 Matrix3::Invert()
+Matrix3 &Matrix3::Invert()
 {
-	*this = this->Inverted();
+	this->InvertInto(*this);
 	return *this;
 }
 
 Matrix3 Matrix3::Inverted() const
 {
-	float d = this->Determinant();
+	Matrix3 r(*this);
+	r.InvertInto(r);
+	return r;
+}
+
+bool Matrix3::InvertInto(Matrix3 &Result) const
+{
+	// The first column of the adjugate also gives the determinant.
+	float a00 =  (m[1][1] * m[2][2] - m[2][1] * m[1][2]);
+	float a10 = -(m[1][0] * m[2][2] - m[2][0] * m[1][2]);
+	float a20 =  (m[1][0] * m[2][1] - m[2][0] * m[1][1]);
+	float d = m[0][0] * a00 + m[0][1] * a10 + m[0][2] * a20;
 
 	if (std::abs(d) < std::numeric_limits<float>::epsilon())
-		return Matrix2(); // The matrix is uninvertible
+	{
+		Result.SetIdentity(); // The matrix is uninvertible
+		return false;
+	}
+
+	float a01 = -(m[0][1] * m[2][2] - m[2][1] * m[0][2]);
+	float a11 =  (m[0][0] * m[2][2] - m[2][0] * m[0][2]);
+	float a21 = -(m[0][0] * m[2][1] - m[2][0] * m[0][1]);
+
+	float a02 =  (m[0][1] * m[1][2] - m[1][1] * m[0][2]);
+	float a12 = -(m[0][0] * m[1][2] - m[1][0] * m[0][2]);
+	float a22 =  (m[0][0] * m[1][1] - m[1][0] * m[0][1]);
+
+	Result.m[0][0] = a00 / d; Result.m[0][1] = a01 / d; Result.m[0][2] = a02 / d;
+	Result.m[1][0] = a10 / d; Result.m[1][1] = a11 / d; Result.m[1][2] = a12 / d;
+	Result.m[2][0] = a20 / d; Result.m[2][1] = a21 / d; Result.m[2][2] = a22 / d;
 
-	return this->Adjugate() / d;
+	return true;
 }
 
-Matrix3 Matrix3::Normalize()
+Matrix3 &Matrix3::Normalize()
 {
-	*this = this->Normalized();
+	for (int Row = 0; Row < 3; Row++)
+	{
+		float l = std::sqrt(m[Row][0] * m[Row][0] + m[Row][1] * m[Row][1] + m[Row][2] * m[Row][2]);
+		m[Row][0] /= l;
+		m[Row][1] /= l;
+		m[Row][2] /= l;
+	}
+
 	return *this;
 }
 
@@ -433,75 +492,111 @@ Matrix4 Matrix4::Adjugate() const
 	return a;
 }
 
-Matrix4 Matrix4::Invert()
-{
-	*this = this->Inverted();
-	return *this;
-}
-
-// This routine is adapted from Blender's invert_m4_m4().  Presumably faster than Adj/Det?
-Matrix4 Matrix4::Inverted() const
+namespace
 {
-	Matrix4 r, Temp;
-
-	Temp = *this;
-
-	// Effectively, we shrink the matrix with each iteration by ignoring an additional row and column.
-	for (short FirstColumn = 0; FirstColumn < 4; FirstColumn++)
+	// Gauss-Jordan elimination with partial pivoting, done in place: each pivot column is replaced
+	// by the matching column of the inverse as it is eliminated, and the row swaps are undone as
+	// column swaps at the end.  The pivoting follows Blender's invert_m4_m4().  A singular matrix is
+	// set to the identity and false returned.
+	bool InvertInPlace(float (&m)[4][4])
 	{
-		short &FirstRow = FirstColumn; // For ease of reading in different contexts
-		float Max = std::fabs(Temp.m[FirstRow][FirstColumn]);
-		short MaxRow = FirstColumn; // This will contain the Row in this Column that contains the maximum.
+		short Pivots[4];
 
-		for (short Row = FirstColumn + 1; Row < 4; Row++)
+		for (short Column = 0; Column < 4; Column++)
 		{
-			if (std::fabs(Temp.m[Row][FirstColumn]) > Max)
+			float Max = std::fabs(m[Column][Column]);
+			short MaxRow = Column; // This will contain the Row in this Column that contains the maximum.
+
+			for (short Row = Column + 1; Row < 4; Row++)
 			{
-				Max = std::fabs(Temp.m[Row][FirstColumn]);
-				MaxRow = Row;
+				if (std::fabs(m[Row][Column]) > Max)
+				{
+					Max = std::fabs(m[Row][Column]);
+					MaxRow = Row;
+				}
 			}
-		}
 
-		if (std::abs(Max) < std::numeric_limits<float>::epsilon())
-			return Matrix4(); // The matrix is uninvertible
+			if (Max < std::numeric_limits<float>::epsilon())
+			{
+				for (short Row = 0; Row < 4; Row++)
+				{
+					for (short Index = 0; Index < 4; Index++)
+						m[Row][Index] = (Row == Index ? 1.0f : 0.0f);
+				}
+				return false; // The matrix is uninvertible
+			}
 
-		// If the max was not in the first row, swap its row with the first.
-		if (MaxRow != FirstRow)
-		{
-			for (short Index = 0; Index < 4; Index++)
+			Pivots[Column] = MaxRow;
+			if (MaxRow != Column)
 			{
-				std::swap(Temp.m[MaxRow][Index], Temp.m[FirstRow][Index]);
-				std::swap(r.m[MaxRow][Index], r.m[FirstRow][Index]);
+				for (short Index = 0; Index < 4; Index++)
+					std::swap(m[MaxRow][Index], m[Column][Index]);
 			}
-		}
 
-		float SignedMax = Temp.m[FirstRow][FirstColumn];
-		for (short Index = 0; Index < 4; Index++)
-		{
-			Temp.m[FirstRow][Index] /= SignedMax;
-			r.m[FirstRow][Index] /= SignedMax;
-		}
+			float Pivot = m[Column][Column];
+			m[Column][Column] = 1.0f;
+			for (short Index = 0; Index < 4; Index++)
+				m[Column][Index] /= Pivot;
 
-		for (short Row = 0; Row < 4; Row++)
-		{
-			if (Row != FirstRow)
+			for (short Row = 0; Row < 4; Row++)
 			{
-				float RowValue = Temp.m[Row][FirstColumn];
-				for (short Index = 0; Index < 4; Index++)
+				if (Row != Column)
 				{
-					Temp.m[Row][Index] -= Temp.m[FirstRow][Index] * RowValue;
-					r.m[Row][Index] -= r.m[FirstRow][Index] * RowValue;
+					float RowValue = m[Row][Column];
+					m[Row][Column] = 0.0f;
+					for (short Index = 0; Index < 4; Index++)
+						m[Row][Index] -= m[Column][Index] * RowValue;
 				}
 			}
 		}
+
+		for (short Column = 3; Column >= 0; Column--)
+		{
+			if (Pivots[Column] != Column)
+			{
+				for (short Row = 0; Row < 4; Row++)
+					std::swap(m[Row][Pivots[Column]], m[Row][Column]);
+			}
+		}
+
+		return true;
 	}
+}
 
+Matrix4 &Matrix4::Invert()
+{
+	InvertInPlace(m);
+	return *this;
+}
+
+Matrix4 Matrix4::Inverted() const
+{
+	Matrix4 r(*this);
+	InvertInPlace(r.m);
 	return r;
 }
 
-Matrix4 Matrix4::Normalize()
+bool Matrix4::InvertInto(Matrix4 &Result) const
+{
+	if (&Result != this)
+		Result = *this;
+
+	return InvertInPlace(Result.m);
+}
+
+Matrix4 &Matrix4::Normalize()
 {
-	*this = this->Normalized();
+	for (int Row = 0; Row < 3; Row++)
+	{
+		float l = std::sqrt(m[Row][0] * m[Row][0] + m[Row][1] * m[Row][1] + m[Row][2] * m[Row][2]);
+		m[Row][0] /= l;
+		m[Row][1] /= l;
+		m[Row][2] /= l;
+		m[Row][3] /= l;
+	}
+
+	m[3][3] = 1.0f;
+
 	return *this;
 }
 
@@ -577,44 +672,108 @@ bool Matrix3::IsNegative() const
 
 Matrix3 Matrix3::RotationMatrix(EulerAngles const &Rotation)
 {
-	Matrix3 XRotation, YRotation, ZRotation;
+	return Rotation.ToMatrix3();
+}
+
+Matrix4 Matrix4::TranslationMatrix(Vector3 const &Translation)
+{
+	return Matrix4(1.0f, 0.0f, 0.0f, Translation.x,
+				   0.0f, 1.0f, 0.0f, Translation.y,
+				   0.0f, 0.0f, 1.0f, Translation.z,
+				   0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+// Text formatting ========================================
+
+namespace
+{
+	// Rows are written as "[ a, b, c ]" separated by newlines, matching operator<<.
+	template <int N>
+	char *FormatRows(char *First, char *Last, float const (&m)[N][N], bool TrailingNewline)
+	{
+		for (int Row = 0; Row < N; Row++)
+		{
+			First = Text::Write(First, Last, "[ ");
+			for (int Column = 0; Column < N; Column++)
+			{
+				if (Column > 0)
+					First = Text::Write(First, Last, ", ");
 
-	if (std::abs(Rotation.x) > std::numeric_limits<float>::epsilon())
-		XRotation = Matrix3(1.0f, 0.0f, 0.0f,
-							0.0f, std::cos(Rotation.x), -std::sin(Rotation.x),
-							0.0f, std::sin(Rotation.x), std::cos(Rotation.x));
+				First = Text::Write(First, Last, m[Row][Column]);
+			}
+			First = Text::Write(First, Last, " ]");
 
-	if (std::abs(Rotation.y) > std::numeric_limits<float>::epsilon())
-		YRotation = Matrix3(std::cos(Rotation.y), 0.0f, std::sin(Rotation.y),
-							0.0f, 1.0f, 0.0f,
-							-std::sin(Rotation.y), 0.0f, std::cos(Rotation.y));
+			if (Row < N - 1 || TrailingNewline)
+				First = Text::Write(First, Last, "\n");
+		}
 
-	if (std::abs(Rotation.z) > std::numeric_limits<float>::epsilon())
-		ZRotation = Matrix3(std::cos(Rotation.z), -std::sin(Rotation.z), 0.0f,
-							std::sin(Rotation.z), std::cos(Rotation.z), 0.0f,
-							0.0f, 0.0f, 1.0f);
+		return First;
+	}
 
-	switch (Rotation.Order)
+	template <int N>
+	char const *ParseRows(char const *First, char const *Last, float (&m)[N][N])
 	{
-	case EulerAngles::XYZ:
-		return ZRotation * YRotation * XRotation;
-	case EulerAngles::XZY:
-		return YRotation * ZRotation * XRotation;
-	case EulerAngles::YXZ:
-		return ZRotation * XRotation * YRotation;
-	case EulerAngles::YZX:
-		return XRotation * ZRotation * YRotation;
-	case EulerAngles::ZXY:
-		return YRotation * XRotation * ZRotation;
-	default:
-		return XRotation * YRotation * ZRotation;
+		for (int Row = 0; Row < N; Row++)
+		{
+			First = Text::Read(First, Last, " [");
+			for (int Column = 0; Column < N; Column++)
+			{
+				if (Column > 0)
+					First = Text::Read(First, Last, " , ");
+
+				First = Text::Read(First, Last, m[Row][Column]);
+			}
+			First = Text::Read(First, Last, " ]");
+		}
+
+		return First;
 	}
 }
 
-Matrix4 Matrix4::TranslationMatrix(Vector3 const &Translation)
+char *Math::Format(char *First, char *Last, Matrix2 const &b)
 {
-	return Matrix4(1.0f, 0.0f, 0.0f, Translation.x,
-				   0.0f, 1.0f, 0.0f, Translation.y,
-				   0.0f, 0.0f, 1.0f, Translation.z,
-				   0.0f, 0.0f, 0.0f, 1.0f);
+	return FormatRows(First, Last, b.m, true);
+}
+
+char const *Math::Parse(char const *First, char const *Last, Matrix2 &b)
+{
+	Matrix2 r;
+	First = ParseRows(First, Last, r.m);
+
+	if (First != NULL)
+		b = r;
+
+	return First;
+}
+
+char *Math::Format(char *First, char *Last, Matrix3 const &b)
+{
+	return FormatRows(First, Last, b.m, true);
+}
+
+char const *Math::Parse(char const *First, char const *Last, Matrix3 &b)
+{
+	Matrix3 r;
+	First = ParseRows(First, Last, r.m);
+
+	if (First != NULL)
+		b = r;
+
+	return First;
+}
+
+char *Math::Format(char *First, char *Last, Matrix4 const &b)
+{
+	return FormatRows(First, Last, b.m, false);
+}
+
+char const *Math::Parse(char const *First, char const *Last, Matrix4 &b)
+{
+	Matrix4 r;
+	First = ParseRows(First, Last, r.m);
+
+	if (First != NULL)
+		b = r;
+
+	return First;
 }
@@ -21,9 +21,11 @@
 #define SMALLMATH_MATRIX
 
 #include <iostream>
+#include <utility>
 
 #include "math/EulerAngles.hpp"
 #include "math/Quaternion.hpp"
+#include "math/Text.hpp"
 #include "math/Vector.hpp"
 
 namespace Math
@@ -31,6 +33,9 @@ namespace Math
 	// Note: Matrices are row-major and multiplication with vectors must happen in algebraically
 	// correct order: Matrix * Vector.  Also note that matrix stacks are also algebraically correct: First on,
 	// last off.  (ZRotation * YRotation * XRotation) * Vector == (ZRotation * (YRotation * (XRotation * Vector))).
+	//
+	// Invert(), Transpose() and Normalize() work in place and return *this.  Singular matrices invert to
+	// the identity.
 
 	class Matrix3;
 	class Matrix4;
@@ -55,11 +60,12 @@ namespace Math
 		inline void SetZero();
 		float Determinant() const;
 		Matrix2 Adjugate() const;
-		inline Matrix2 Transpose();
+		inline Matrix2 &Transpose();
 		inline Matrix2 Transposed() const;
-		Matrix2 Invert();
+		Matrix2 &Invert();
 		Matrix2 Inverted() const;
-		Matrix2 Normalize();
+		bool InvertInto(Matrix2 &Result) const;		// Result may be *this; false if singular
+		Matrix2 &Normalize();
 		Matrix2 Normalized() const;
 		inline Vector2 XAxis() const;
 		inline Vector2 YAxis() const;
@@ -109,11 +115,12 @@ namespace Math
 		inline void SetZero();
 		float Determinant() const;
 		Matrix3 Adjugate() const;
-		inline Matrix3 Transpose();
+		inline Matrix3 &Transpose();
 		inline Matrix3 Transposed() const;
-		Matrix3 Invert();
+		Matrix3 &Invert();
 		Matrix3 Inverted() const;
-		Matrix3 Normalize();
+		bool InvertInto(Matrix3 &Result) const;		// Result may be *this; false if singular
+		Matrix3 &Normalize();
 		Matrix3 Normalized() const;
 		inline Vector3 XAxis() const;
 		inline Vector3 YAxis() const;
@@ -169,11 +176,12 @@ namespace Math
 		inline void SetZero();
 		float Determinant() const;
 		Matrix4 Adjugate() const;
-		inline Matrix4 Transpose();
+		inline Matrix4 &Transpose();
 		inline Matrix4 Transposed() const;
-		Matrix4 Invert();
+		Matrix4 &Invert();
 		Matrix4 Inverted() const;
-		Matrix4 Normalize();
+		bool InvertInto(Matrix4 &Result) const;		// Result may be *this; false if singular
+		Matrix4 &Normalize();
 		Matrix4 Normalized() const;
 		inline Vector3 XAxis() const;
 		inline Vector3 YAxis() const;
@@ -207,29 +215,38 @@ namespace Math
 		Matrix4 TranslationMatrix(Vector3 const &Translation);
 	};
 
+	// Text formatting ====================================
+
+	char *Format(char *First, char *Last, Matrix2 const &b);
+	char const *Parse(char const *First, char const *Last, Matrix2 &b);
+	char *Format(char *First, char *Last, Matrix3 const &b);
+	char const *Parse(char const *First, char const *Last, Matrix3 &b);
+	char *Format(char *First, char *Last, Matrix4 const &b);
+	char const *Parse(char const *First, char const *Last, Matrix4 &b);
+
 	// Stream print =======================================
 
 	inline std::ostream &operator<<(std::ostream &a, Matrix2 const &b)
 	{
-		a << "[ " << b.m[0][0] << ", " << b.m[0][1] << " ]\n";
-		a << "[ " << b.m[1][0] << ", " << b.m[1][1] << " ]\n";
+		char Buffer[Text::MaxLength];
+		char *End = Format(Buffer, Buffer + sizeof(Buffer), b);
+		a.write(Buffer, End - Buffer);
 		return a;
 	}
 
 	inline std::ostream &operator<<(std::ostream &a, Matrix3 const &b)
 	{
-		a << "[ " << b.m[0][0] << ", " << b.m[0][1] << ", " << b.m[0][2] << " ]\n";
-		a << "[ " << b.m[1][0] << ", " << b.m[1][1] << ", " << b.m[1][2] << " ]\n";
-		a << "[ " << b.m[2][0] << ", " << b.m[2][1] << ", " << b.m[2][2] << " ]\n";
+		char Buffer[Text::MaxLength];
+		char *End = Format(Buffer, Buffer + sizeof(Buffer), b);
+		a.write(Buffer, End - Buffer);
 		return a;
 	}
 
 	inline std::ostream &operator<<(std::ostream &a, Matrix4 const &b)
 	{
-		a << "[ " << b.m[0][0] << ", " << b.m[0][1] << ", " << b.m[0][2] << ", " << b.m[0][3] << " ]\n";
-		a << "[ " << b.m[1][0] << ", " << b.m[1][1] << ", " << b.m[1][2] << ", " << b.m[1][3] << " ]\n";
-		a << "[ " << b.m[2][0] << ", " << b.m[2][1] << ", " << b.m[2][2] << ", " << b.m[2][3] << " ]\n";
-		a << "[ " << b.m[3][0] << ", " << b.m[3][1] << ", " << b.m[3][2] << ", " << b.m[3][3] << " ]";
+		char Buffer[Text::MaxLength];
+		char *End = Format(Buffer, Buffer + sizeof(Buffer), b);
+		a.write(Buffer, End - Buffer);
 		return a;
 	}
 
@@ -247,9 +264,9 @@ namespace Math
 		m[1][0] = 0.0f; m[1][1] = 0.0f;
 	}
 
-	inline Matrix2 Matrix2::Transpose()
+	inline Matrix2 &Matrix2::Transpose()
 	{
-		*this = this->Transposed();
+		std::swap(m[0][1], m[1][0]);
 		return *this;
 	}
 
@@ -277,9 +294,11 @@ namespace Math
 		m[2][0] = 0.0f; m[2][1] = 0.0f; m[2][2] = 0.0f;
 	}
 
-	inline Matrix3 Matrix3::Transpose()
+	inline Matrix3 &Matrix3::Transpose()
 	{
-		*this = this->Transposed();
+		std::swap(m[0][1], m[1][0]);
+		std::swap(m[0][2], m[2][0]);
+		std::swap(m[1][2], m[2][1]);
 		return *this;
 	}
 
@@ -310,9 +329,14 @@ namespace Math
 		m[3][0] = 0.0f; m[3][1] = 0.0f; m[3][2] = 0.0f; m[3][3] = 0.0f;
 	}
 
-	inline Matrix4 Matrix4::Transpose()
+	inline Matrix4 &Matrix4::Transpose()
 	{
-		*this = this->Transposed();
+		std::swap(m[0][1], m[1][0]);
+		std::swap(m[0][2], m[2][0]);
+		std::swap(m[0][3], m[3][0]);
+		std::swap(m[1][2], m[2][1]);
+		std::swap(m[1][3], m[3][1]);
+		std::swap(m[2][3], m[3][2]);
 		return *this;
 	}
 
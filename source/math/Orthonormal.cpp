@@ -0,0 +1,319 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#include "math/FloatingPoint.hpp"
+#include "math/Orthonormal.hpp"
+#include "math/Parallel.hpp"
+
+using namespace Math;
+
+namespace
+{
+	int const Width = 8;
+	std::size_t const MatrixGrain = 4096;		// Matrices per thread
+	std::size_t const QuaternionGrain = 16384;	// Quaternions per thread
+
+	float const NewtonSchulzLimit = 0.1f;		// Above this, Newton steps come first
+	int const NewtonSchulzSteps = 4;			// Takes 0.1 to rounding: 0.1, 7.5e-3, 4.2e-5, 1.3e-9
+	int const MaxNewtonSteps = 32;
+
+	// Matrices one per lane, as m[Row][Column][Lane].
+	template <int Lanes>
+	struct MatrixLanes
+	{
+		// Entries past Count are padded with the identity, which needs no correction.
+		void Load(Matrix3 const *Matrices, std::size_t First, std::size_t Count)
+		{
+			for (int Lane = 0; Lane < Lanes; Lane++)
+			{
+				bool Valid = (First + Lane < Count);
+				for (int i = 0; i < 3; i++)
+				{
+					for (int j = 0; j < 3; j++)
+						m[i][j][Lane] = (Valid ? Matrices[First + Lane].m[i][j] : (i == j ? 1.0f : 0.0f));
+				}
+			}
+		}
+
+		void Store(Matrix3 *Matrices, int Count) const
+		{
+			for (int Lane = 0; Lane < Count; Lane++)
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					for (int j = 0; j < 3; j++)
+						Matrices[Lane].m[i][j] = m[i][j][Lane];
+				}
+			}
+		}
+
+		// The largest entry of |M * M^T - I| in each lane.
+		void Error(float *e) const
+		{
+			for (int Lane = 0; Lane < Lanes; Lane++)
+				e[Lane] = 0.0f;
+
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = i; j < 3; j++)
+				{
+					float Diagonal = (i == j ? 1.0f : 0.0f);
+					for (int Lane = 0; Lane < Lanes; Lane++)
+					{
+						float d = m[i][0][Lane] * m[j][0][Lane] + m[i][1][Lane] * m[j][1][Lane] + m[i][2][Lane] * m[j][2][Lane] - Diagonal;
+						e[Lane] = std::max(e[Lane], std::abs(d));
+					}
+				}
+			}
+		}
+
+		float m[3][3][Lanes];
+	};
+
+	template <int Lanes>
+	void GramSchmidtLanes(MatrixLanes<Lanes> const &a, MatrixLanes<Lanes> &r)
+	{
+		for (int Lane = 0; Lane < Lanes; Lane++)
+		{
+			float x0 = a.m[0][0][Lane], x1 = a.m[0][1][Lane], x2 = a.m[0][2][Lane];
+			float y0 = a.m[1][0][Lane], y1 = a.m[1][1][Lane], y2 = a.m[1][2][Lane];
+
+			float s = 1.0f / std::sqrt(x0 * x0 + x1 * x1 + x2 * x2);
+			x0 *= s; x1 *= s; x2 *= s;
+
+			float d = x0 * y0 + x1 * y1 + x2 * y2;
+			y0 -= d * x0; y1 -= d * x1; y2 -= d * x2;
+
+			s = 1.0f / std::sqrt(y0 * y0 + y1 * y1 + y2 * y2);
+			y0 *= s; y1 *= s; y2 *= s;
+
+			r.m[0][0][Lane] = x0; r.m[0][1][Lane] = x1; r.m[0][2][Lane] = x2;
+			r.m[1][0][Lane] = y0; r.m[1][1][Lane] = y1; r.m[1][2][Lane] = y2;
+			r.m[2][0][Lane] = x1 * y2 - x2 * y1;
+			r.m[2][1][Lane] = x2 * y0 - x0 * y2;
+			r.m[2][2][Lane] = x0 * y1 - x1 * y0;
+		}
+	}
+
+	// M <- (3I - M * M^T) * M / 2, NewtonSchulzSteps times.
+	template <int Lanes>
+	void NewtonSchulzLanes(MatrixLanes<Lanes> const &a, MatrixLanes<Lanes> &r)
+	{
+		r = a;
+
+		for (int Step = 0; Step < NewtonSchulzSteps; Step++)
+		{
+			float h[3][3][Lanes];	// (3I - M * M^T) / 2, which is symmetric
+
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = i; j < 3; j++)
+				{
+					float Diagonal = (i == j ? 1.5f : 0.0f);
+					for (int Lane = 0; Lane < Lanes; Lane++)
+					{
+						h[i][j][Lane] = h[j][i][Lane] = Diagonal - 0.5f * (r.m[i][0][Lane] * r.m[j][0][Lane] +
+																		   r.m[i][1][Lane] * r.m[j][1][Lane] +
+																		   r.m[i][2][Lane] * r.m[j][2][Lane]);
+					}
+				}
+			}
+
+			MatrixLanes<Lanes> p = r;
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					for (int Lane = 0; Lane < Lanes; Lane++)
+						r.m[i][j][Lane] = h[i][0][Lane] * p.m[0][j][Lane] + h[i][1][Lane] * p.m[1][j][Lane] + h[i][2][Lane] * p.m[2][j][Lane];
+				}
+			}
+		}
+	}
+
+	// Newton steps M <- (M + M^-T) / 2 until Newton-Schulz can finish.  M^-T is the cofactor matrix
+	// over the determinant.  Returns false if M is singular.
+	bool Newton(Matrix3 &Mat)
+	{
+		for (int Step = 0; Step < MaxNewtonSteps && OrthonormalError(Mat) > NewtonSchulzLimit; Step++)
+		{
+			float d = Mat.Determinant();
+			if (std::abs(d) < std::numeric_limits<float>::epsilon())
+				return false;
+
+			// The cofactor of a[i][j] is the (i, j) entry of the adjugate transposed.
+			Matrix3 c = Mat.Adjugate();
+			float s = 0.5f / d;
+
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++)
+					Mat.m[i][j] = 0.5f * Mat.m[i][j] + s * c.m[j][i];
+			}
+		}
+
+		return true;
+	}
+
+	template <int Lanes>
+	void Correct(MatrixLanes<Lanes> const &a, OrthonormalMethod Method, MatrixLanes<Lanes> &r)
+	{
+		if (Method == Polar)
+			NewtonSchulzLanes(a, r);
+		else
+			GramSchmidtLanes(a, r);
+	}
+
+	std::size_t OrthonormalizeRange(Matrix3 *Matrices, std::size_t Begin, std::size_t End, OrthonormalMethod Method, float Tolerance)
+	{
+		std::size_t Corrected = 0;
+
+		for (std::size_t First = Begin; First < End; First += Width)
+		{
+			int Lanes = int(std::min<std::size_t>(Width, End - First));
+
+			MatrixLanes<Width> a, r;
+			a.Load(Matrices, First, End);
+
+			float e[Width];
+			a.Error(e);
+			Correct(a, Method, r);
+
+			int Far = 0;
+			for (int Lane = 0; Lane < Width; Lane++)
+			{
+				bool Select = (e[Lane] > Tolerance);
+				Corrected += Select;
+				Far |= (Method == Polar && Select && e[Lane] > NewtonSchulzLimit);
+
+				for (int i = 0; i < 3; i++)
+				{
+					for (int j = 0; j < 3; j++)
+						r.m[i][j][Lane] = (Select ? r.m[i][j][Lane] : a.m[i][j][Lane]);
+				}
+			}
+
+			r.Store(Matrices + First, Lanes);
+
+			// Rare: lanes too far from orthonormal for the fixed Newton-Schulz steps.
+			if (Far)
+			{
+				for (int Lane = 0; Lane < Lanes; Lane++)
+				{
+					if (e[Lane] > Tolerance && e[Lane] > NewtonSchulzLimit)
+					{
+						Matrix3 &b = Matrices[First + Lane];
+						for (int i = 0; i < 3; i++)
+						{
+							for (int j = 0; j < 3; j++)
+								b.m[i][j] = a.m[i][j][Lane];
+						}
+						b = Orthonormalized(b, Polar);
+					}
+				}
+			}
+		}
+
+		return Corrected;
+	}
+
+	std::size_t RenormalizeRange(Quaternion *Quaternions, std::size_t Begin, std::size_t End, float Tolerance)
+	{
+		std::size_t Corrected = 0;
+		std::size_t Blocked = Begin + (End - Begin) / Width * Width;
+
+		for (std::size_t First = Begin; First < Blocked; First += Width)
+		{
+			Quaternion *q = Quaternions + First;
+
+			for (int Lane = 0; Lane < Width; Lane++)
+			{
+				float n = q[Lane].w * q[Lane].w + q[Lane].x * q[Lane].x + q[Lane].y * q[Lane].y + q[Lane].z * q[Lane].z;
+				bool Select = (std::abs(n - 1.0f) > Tolerance);
+				float s = (Select ? 0.5f * (3.0f - n) : 1.0f);
+				Corrected += Select;
+
+				q[Lane].w *= s;
+				q[Lane].x *= s;
+				q[Lane].y *= s;
+				q[Lane].z *= s;
+			}
+		}
+
+		for (std::size_t Index = Blocked; Index < End; Index++)
+		{
+			bool Select = (UnitError(Quaternions[Index]) > Tolerance);
+			Corrected += Select;
+			if (Select)
+				Quaternions[Index] = Renormalized(Quaternions[Index]);
+		}
+
+		return Corrected;
+	}
+}
+
+Matrix3 Math::Orthonormalized(Matrix3 const &Mat, OrthonormalMethod Method)
+{
+	Matrix3 r = Mat;
+
+	if (Method == Polar && !Newton(r))
+		Method = GramSchmidt;	// Singular: there is no unique nearest orthonormal matrix
+
+	MatrixLanes<1> a, b;
+	a.Load(&r, 0, 1);
+	Correct(a, Method, b);
+	b.Store(&r, 1);
+
+	return r;
+}
+
+std::size_t Math::Orthonormalize(Matrix3 *Matrices, std::size_t Count, OrthonormalMethod Method, float Tolerance)
+{
+	std::atomic<std::size_t> Corrected(0);
+
+	Parallel::For((Count + Width - 1) / Width, MatrixGrain / Width, [&](std::size_t Begin, std::size_t End)
+	{
+		Corrected += OrthonormalizeRange(Matrices, Begin * Width, std::min(End * Width, Count), Method, Tolerance);
+	});
+
+	static_assert(sizeof(Matrix3) == 9 * sizeof(float), "Matrix3 is checked as plain floats");
+	CheckOutput("Orthonormalize", reinterpret_cast<float const *>(Matrices), Count, 9);
+
+	return Corrected;
+}
+
+std::size_t Math::Renormalize(Quaternion *Quaternions, std::size_t Count, float Tolerance)
+{
+	std::atomic<std::size_t> Corrected(0);
+
+	Parallel::For((Count + Width - 1) / Width, QuaternionGrain / Width, [&](std::size_t Begin, std::size_t End)
+	{
+		Corrected += RenormalizeRange(Quaternions, Begin * Width, std::min(End * Width, Count), Tolerance);
+	});
+
+	static_assert(sizeof(Quaternion) == 4 * sizeof(float), "Quaternion is checked as plain floats");
+	CheckOutput("Renormalize", reinterpret_cast<float const *>(Quaternions), Count, 4);
+
+	return Corrected;
+}
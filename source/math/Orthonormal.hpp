@@ -0,0 +1,102 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#ifndef SMALLMATH_ORTHONORMAL
+#define SMALLMATH_ORTHONORMAL
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+
+namespace Math
+{
+	// Drift correction for accumulated rotations.  Products of many rotation matrices or quaternions
+	// slowly lose orthonormality (or unit length) to rounding; these pull them back.
+
+	enum OrthonormalMethod
+	{
+		// Normalizes the X row, removes its component from the Y row and normalizes that, and sets
+		// the Z row to X cross Y.  Cheap, and the result is always a proper rotation, but the X axis
+		// is kept exactly while the error is pushed onto Y and Z.
+		GramSchmidt,
+
+		// The orthonormal matrix nearest in the Frobenius norm (the rotation factor of the polar
+		// decomposition), which treats every axis alike.  Reached by Newton-Schulz steps
+		// M <- (3I - M * M^T) * M / 2, each of which squares the error, after Newton steps
+		// M <- (M + M^-T) / 2 if the error starts above 0.1.  A reflection stays a reflection.
+		Polar
+	};
+
+	// The largest entry of |M * M^T - I|, and ||q|^2 - 1|.
+	inline float OrthonormalError(Matrix3 const &Mat);
+	inline float UnitError(Quaternion const &q);
+
+	Matrix3 Orthonormalized(Matrix3 const &Mat, OrthonormalMethod Method = GramSchmidt);
+
+	// One first-order step toward unit length, q * (3 - |q|^2) / 2, with no square root or divide.
+	// An error e becomes about 3/4 e^2, so this is for drift: one step takes 1e-3 to below 1e-6.
+	// Normalized() is the one for arbitrary quaternions.
+	inline Quaternion Renormalized(Quaternion const &q);
+
+	// Batched forms ======================================
+
+	// Each corrects, in place, only the entries whose OrthonormalError() or UnitError() exceeds
+	// Tolerance, leaves the others untouched, and returns how many were corrected.  Entries are
+	// processed eight at a time with the correction computed for every lane and selected per lane,
+	// so the loops are branch-free; large arrays are split across threads.  A polar lane whose
+	// error is above 0.1 is finished by Orthonormalized() instead.
+	std::size_t Orthonormalize(Matrix3 *Matrices, std::size_t Count, OrthonormalMethod Method = GramSchmidt,
+							   float Tolerance = 0.0f);
+	std::size_t Renormalize(Quaternion *Quaternions, std::size_t Count, float Tolerance = 0.0f);
+
+	// Inline functions ===================================
+
+	inline float OrthonormalError(Matrix3 const &Mat)
+	{
+		float r = 0.0f;
+
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = i; j < 3; j++)
+			{
+				float d = Mat.m[i][0] * Mat.m[j][0] + Mat.m[i][1] * Mat.m[j][1] + Mat.m[i][2] * Mat.m[j][2] - (i == j ? 1.0f : 0.0f);
+				r = std::max(r, std::abs(d));
+			}
+		}
+
+		return r;
+	}
+
+	inline float UnitError(Quaternion const &q)
+	{
+		return std::abs(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z - 1.0f);
+	}
+
+	inline Quaternion Renormalized(Quaternion const &q)
+	{
+		float s = 0.5f * (3.0f - (q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z));
+		return Quaternion(q.w * s, q.x * s, q.y * s, q.z * s);
+	}
+}
+
+#endif
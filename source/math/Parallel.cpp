@@ -0,0 +1,47 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include <atomic>
+
+#include "math/Parallel.hpp"
+
+using namespace Math;
+
+namespace
+{
+	std::atomic<unsigned int> Override(0);
+
+	// hardware_concurrency() can be a system call, so only ask once.
+	unsigned int HardwareThreads()
+	{
+		static unsigned int const Count = std::thread::hardware_concurrency();
+		return (Count > 0 ? Count : 1);
+	}
+}
+
+unsigned int Parallel::ThreadCount()
+{
+	unsigned int Count = Override.load(std::memory_order_relaxed);
+	return (Count > 0 ? Count : HardwareThreads());
+}
+
+void Parallel::SetThreadCount(unsigned int Count)
+{
+	Override.store(Count, std::memory_order_relaxed);
+}
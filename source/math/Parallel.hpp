@@ -0,0 +1,105 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_PARALLEL
+#define SMALLMATH_PARALLEL
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "math/FloatingPoint.hpp"
+
+namespace Math
+{
+	// Minimal fork/join helpers for the batch routines.  Work is split into contiguous ranges, one
+	// per hardware thread, and the calling thread always takes a share itself.  Every share runs
+	// under a DenormalGuard.
+	namespace Parallel
+	{
+		unsigned int ThreadCount();
+		void SetThreadCount(unsigned int Count);	// 0 restores the hardware default
+
+		// Calls Function(Begin, End) over disjoint ranges covering [0, Count).  Ranges are never
+		// smaller than Grain, so small inputs run inline on the calling thread.
+		template <typename Function>
+		void For(std::size_t Count, std::size_t Grain, Function const &f)
+		{
+			if (Grain == 0)
+				Grain = 1;
+
+			std::size_t Chunks = (Count + Grain - 1) / Grain;
+			if (Chunks > ThreadCount())
+				Chunks = ThreadCount();
+
+			if (Chunks <= 1)
+			{
+				if (Count > 0)
+				{
+					DenormalGuard Guard;
+					f(std::size_t(0), Count);
+				}
+
+				return;
+			}
+
+			auto Share = [&f](std::size_t Begin, std::size_t End)
+			{
+				DenormalGuard Guard;
+				f(Begin, End);
+			};
+
+			std::vector<std::thread> Threads;
+			Threads.reserve(Chunks - 1);
+
+			std::size_t Begin = 0;
+			for (std::size_t Chunk = 0; Chunk < Chunks - 1; Chunk++)
+			{
+				std::size_t End = Count * (Chunk + 1) / Chunks;
+				Threads.push_back(std::thread(Share, Begin, End));
+				Begin = End;
+			}
+
+			Share(Begin, Count);
+
+			for (std::size_t Index = 0; Index < Threads.size(); Index++)
+				Threads[Index].join();
+		}
+
+		// Runs a and b concurrently and returns when both are done.
+		template <typename A, typename B>
+		void Invoke(A const &a, B const &b)
+		{
+			std::thread Thread([&a]()
+			{
+				DenormalGuard Guard;
+				a();
+			});
+
+			{
+				DenormalGuard Guard;
+				b();
+			}
+
+			Thread.join();
+		}
+	}
+}
+
+#endif
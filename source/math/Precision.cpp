@@ -0,0 +1,94 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#include <cmath>
+#include <limits>
+
+#include "math/Precision.hpp"
+
+using namespace Math;
+
+namespace
+{
+	float const SingularTolerance = 2.0f * std::numeric_limits<float>::epsilon();	// Relative to the determinant's magnitude
+
+	// x * y - z * w.  Magnitude receives |x * y| + |z * w|, which scales its rounding error.
+	inline float Minor(float x, float y, float z, float w, float &Magnitude)
+	{
+		float p = x * y;
+		float q = z * w;
+		Magnitude = std::fabs(p) + std::fabs(q);
+		return p - q;
+	}
+}
+
+Matrix4 Fast::Inverted(Matrix4 const &Mat)
+{
+	float const (&a)[4][4] = Mat.m;
+
+	// 2x2 determinants of the top two rows and the bottom two rows, from which every cofactor and the
+	// determinant are built (Laplace expansion by complementary minors).
+	float S[6], C[6];
+	float s0 = Minor(a[0][0], a[1][1], a[1][0], a[0][1], S[0]);
+	float s1 = Minor(a[0][0], a[1][2], a[1][0], a[0][2], S[1]);
+	float s2 = Minor(a[0][0], a[1][3], a[1][0], a[0][3], S[2]);
+	float s3 = Minor(a[0][1], a[1][2], a[1][1], a[0][2], S[3]);
+	float s4 = Minor(a[0][1], a[1][3], a[1][1], a[0][3], S[4]);
+	float s5 = Minor(a[0][2], a[1][3], a[1][2], a[0][3], S[5]);
+
+	float c0 = Minor(a[2][0], a[3][1], a[3][0], a[2][1], C[0]);
+	float c1 = Minor(a[2][0], a[3][2], a[3][0], a[2][2], C[1]);
+	float c2 = Minor(a[2][0], a[3][3], a[3][0], a[2][3], C[2]);
+	float c3 = Minor(a[2][1], a[3][2], a[3][1], a[2][2], C[3]);
+	float c4 = Minor(a[2][1], a[3][3], a[3][1], a[2][3], C[4]);
+	float c5 = Minor(a[2][2], a[3][3], a[3][2], a[2][3], C[5]);
+
+	float Determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+	// A rank-deficient matrix rounds to a small nonzero determinant rather than zero, within about
+	// epsilon times the magnitude of the products it is built from.  A translation only meets zero
+	// cofactors, so large ones do not loosen the test.
+	float Magnitude = S[0] * C[5] + S[1] * C[4] + S[2] * C[3] + S[3] * C[2] + S[4] * C[1] + S[5] * C[0];
+
+	if (std::fabs(Determinant) <= SingularTolerance * Magnitude)
+		return Matrix4(); // The matrix is uninvertible
+
+	float d = 1.0f / Determinant;
+
+	return Matrix4(( a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * d,
+				   (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * d,
+				   ( a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * d,
+				   (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * d,
+
+				   (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * d,
+				   ( a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * d,
+				   (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * d,
+				   ( a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * d,
+
+				   ( a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * d,
+				   (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * d,
+				   ( a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * d,
+				   (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * d,
+
+				   (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * d,
+				   ( a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * d,
+				   (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * d,
+				   ( a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * d);
+}
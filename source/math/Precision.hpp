@@ -0,0 +1,211 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_PRECISION
+#define SMALLMATH_PRECISION
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Precision policies.  Each policy has the same set of static functions, so code can either call
+	// one directly (Fast::Normalized(v)) or take the policy as a template parameter and call
+	// Policy::Normalized(v).
+	//
+	// Precise forwards to the member functions and gives bit-identical results.  Fast trades a
+	// bounded error for fewer divides, square roots and transcendentals.  Its bounds, against a
+	// double precision reference or Precise over random inputs, are checked by test/Precision.cpp:
+	//
+	//	Normalize, Normalized		|length - 1| < 4e-7 (about 3 ulp)
+	//	Slerp						rotation within 1e-3 radians of the true slerp (7.8e-4 seen),
+	//								unit length to 4e-7
+	//	Inverted (Quaternion)		within 1 ulp per component of Precise
+	//	Inverted (Matrix4)			largest residual |M * Inverted(M) - I| over the sample no worse
+	//								than Precise's for scale, rotation and translation transforms,
+	//								and within 4 times for general matrices (up to 2 seen).  Nothing
+	//								is pivoted, so one ill-conditioned matrix can do far worse than
+	//								Precise on its own; 70 times has been seen.
+	//
+	// As with the member functions, zero vectors and quaternions normalize to NaNs, and singular
+	// matrices invert to the identity.  Fast::Inverted(Matrix4) counts a matrix as singular when
+	// its determinant is within twice its own rounding error bound, which also catches
+	// rank-deficient matrices whose determinant rounds to a small nonzero value.
+	struct Precise
+	{
+		static inline float Normalize(Vector3 &v);
+		static inline Vector3 Normalized(Vector3 const &v);
+		static inline float Normalize(Quaternion &q);
+		static inline Quaternion Normalized(Quaternion const &q);
+		static inline Quaternion Slerp(Quaternion const &a, Quaternion const &b, float t);
+		static inline Quaternion Inverted(Quaternion const &q);
+		static inline Matrix4 Inverted(Matrix4 const &Mat);
+	};
+
+	struct Fast
+	{
+		// A hardware estimate refined by one Newton step (a bit trick and three steps without one)
+		static inline float ReciprocalSqrt(float Value);
+
+		// Multiply by the reciprocal length instead of dividing by the length
+		static inline float Normalize(Vector3 &v);
+		static inline Vector3 Normalized(Vector3 const &v);
+		static inline float Normalize(Quaternion &q);
+		static inline Quaternion Normalized(Quaternion const &q);
+
+		// Normalized lerp with its parameter warped by a cubic in t, whose coefficients are fitted
+		// to the angle between a and b (after Kapoulkine), so the rotation speed is nearly uniform.
+		static inline Quaternion Slerp(Quaternion const &a, Quaternion const &b, float t);
+
+		static inline Quaternion Inverted(Quaternion const &q);
+
+		// Cofactor expansion without pivoting: one reciprocal and straight-line code
+		static Matrix4 Inverted(Matrix4 const &Mat);
+	};
+
+	// Precise ============================================
+
+	inline float Precise::Normalize(Vector3 &v)
+	{
+		return v.Normalize();
+	}
+
+	inline Vector3 Precise::Normalized(Vector3 const &v)
+	{
+		return v.Normalized();
+	}
+
+	inline float Precise::Normalize(Quaternion &q)
+	{
+		return q.Normalize();
+	}
+
+	inline Quaternion Precise::Normalized(Quaternion const &q)
+	{
+		return q.Normalized();
+	}
+
+	inline Quaternion Precise::Slerp(Quaternion const &a, Quaternion const &b, float t)
+	{
+		return a.Slerp(b, t);
+	}
+
+	inline Quaternion Precise::Inverted(Quaternion const &q)
+	{
+		return q.Inverted();
+	}
+
+	inline Matrix4 Precise::Inverted(Matrix4 const &Mat)
+	{
+		return Mat.Inverted();
+	}
+
+	// Fast ===============================================
+
+	inline float Fast::ReciprocalSqrt(float Value)
+	{
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+		float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(Value)));
+		return y * (1.5f - 0.5f * Value * y * y);
+#else
+		std::uint32_t Bits;
+		std::memcpy(&Bits, &Value, sizeof(float));
+		Bits = 0x5F375A86u - (Bits >> 1);
+
+		float y;
+		std::memcpy(&y, &Bits, sizeof(float));
+		y = y * (1.5f - 0.5f * Value * y * y);
+		y = y * (1.5f - 0.5f * Value * y * y);
+		return y * (1.5f - 0.5f * Value * y * y);
+#endif
+	}
+
+	inline float Fast::Normalize(Vector3 &v)
+	{
+		float LengthSquared = v.x * v.x + v.y * v.y + v.z * v.z;
+		float r = ReciprocalSqrt(LengthSquared);
+
+		v.x *= r;
+		v.y *= r;
+		v.z *= r;
+
+		return LengthSquared * r;
+	}
+
+	inline Vector3 Fast::Normalized(Vector3 const &v)
+	{
+		Vector3 r(v);
+		Normalize(r);
+		return r;
+	}
+
+	inline float Fast::Normalize(Quaternion &q)
+	{
+		float MagnitudeSquared = q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z;
+		float r = ReciprocalSqrt(MagnitudeSquared);
+
+		q.w *= r;
+		q.x *= r;
+		q.y *= r;
+		q.z *= r;
+
+		return MagnitudeSquared * r;
+	}
+
+	inline Quaternion Fast::Normalized(Quaternion const &q)
+	{
+		Quaternion r(q);
+		Normalize(r);
+		return r;
+	}
+
+	inline Quaternion Fast::Slerp(Quaternion const &a, Quaternion const &b, float t)
+	{
+		// Take the short way round, as Quaternion::Slerp() does.
+		float CosTheta = a.Dot(b);
+		float Sign = (CosTheta < 0.0f ? -1.0f : 1.0f);
+		float d = CosTheta * Sign;
+
+		float A = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+		float B = 0.848013f + d * (-1.06021f + d * 0.215638f);
+		float k = A * (t - 0.5f) * (t - 0.5f) + B;
+		float s = t + t * (t - 0.5f) * (t - 1.0f) * k;
+
+		float ra = (1.0f - s) * Sign;
+		Quaternion r(a.w * ra + b.w * s, a.x * ra + b.x * s, a.y * ra + b.y * s, a.z * ra + b.z * s);
+		Normalize(r);
+		return r;
+	}
+
+	inline Quaternion Fast::Inverted(Quaternion const &q)
+	{
+		float r = 1.0f / q.MagnitudeSquared();
+		return Quaternion(q.w * r, -q.x * r, -q.y * r, -q.z * r);
+	}
+}
+
+#endif
@@ -82,10 +82,45 @@ Quaternion::Quaternion(Matrix3 const &Mat)
 
 Quaternion::Quaternion(EulerAngles const &Euler)
 {
-	Quaternion r = Quaternion(Matrix3(Euler));
+	Quaternion r = Euler.ToQuaternion();
 
 	w = r.w;
 	x = r.x;
 	y = r.y;
 	z = r.z;
 }
+
+// Text formatting ========================================
+
+char *Math::Format(char *First, char *Last, Quaternion const &b)
+{
+	First = Text::Write(First, Last, "(");
+	First = Text::Write(First, Last, b.w);
+	First = Text::Write(First, Last, ", (");
+	First = Text::Write(First, Last, b.x);
+	First = Text::Write(First, Last, ", ");
+	First = Text::Write(First, Last, b.y);
+	First = Text::Write(First, Last, ", ");
+	First = Text::Write(First, Last, b.z);
+	return Text::Write(First, Last, "))");
+}
+
+char const *Math::Parse(char const *First, char const *Last, Quaternion &b)
+{
+	Quaternion r;
+
+	First = Text::Read(First, Last, " (");
+	First = Text::Read(First, Last, r.w);
+	First = Text::Read(First, Last, " , (");
+	First = Text::Read(First, Last, r.x);
+	First = Text::Read(First, Last, " , ");
+	First = Text::Read(First, Last, r.y);
+	First = Text::Read(First, Last, " , ");
+	First = Text::Read(First, Last, r.z);
+	First = Text::Read(First, Last, " ) )");
+
+	if (First != NULL)
+		b = r;
+
+	return First;
+}
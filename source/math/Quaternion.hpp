@@ -26,6 +26,7 @@
 
 #include "math/EulerAngles.hpp"
 #include "math/Matrix.hpp"
+#include "math/Text.hpp"
 #include "math/Vector.hpp"
 
 namespace Math
@@ -51,8 +52,9 @@ namespace Math
 		inline float Normalize();
 		inline Quaternion Normalized() const;
 		inline Quaternion Conjugate() const;
-		inline Quaternion Invert();
+		inline Quaternion &Invert();
 		inline Quaternion Inverted() const;
+		inline void InvertInto(Quaternion &Result) const;
 		inline float GetAngle() const;
 		inline Vector3 GetAxis() const;
 
@@ -82,11 +84,18 @@ namespace Math
 		float w, x, y, z;
 	};
 
+	// Text formatting ====================================
+
+	char *Format(char *First, char *Last, Quaternion const &b);
+	char const *Parse(char const *First, char const *Last, Quaternion &b);
+
 	// Stream print =======================================
 
 	inline std::ostream &operator<<(std::ostream &a, Quaternion const &b)
 	{
-		a << "(" << b.w << ", (" << b.x << ", " << b.y << ", " << b.z << "))";
+		char Buffer[Text::MaxLength];
+		char *End = Format(Buffer, Buffer + sizeof(Buffer), b);
+		a.write(Buffer, End - Buffer);
 		return a;
 	}
 
@@ -166,9 +175,15 @@ namespace Math
 		return Quaternion(w, -x, -y, -z);
 	}
 
-	inline Quaternion Quaternion::Invert()
+	inline Quaternion &Quaternion::Invert()
 	{
-		*this = this->Inverted();
+		float m = this->MagnitudeSquared();
+
+		w /= m;
+		x /= -m;
+		y /= -m;
+		z /= -m;
+
 		return *this;
 	}
 
@@ -177,6 +192,16 @@ namespace Math
 		return this->Conjugate() / this->MagnitudeSquared();
 	}
 
+	inline void Quaternion::InvertInto(Quaternion &Result) const
+	{
+		float m = this->MagnitudeSquared();
+
+		Result.w = w / m;
+		Result.x = -x / m;
+		Result.y = -y / m;
+		Result.z = -z / m;
+	}
+
 	inline float Quaternion::GetAngle() const
 	{
 		return (2 * std::acos(w));
@@ -0,0 +1,129 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include "math/Allocator.hpp"
+#include "math/Parallel.hpp"
+#include "math/RadixSort.hpp"
+
+using namespace Math;
+
+namespace
+{
+	std::size_t const ParallelGrain = 65536;
+	int const DigitBits = 8;
+	int const Digits = 1 << DigitBits;
+
+	template <typename Key>
+	void Sort(Key const *Keys, std::size_t Count, unsigned int *Permutation)
+	{
+		if (Count == 0)
+			return;
+
+		// Bits that differ between any two keys; passes over digits with none of them are no-ops.
+		Key Varying = 0;
+		for (std::size_t Index = 1; Index < Count; Index++)
+			Varying |= Keys[Index] ^ Keys[0];
+
+		std::size_t Chunks = (Count + ParallelGrain - 1) / ParallelGrain;
+		if (Chunks > Parallel::ThreadCount())
+			Chunks = Parallel::ThreadCount();
+
+		std::vector<Key, AlignedAllocator<Key> > KeyBuffer[2];
+		std::vector<unsigned int, AlignedAllocator<unsigned int> > IdBuffer[2];
+		std::vector<std::size_t> Offsets(Chunks * Digits);
+
+		KeyBuffer[0].assign(Keys, Keys + Count);
+		KeyBuffer[1].resize(Count);
+		IdBuffer[0].resize(Count);
+		IdBuffer[1].resize(Count);
+
+		for (std::size_t Index = 0; Index < Count; Index++)
+			IdBuffer[0][Index] = static_cast<unsigned int>(Index);
+
+		int Current = 0;
+
+		for (int Shift = 0; Shift < int(sizeof(Key) * 8); Shift += DigitBits)
+		{
+			if (((Varying >> Shift) & (Digits - 1)) == 0)
+				continue;
+
+			Key const *Source = &KeyBuffer[Current][0];
+			unsigned int const *SourceIds = &IdBuffer[Current][0];
+			Key *Target = &KeyBuffer[1 - Current][0];
+			unsigned int *TargetIds = &IdBuffer[1 - Current][0];
+
+			// Per-chunk histograms
+			Parallel::For(Chunks, 1, [&](std::size_t Begin, std::size_t End)
+			{
+				for (std::size_t Chunk = Begin; Chunk < End; Chunk++)
+				{
+					std::size_t *Histogram = &Offsets[Chunk * Digits];
+					for (int Digit = 0; Digit < Digits; Digit++)
+						Histogram[Digit] = 0;
+
+					for (std::size_t Index = Count * Chunk / Chunks; Index < Count * (Chunk + 1) / Chunks; Index++)
+						Histogram[(Source[Index] >> Shift) & (Digits - 1)]++;
+				}
+			});
+
+			// Digit-major prefix sum: every chunk's slice of a digit follows the previous chunk's,
+			// which keeps the sort stable.
+			std::size_t Total = 0;
+			for (int Digit = 0; Digit < Digits; Digit++)
+			{
+				for (std::size_t Chunk = 0; Chunk < Chunks; Chunk++)
+				{
+					std::size_t n = Offsets[Chunk * Digits + Digit];
+					Offsets[Chunk * Digits + Digit] = Total;
+					Total += n;
+				}
+			}
+
+			Parallel::For(Chunks, 1, [&](std::size_t Begin, std::size_t End)
+			{
+				for (std::size_t Chunk = Begin; Chunk < End; Chunk++)
+				{
+					std::size_t *Offset = &Offsets[Chunk * Digits];
+
+					for (std::size_t Index = Count * Chunk / Chunks; Index < Count * (Chunk + 1) / Chunks; Index++)
+					{
+						std::size_t Slot = Offset[(Source[Index] >> Shift) & (Digits - 1)]++;
+						Target[Slot] = Source[Index];
+						TargetIds[Slot] = SourceIds[Index];
+					}
+				}
+			});
+
+			Current = 1 - Current;
+		}
+
+		for (std::size_t Index = 0; Index < Count; Index++)
+			Permutation[Index] = IdBuffer[Current][Index];
+	}
+}
+
+void Math::RadixSort(unsigned int const *Keys, std::size_t Count, unsigned int *Permutation)
+{
+	Sort(Keys, Count, Permutation);
+}
+
+void Math::RadixSort(unsigned long long const *Keys, std::size_t Count, unsigned int *Permutation)
+{
+	Sort(Keys, Count, Permutation);
+}
@@ -0,0 +1,71 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_RADIXSORT
+#define SMALLMATH_RADIXSORT
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Math
+{
+	// Stable LSD radix sort on 8-bit digits.  Each pass histograms and scatters per-thread ranges
+	// in parallel, and passes over digits that are the same in every key are skipped, so 30-bit
+	// codes take at most four passes.
+	//
+	// Writes the permutation that sorts Keys, without moving them: Keys[Permutation[0]] is the
+	// smallest key.
+	void RadixSort(unsigned int const *Keys, std::size_t Count, unsigned int *Permutation);
+	void RadixSort(unsigned long long const *Keys, std::size_t Count, unsigned int *Permutation);
+
+	// Reorders Data in place so that Data[i] becomes the old Data[Permutation[i]].  Works on any
+	// copyable type; for SoA data, call it once for each array.
+	template <typename T>
+	void ApplyPermutation(unsigned int const *Permutation, std::size_t Count, T *Data)
+	{
+		std::vector<bool> Done(Count, false);
+
+		// Follow each cycle of the permutation, shifting the elements along it by one.
+		for (std::size_t First = 0; First < Count; First++)
+		{
+			if (Done[First])
+				continue;
+
+			T Saved = std::move(Data[First]);
+			std::size_t Index = First;
+
+			for (;;)
+			{
+				Done[Index] = true;
+				std::size_t Next = Permutation[Index];
+
+				if (Next == First)
+					break;
+
+				Data[Index] = std::move(Data[Next]);
+				Index = Next;
+			}
+
+			Data[Index] = std::move(Saved);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,548 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "math/Decomposition.hpp"
+#include "math/FloatingPoint.hpp"
+#include "math/Parallel.hpp"
+#include "math/Registration.hpp"
+
+using namespace Math;
+
+namespace
+{
+	std::size_t const ParallelGrain = 16384;
+
+	Quaternion HornRotation(double const (&S)[3][3], double *Largest = NULL)
+	{
+		double Sxx = S[0][0], Sxy = S[0][1], Sxz = S[0][2];
+		double Syx = S[1][0], Syy = S[1][1], Syz = S[1][2];
+		double Szx = S[2][0], Szy = S[2][1], Szz = S[2][2];
+
+		// The rotation is the eigenvector of the largest eigenvalue of Horn's symmetric matrix.
+		double N[4][4] =
+		{
+			{Sxx + Syy + Szz, Syz - Szy,        Szx - Sxz,        Sxy - Syx},
+			{Syz - Szy,       Sxx - Syy - Szz,  Sxy + Syx,        Szx + Sxz},
+			{Szx - Sxz,       Sxy + Syx,        -Sxx + Syy - Szz, Syz + Szy},
+			{Sxy - Syx,       Szx + Sxz,        Syz + Szy,        -Sxx - Syy + Szz}
+		};
+
+		double Values[4], Vectors[4][4];
+		SymmetricEigen(N, Values, Vectors);
+		if (Largest != NULL)
+			*Largest = Values[0];
+
+		Quaternion q(static_cast<float>(Vectors[0][0]), static_cast<float>(Vectors[1][0]),
+					 static_cast<float>(Vectors[2][0]), static_cast<float>(Vectors[3][0]));
+		q.Normalize();
+		return q;
+	}
+
+	// Batched rigid fits ================================
+
+	int const FitWidth = 8;
+	std::size_t const FitGrain = 16;	// Blocks
+
+	double Cofactor(double const (&m)[4][4], int Row, int Column)
+	{
+		int r[3], c[3];
+		for (int i = 0, a = 0, b = 0; i < 4; i++)
+		{
+			if (i != Row)
+				r[a++] = i;
+			if (i != Column)
+				c[b++] = i;
+		}
+
+		double d = m[r[0]][c[0]] * (m[r[1]][c[1]] * m[r[2]][c[2]] - m[r[1]][c[2]] * m[r[2]][c[1]]) -
+				   m[r[0]][c[1]] * (m[r[1]][c[0]] * m[r[2]][c[2]] - m[r[1]][c[2]] * m[r[2]][c[0]]) +
+				   m[r[0]][c[2]] * (m[r[1]][c[0]] * m[r[2]][c[1]] - m[r[1]][c[1]] * m[r[2]][c[0]]);
+		return ((Row + Column) & 1 ? -d : d);
+	}
+
+	// Solves sets [First, First + Lanes) of a FitRigid() call, Lanes <= FitWidth.
+	void FitBlock(Vector3 const *Source, Vector3 const *Target, unsigned int const *Offsets,
+				  std::size_t First, int Lanes, RigidFit *Results)
+	{
+		static Vector3 const Unused;
+
+		Vector3 const *sp[FitWidth], *tp[FitWidth];
+		unsigned int Count[FitWidth], MaxCount = 0;
+
+		for (int l = 0; l < FitWidth; l++)
+		{
+			Count[l] = (l < Lanes ? Offsets[First + l + 1] - Offsets[First + l] : 0);
+			sp[l] = (Count[l] > 0 ? Source + Offsets[First + l] : &Unused);
+			tp[l] = (Count[l] > 0 ? Target + Offsets[First + l] : &Unused);
+			MaxCount = std::max(MaxCount, Count[l]);
+		}
+
+		// Sums relative to each set's first pair.  Lanes past their count re-read that pair, which
+		// adds nothing.
+		double s0[3][FitWidth], t0[3][FitWidth];
+		double Ss[3][FitWidth], St[3][FitWidth], C[3][3][FitWidth], Gs[FitWidth], Gt[FitWidth];
+
+		for (int l = 0; l < FitWidth; l++)
+		{
+			s0[0][l] = sp[l]->x; s0[1][l] = sp[l]->y; s0[2][l] = sp[l]->z;
+			t0[0][l] = tp[l]->x; t0[1][l] = tp[l]->y; t0[2][l] = tp[l]->z;
+			Gs[l] = Gt[l] = 0.0;
+			for (int a = 0; a < 3; a++)
+			{
+				Ss[a][l] = St[a][l] = 0.0;
+				for (int b = 0; b < 3; b++)
+					C[a][b][l] = 0.0;
+			}
+		}
+
+		for (unsigned int j = 1; j < MaxCount; j++)
+		{
+			for (int l = 0; l < FitWidth; l++)
+			{
+				Vector3 const &p = sp[l][j < Count[l] ? j : 0];
+				Vector3 const &q = tp[l][j < Count[l] ? j : 0];
+				double s[3] = {p.x - s0[0][l], p.y - s0[1][l], p.z - s0[2][l]};
+				double t[3] = {q.x - t0[0][l], q.y - t0[1][l], q.z - t0[2][l]};
+
+				for (int a = 0; a < 3; a++)
+				{
+					Ss[a][l] += s[a];
+					St[a][l] += t[a];
+					Gs[l] += s[a] * s[a];
+					Gt[l] += t[a] * t[a];
+					for (int b = 0; b < 3; b++)
+						C[a][b][l] += s[a] * t[b];
+				}
+			}
+		}
+
+		// Center, then form the characteristic quartic of Horn's N, x^4 + c2 x^2 + c1 x + c0.
+		double n[FitWidth], c2[FitWidth], c1[FitWidth], c0[FitWidth], Lambda[FitWidth];
+
+		for (int l = 0; l < FitWidth; l++)
+		{
+			n[l] = (Count[l] > 0 ? double(Count[l]) : 1.0);
+
+			for (int a = 0; a < 3; a++)
+			{
+				for (int b = 0; b < 3; b++)
+					C[a][b][l] -= Ss[a][l] * St[b][l] / n[l];
+				Gs[l] -= Ss[a][l] * Ss[a][l] / n[l];
+				Gt[l] -= St[a][l] * St[a][l] / n[l];
+			}
+
+			double Sxx = C[0][0][l], Sxy = C[0][1][l], Sxz = C[0][2][l];
+			double Syx = C[1][0][l], Syy = C[1][1][l], Syz = C[1][2][l];
+			double Szx = C[2][0][l], Szy = C[2][1][l], Szz = C[2][2][l];
+
+			double Sxx2 = Sxx * Sxx, Syy2 = Syy * Syy, Szz2 = Szz * Szz;
+			double Sxy2 = Sxy * Sxy, Syz2 = Syz * Syz, Sxz2 = Sxz * Sxz;
+			double Syx2 = Syx * Syx, Szy2 = Szy * Szy, Szx2 = Szx * Szx;
+
+			double SyzSzymSyySzz2 = 2.0 * (Syz * Szy - Syy * Szz);
+			double Sxx2Syy2Szz2Syz2Szy2 = Syy2 + Szz2 - Sxx2 + Syz2 + Szy2;
+			double Sxy2Sxz2Syx2Szx2 = Sxy2 + Sxz2 - Syx2 - Szx2;
+			double SxzpSzx = Sxz + Szx, SyzpSzy = Syz + Szy, SxypSyx = Sxy + Syx;
+			double SyzmSzy = Syz - Szy, SxzmSzx = Sxz - Szx, SxymSyx = Sxy - Syx;
+			double SxxpSyy = Sxx + Syy, SxxmSyy = Sxx - Syy;
+
+			c2[l] = -2.0 * (Sxx2 + Syy2 + Szz2 + Sxy2 + Syx2 + Sxz2 + Szx2 + Syz2 + Szy2);
+			c1[l] = 8.0 * (Sxx * Syz * Szy + Syy * Szx * Sxz + Szz * Sxy * Syx -
+						   Sxx * Syy * Szz - Syz * Szx * Sxy - Szy * Syx * Sxz);
+			c0[l] = Sxy2Sxz2Syx2Szx2 * Sxy2Sxz2Syx2Szx2 +
+					(Sxx2Syy2Szz2Syz2Szy2 + SyzSzymSyySzz2) * (Sxx2Syy2Szz2Syz2Szy2 - SyzSzymSyySzz2) +
+					(-SxzpSzx * SyzmSzy + SxymSyx * (SxxmSyy - Szz)) * (-SxzmSzx * SyzpSzy + SxymSyx * (SxxmSyy + Szz)) +
+					(-SxzpSzx * SyzpSzy - SxypSyx * (SxxpSyy - Szz)) * (-SxzmSzx * SyzmSzy - SxypSyx * (SxxpSyy + Szz)) +
+					(SxypSyx * SyzpSzy + SxzpSzx * (SxxmSyy + Szz)) * (-SxymSyx * SyzmSzy + SxzpSzx * (SxxpSyy + Szz)) +
+					(SxypSyx * SyzmSzy + SxzmSzx * (SxxmSyy - Szz)) * (-SxymSyx * SyzpSzy + SxzmSzx * (SxxpSyy - Szz));
+
+			// (Gs + Gt) / 2 bounds the largest eigenvalue from above, and the quartic is convex past
+			// it, so Newton's method descends onto it without overshooting.
+			Lambda[l] = 0.5 * (Gs[l] + Gt[l]);
+		}
+
+		for (int Iteration = 0; Iteration < 50; Iteration++)
+		{
+			bool Converged = true;
+
+			for (int l = 0; l < FitWidth; l++)
+			{
+				double x = Lambda[l], x2 = x * x;
+				double b = (x2 + c2[l]) * x;
+				double a = b + c1[l];
+				double Slope = 2.0 * x2 * x + b + a;
+				double Delta = (Slope != 0.0 ? (a * x + c0[l]) / Slope : 0.0);
+
+				Lambda[l] = x - Delta;
+				Converged &= (std::abs(Delta) <= 1.0e-11 * std::abs(Lambda[l]));
+			}
+
+			if (Converged)
+				break;
+		}
+
+		for (int l = 0; l < Lanes; l++)
+		{
+			RigidFit &r = Results[First + l];
+			r = RigidFit();
+			if (Count[l] == 0)
+				continue;
+
+			double Sxx = C[0][0][l], Sxy = C[0][1][l], Sxz = C[0][2][l];
+			double Syx = C[1][0][l], Syy = C[1][1][l], Syz = C[1][2][l];
+			double Szx = C[2][0][l], Szy = C[2][1][l], Szz = C[2][2][l];
+			double x = Lambda[l];
+			double Scale = 0.5 * (Gs[l] + Gt[l]);
+
+			double M[4][4] =
+			{
+				{Sxx + Syy + Szz - x, Syz - Szy,           Szx - Sxz,            Sxy - Syx},
+				{Syz - Szy,           Sxx - Syy - Szz - x, Sxy + Syx,            Szx + Sxz},
+				{Szx - Sxz,           Sxy + Syx,           -Sxx + Syy - Szz - x, Syz + Szy},
+				{Sxy - Syx,           Szx + Sxz,           Syz + Szy,            -Sxx - Syy + Szz - x}
+			};
+
+			// Every column of adj(N - lambda I) is a multiple of the eigenvector; take the longest.
+			double q[4] = {1.0, 0.0, 0.0, 0.0}, Best = 0.0;
+			for (int Column = 0; Column < 4; Column++)
+			{
+				double v[4], Length = 0.0;
+				for (int Row = 0; Row < 4; Row++)
+				{
+					v[Row] = Cofactor(M, Column, Row);
+					Length += v[Row] * v[Row];
+				}
+
+				if (Length > Best)
+				{
+					Best = Length;
+					for (int Row = 0; Row < 4; Row++)
+						q[Row] = v[Row];
+				}
+			}
+
+			if (Scale <= 0.0)
+				r.Rotation = Quaternion();
+			else if (Best <= 1.0e-8 * Scale * Scale * Scale * Scale * Scale * Scale)
+			{
+				// A (nearly) repeated largest eigenvalue, as with collinear points: the adjugate
+				// vanishes and the quartic's root is poorly conditioned, so take both the rotation
+				// and the eigenvalue from the Jacobi solve.
+				double S[3][3];
+				for (int a = 0; a < 3; a++)
+				{
+					for (int b = 0; b < 3; b++)
+						S[a][b] = C[a][b][l];
+				}
+				r.Rotation = HornRotation(S, &x);
+			}
+			else
+			{
+				double Length = std::sqrt(Best) * (q[0] < 0.0 ? -1.0 : 1.0);
+				r.Rotation = Quaternion(static_cast<float>(q[0] / Length), static_cast<float>(q[1] / Length),
+										static_cast<float>(q[2] / Length), static_cast<float>(q[3] / Length));
+			}
+
+			Vector3 SourceCentroid(static_cast<float>(s0[0][l] + Ss[0][l] / n[l]),
+								   static_cast<float>(s0[1][l] + Ss[1][l] / n[l]),
+								   static_cast<float>(s0[2][l] + Ss[2][l] / n[l]));
+			Vector3 TargetCentroid(static_cast<float>(t0[0][l] + St[0][l] / n[l]),
+								   static_cast<float>(t0[1][l] + St[1][l] / n[l]),
+								   static_cast<float>(t0[2][l] + St[2][l] / n[l]));
+			r.Translation = TargetCentroid - r.Rotation * SourceCentroid;
+			r.Rms = static_cast<float>(std::sqrt(std::max(Gs[l] + Gt[l] - 2.0 * x, 0.0) / n[l]));
+		}
+	}
+
+	// Per-thread sums for one ICP iteration
+	struct Sums
+	{
+		Sums() : Count(0), ErrorSquared(0.0)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				Source[i] = Target[i] = 0.0;
+				for (int j = 0; j < 3; j++)
+					Cross[i][j] = 0.0;
+			}
+
+			for (int i = 0; i < 6; i++)
+			{
+				b[i] = 0.0;
+				for (int j = 0; j < 6; j++)
+					A[i][j] = 0.0;
+			}
+		}
+
+		void Add(Sums const &s)
+		{
+			Count += s.Count;
+			ErrorSquared += s.ErrorSquared;
+
+			for (int i = 0; i < 3; i++)
+			{
+				Source[i] += s.Source[i];
+				Target[i] += s.Target[i];
+				for (int j = 0; j < 3; j++)
+					Cross[i][j] += s.Cross[i][j];
+			}
+
+			for (int i = 0; i < 6; i++)
+			{
+				b[i] += s.b[i];
+				for (int j = 0; j < 6; j++)
+					A[i][j] += s.A[i][j];
+			}
+		}
+
+		std::size_t Count;
+		double ErrorSquared;
+		double Source[3], Target[3], Cross[3][3];	// Point to point
+		double A[6][6], b[6];						// Point to plane normal equations
+	};
+
+	float AngleOf(Quaternion const &q)
+	{
+		float Sine = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z);
+		return 2.0f * std::atan2(Sine, std::abs(q.w));
+	}
+}
+
+Quaternion Math::HornRotation(Matrix3 const &Covariance)
+{
+	double S[3][3];
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+			S[i][j] = Covariance.m[i][j];
+	}
+
+	return ::HornRotation(S);
+}
+
+RigidFit Math::FitRigid(Vector3 const *Source, Vector3 const *Target, std::size_t Count)
+{
+	unsigned int Offsets[2] = {0, static_cast<unsigned int>(Count)};
+	RigidFit Result;
+	FitBlock(Source, Target, Offsets, 0, 1, &Result);
+	return Result;
+}
+
+void Math::FitRigid(Vector3 const *Source, Vector3 const *Target, unsigned int const *Offsets,
+					std::size_t SetCount, RigidFit *Results)
+{
+	std::size_t Blocks = (SetCount + FitWidth - 1) / FitWidth;
+
+	Parallel::For(Blocks, FitGrain, [&](std::size_t Begin, std::size_t End)
+	{
+		for (std::size_t Block = Begin; Block < End; Block++)
+		{
+			std::size_t First = Block * FitWidth;
+			FitBlock(Source, Target, Offsets, First, static_cast<int>(std::min<std::size_t>(FitWidth, SetCount - First)), Results);
+		}
+	});
+
+	static_assert(sizeof(RigidFit) == 8 * sizeof(float), "RigidFit is checked as plain floats");
+	CheckOutput("FitRigid", reinterpret_cast<float const *>(Results), SetCount, 8);
+}
+
+Icp::Icp()
+{
+
+}
+
+void Icp::SetTarget(Vector3 const *Points, Vector3 const *Normals, std::size_t Count)
+{
+	this->Points.assign(Points, Points + Count);
+
+	if (Normals != NULL)
+		this->Normals.assign(Normals, Normals + Count);
+	else
+		this->Normals.clear();
+
+	Tree.Build(Points, Count);
+}
+
+IcpResult Icp::Align(Vector3 const *Source, std::size_t Count, IcpSettings const &Settings,
+					 Quaternion const &Rotation, Vector3 const &Translation) const
+{
+	IcpResult Result;
+	Result.Rotation = Rotation.Normalized();
+	Result.Translation = Translation;
+
+	bool PointToPlane = (Settings.Method == IcpSettings::PointToPlane);
+	if (Count == 0 || Points.empty() || (PointToPlane && Normals.size() != Points.size()))
+		return Result;
+
+	std::vector<Vector3, AlignedAllocator<Vector3> > Moved(Count);
+	std::vector<unsigned int> Matches(Count);
+	std::vector<float> Distances(Count);
+
+	std::size_t Chunks = (Count + ParallelGrain - 1) / ParallelGrain;
+	if (Chunks > Parallel::ThreadCount())
+		Chunks = Parallel::ThreadCount();
+	std::vector<Sums> Partial(Chunks);
+
+	float MaxDistanceSquared = Settings.MaxDistance * Settings.MaxDistance;
+	double PreviousRms = -1.0;
+
+	for (unsigned int Iteration = 0; Iteration < Settings.MaxIterations; Iteration++)
+	{
+		Matrix3 r(Result.Rotation);
+		Vector3 t = Result.Translation;
+
+		Parallel::For(Count, ParallelGrain, [&](std::size_t Begin, std::size_t End)
+		{
+			for (std::size_t Index = Begin; Index < End; Index++)
+				Moved[Index] = r * Source[Index] + t;
+		});
+
+		Tree.Nearest(&Moved[0], Count, 1, &Matches[0], &Distances[0]);
+
+		Parallel::For(Chunks, 1, [&](std::size_t Begin, std::size_t End)
+		{
+			for (std::size_t Chunk = Begin; Chunk < End; Chunk++)
+			{
+				Sums s;
+
+				for (std::size_t Index = Count * Chunk / Chunks; Index < Count * (Chunk + 1) / Chunks; Index++)
+				{
+					if (Matches[Index] == KdTree::EmptySlot || !(Distances[Index] <= MaxDistanceSquared))
+						continue;
+
+					Vector3 const &p = Moved[Index];
+					Vector3 const &q = Points[Matches[Index]];
+
+					s.Count++;
+					s.ErrorSquared += Distances[Index];
+
+					if (PointToPlane)
+					{
+						// Residual (p - q) . n, linearized in a small rotation w and translation u:
+						// r + w . (p x n) + u . n
+						Vector3 const &n = Normals[Matches[Index]];
+						Vector3 c = p.Cross(n);
+						double J[6] = {c.x, c.y, c.z, n.x, n.y, n.z};
+						double e = (p - q).Dot(n);
+
+						for (int i = 0; i < 6; i++)
+						{
+							s.b[i] -= J[i] * e;
+							for (int j = i; j < 6; j++)
+								s.A[i][j] += J[i] * J[j];
+						}
+					}
+					else
+					{
+						double ps[3] = {p.x, p.y, p.z};
+						double qs[3] = {q.x, q.y, q.z};
+
+						for (int i = 0; i < 3; i++)
+						{
+							s.Source[i] += ps[i];
+							s.Target[i] += qs[i];
+							for (int j = 0; j < 3; j++)
+								s.Cross[i][j] += ps[i] * qs[j];
+						}
+					}
+				}
+
+				Partial[Chunk] = s;
+			}
+		});
+
+		Sums Total;
+		for (std::size_t Chunk = 0; Chunk < Chunks; Chunk++)
+			Total.Add(Partial[Chunk]);
+
+		if (Total.Count < (PointToPlane ? 6u : 3u))
+			break;
+
+		double Rms = std::sqrt(Total.ErrorSquared / double(Total.Count));
+		Result.Rms = static_cast<float>(Rms);
+		Result.Correspondences = Total.Count;
+		Result.Iterations = Iteration + 1;
+
+		if (PreviousRms >= 0.0 && PreviousRms - Rms <= Settings.MinImprovement * PreviousRms)
+		{
+			Result.Converged = true;
+			break;
+		}
+
+		PreviousRms = Rms;
+
+		Quaternion Step;
+		Vector3 Shift;
+
+		if (PointToPlane)
+		{
+			for (int i = 0; i < 6; i++)
+			{
+				for (int j = 0; j < i; j++)
+					Total.A[i][j] = Total.A[j][i];
+			}
+
+			double x[6];
+			if (!Solve(Total.A, Total.b, x))
+				break;
+
+			Vector3 w(static_cast<float>(x[0]), static_cast<float>(x[1]), static_cast<float>(x[2]));
+			float Angle = w.Length();
+			if (Angle > 0.0f)
+				Step = Quaternion(Angle, w / Angle);
+
+			Shift = Vector3(static_cast<float>(x[3]), static_cast<float>(x[4]), static_cast<float>(x[5]));
+		}
+		else
+		{
+			double n = double(Total.Count);
+			double Covariance[3][3];
+
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++)
+					Covariance[i][j] = Total.Cross[i][j] / n - (Total.Source[i] / n) * (Total.Target[j] / n);
+			}
+
+			Step = ::HornRotation(Covariance);
+
+			Vector3 SourceCentroid(static_cast<float>(Total.Source[0] / n),
+								   static_cast<float>(Total.Source[1] / n),
+								   static_cast<float>(Total.Source[2] / n));
+			Vector3 TargetCentroid(static_cast<float>(Total.Target[0] / n),
+								   static_cast<float>(Total.Target[1] / n),
+								   static_cast<float>(Total.Target[2] / n));
+			Shift = TargetCentroid - Step * SourceCentroid;
+		}
+
+		Result.Rotation = (Step * Result.Rotation).Normalized();
+		Result.Translation = Step * Result.Translation + Shift;
+
+		if (AngleOf(Step) < Settings.MinRotation && Shift.Length() < Settings.MinTranslation)
+		{
+			Result.Converged = true;
+			break;
+		}
+	}
+
+	return Result;
+}
@@ -0,0 +1,141 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_REGISTRATION
+#define SMALLMATH_REGISTRATION
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "math/Allocator.hpp"
+#include "math/KdTree.hpp"
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Rigid registration.  A rigid transform maps a point p to Rotation * p + Translation.
+
+	// Horn's closed-form absolute orientation.  Given the cross-covariance of centered point pairs,
+	// Covariance.m[a][b] = sum of (s - SourceCentroid)[a] * (t - TargetCentroid)[b], returns the
+	// unit quaternion R that minimizes the sum of |R * (s - SourceCentroid) - (t - TargetCentroid)|^2.
+	// The translation is then TargetCentroid - R * SourceCentroid.
+	Quaternion HornRotation(Matrix3 const &Covariance);
+
+	// Batched rigid fits =================================
+
+	class RigidFit
+	{
+	public:
+		RigidFit() : Rms(0.0f) { }
+
+		Quaternion Rotation;
+		Vector3 Translation;
+		float Rms;					// Root mean square of |Rotation * s + Translation - t|
+	};
+
+	// Best-fit rigid transform taking Source[i] to Target[i] for i in [0, Count).
+	RigidFit FitRigid(Vector3 const *Source, Vector3 const *Target, std::size_t Count);
+
+	// Many small independent fits.  Set n is the pairs [Offsets[n], Offsets[n + 1]), so Offsets has
+	// SetCount + 1 entries.  Sets are solved eight at a time: each lane accumulates its centroids
+	// and cross-covariance in one pass over its pairs (relative to the set's first pair, to keep the
+	// sums well conditioned), then the largest eigenvalue of Horn's 4x4 matrix is found for all
+	// eight lanes together by Newton iteration on its characteristic quartic (Theobald's QCP) and
+	// the quaternion read off the adjugate of N - lambda I.  The RMS error follows from the
+	// eigenvalue without a second pass.  Sets whose largest eigenvalue is (nearly) repeated, such
+	// as collinear points, fall back to the Jacobi solve.  Blocks are split across threads.
+	void FitRigid(Vector3 const *Source, Vector3 const *Target, unsigned int const *Offsets,
+				  std::size_t SetCount, RigidFit *Results);
+
+	// Iterative closest point ============================
+
+	class IcpSettings
+	{
+	public:
+		enum Metric {PointToPoint, PointToPlane};
+
+		IcpSettings() :
+			Method(PointToPoint),
+			MaxIterations(30),
+			MaxDistance(std::numeric_limits<float>::max()),
+			MinImprovement(1.0e-5f),
+			MinRotation(1.0e-6f),
+			MinTranslation(1.0e-6f)
+		{ }
+
+		Metric Method;				// PointToPlane needs target normals
+		unsigned int MaxIterations;
+		float MaxDistance;			// Pairs further apart than this are ignored
+		float MinImprovement;		// Stop when the RMS error improves by less than this fraction
+		float MinRotation;			// or when an iteration rotates by less than this (radians)
+		float MinTranslation;		// and moves by less than this
+	};
+
+	class IcpResult
+	{
+	public:
+		IcpResult() : Rms(0.0f), Iterations(0), Correspondences(0), Converged(false) { }
+
+		Quaternion Rotation;
+		Vector3 Translation;
+		float Rms;					// Over the correspondences of the last iteration
+		unsigned int Iterations;
+		std::size_t Correspondences;
+		bool Converged;				// False if MaxIterations ran out or the system became degenerate
+	};
+
+	// Aligns source scans to a fixed target.  The target is indexed once by SetTarget(), and every
+	// Align() call reuses the index.
+	//
+	// Each iteration transforms the source, finds every point's nearest target point with the
+	// batched k-d tree query, and reduces the pairs into either the cross-covariance (point to
+	// point, solved with HornRotation) or the 6x6 normal equations of the linearized point to plane
+	// error.  The transform, correspondence and reduction passes are split across threads, and
+	// sums are accumulated per thread in double precision.
+	class Icp
+	{
+	public:
+		Icp();
+
+		// Normals may be NULL if only PointToPoint will be used.  The data is copied.
+		void SetTarget(Vector3 const *Points, Vector3 const *Normals, std::size_t Count);
+
+		IcpResult Align(Vector3 const *Source, std::size_t Count, IcpSettings const &Settings = IcpSettings(),
+						Quaternion const &Rotation = Quaternion(), Vector3 const &Translation = Vector3()) const;
+
+		inline KdTree const &Target() const;
+
+	private:
+		KdTree Tree;
+		std::vector<Vector3, AlignedAllocator<Vector3> > Points;
+		std::vector<Vector3, AlignedAllocator<Vector3> > Normals;
+	};
+
+	// Inline methods =====================================
+
+	inline KdTree const &Icp::Target() const
+	{
+		return Tree;
+	}
+}
+
+#endif
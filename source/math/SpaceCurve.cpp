@@ -0,0 +1,249 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include "math/Parallel.hpp"
+#include "math/SpaceCurve.hpp"
+
+using namespace Math;
+
+namespace
+{
+	std::size_t const ParallelGrain = 65536;
+
+	// Maps a box to integer coordinates in [0, 2^Bits).
+	template <int Bits>
+	class Quantizer
+	{
+	public:
+		Quantizer(AABB const &Bounds) : Min(Bounds.Min)
+		{
+			float const Cells = float(1u << Bits);
+			Vector3 e = Bounds.Extent();
+
+			Scale = Vector3(e.x > 0.0f ? Cells / e.x : 0.0f,
+							e.y > 0.0f ? Cells / e.y : 0.0f,
+							e.z > 0.0f ? Cells / e.z : 0.0f);
+		}
+
+		inline unsigned int operator()(float x, float Min, float Scale) const
+		{
+			float const Top = float((1u << Bits) - 1);
+			float q = (x - Min) * Scale;
+			q = (q > 0.0f ? q : 0.0f);		// Also maps NaN to 0
+			q = (q < Top ? q : Top);
+			return static_cast<unsigned int>(q);
+		}
+
+		inline void operator()(Vector3 const &p, unsigned int &x, unsigned int &y, unsigned int &z) const
+		{
+			x = (*this)(p.x, Min.x, Scale.x);
+			y = (*this)(p.y, Min.y, Scale.y);
+			z = (*this)(p.z, Min.z, Scale.z);
+		}
+
+	private:
+		Vector3 Min, Scale;
+	};
+
+	// Spreads the low 10 bits of x so there are two zero bits between each.
+	inline unsigned int Spread30(unsigned int x)
+	{
+		x &= 0x000003FFu;
+		x = (x | (x << 16)) & 0x030000FFu;
+		x = (x | (x << 8)) & 0x0300F00Fu;
+		x = (x | (x << 4)) & 0x030C30C3u;
+		x = (x | (x << 2)) & 0x09249249u;
+		return x;
+	}
+
+	// Same for the low 21 bits.
+	inline unsigned long long Spread63(unsigned long long x)
+	{
+		x &= 0x00000000001FFFFFull;
+		x = (x | (x << 32)) & 0x001F00000000FFFFull;
+		x = (x | (x << 16)) & 0x001F0000FF0000FFull;
+		x = (x | (x << 8)) & 0x100F00F00F00F00Full;
+		x = (x | (x << 4)) & 0x10C30C30C30C30C3ull;
+		x = (x | (x << 2)) & 0x1249249249249249ull;
+		return x;
+	}
+
+	inline void Interleave(unsigned int x, unsigned int y, unsigned int z, unsigned int &Code)
+	{
+		Code = (Spread30(x) << 2) | (Spread30(y) << 1) | Spread30(z);
+	}
+
+	inline void Interleave(unsigned int x, unsigned int y, unsigned int z, unsigned long long &Code)
+	{
+		Code = (Spread63(x) << 2) | (Spread63(y) << 1) | Spread63(z);
+	}
+
+	int const Width = 8;
+
+	// All ones in the lanes of a that have bit Q set, zero elsewhere.
+	inline void BitMask(unsigned int const *a, unsigned int Q, unsigned int *Mask)
+	{
+		for (int Lane = 0; Lane < Width; Lane++)
+			Mask[Lane] = 0u - ((a[Lane] & Q) != 0 ? 1u : 0u);
+	}
+
+	// Where a has bit Q set, inverts the low bits of x; elsewhere swaps the low bits of x and a.
+	inline void HilbertStep(unsigned int *x, unsigned int *a, unsigned int Q, unsigned int *Mask)
+	{
+		unsigned int P = Q - 1;
+		BitMask(a, Q, Mask);
+
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			unsigned int t = (x[Lane] ^ a[Lane]) & P & ~Mask[Lane];
+			x[Lane] ^= (P & Mask[Lane]) | t;
+			a[Lane] ^= t;
+		}
+	}
+
+	// Skilling's transform ("Programming the Hilbert curve", 2004) from axis coordinates to the
+	// transposed Hilbert index, whose bits interleave into the index exactly like a Morton code.
+	// The conditional bit flips and swaps are done with masks, so each step is one branch-free
+	// loop over the lanes.
+	template <int Bits>
+	inline void HilbertTranspose(unsigned int *x, unsigned int *y, unsigned int *z)
+	{
+		unsigned int Mask[Width];
+
+		for (unsigned int Q = 1u << (Bits - 1); Q > 1; Q >>= 1)
+		{
+			// Where x has bit Q set, invert its low bits.
+			BitMask(x, Q, Mask);
+			for (int Lane = 0; Lane < Width; Lane++)
+				x[Lane] ^= (Q - 1) & Mask[Lane];
+
+			HilbertStep(x, y, Q, Mask);
+			HilbertStep(x, z, Q, Mask);
+		}
+
+		// Gray encode
+		unsigned int t[Width] = {0};
+
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			y[Lane] ^= x[Lane];
+			z[Lane] ^= y[Lane];
+		}
+
+		for (unsigned int Q = 1u << (Bits - 1); Q > 1; Q >>= 1)
+		{
+			BitMask(z, Q, Mask);
+			for (int Lane = 0; Lane < Width; Lane++)
+				t[Lane] ^= (Q - 1) & Mask[Lane];
+		}
+
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			x[Lane] ^= t[Lane];
+			y[Lane] ^= t[Lane];
+			z[Lane] ^= t[Lane];
+		}
+	}
+
+	template <typename Code, int Bits, bool Hilbert>
+	class Encoder
+	{
+	public:
+		Encoder(AABB const &Bounds) : q(Bounds) { }
+
+		// Encodes up to Width points.  Missing lanes repeat the first point and are not written.
+		inline void operator()(Vector3 const *Points, int Count, Code *Codes) const
+		{
+			unsigned int x[Width], y[Width], z[Width];
+
+			for (int Lane = 0; Lane < Width; Lane++)
+				q(Points[Lane < Count ? Lane : 0], x[Lane], y[Lane], z[Lane]);
+
+			if (Hilbert)
+				HilbertTranspose<Bits>(x, y, z);
+
+			for (int Lane = 0; Lane < Count; Lane++)
+				Interleave(x[Lane], y[Lane], z[Lane], Codes[Lane]);
+		}
+
+	private:
+		Quantizer<Bits> q;
+	};
+
+	template <typename Code, int Bits, bool Hilbert>
+	inline Code Encode(Vector3 const &p, AABB const &Bounds)
+	{
+		Encoder<Code, Bits, Hilbert> e(Bounds);
+		Code r;
+		e(&p, 1, &r);
+		return r;
+	}
+
+	template <typename Code, int Bits, bool Hilbert>
+	void Encode(Vector3 const *Points, std::size_t Count, AABB const &Bounds, Code *Codes)
+	{
+		Encoder<Code, Bits, Hilbert> e(Bounds);
+
+		Parallel::For(Count, ParallelGrain, [&](std::size_t Begin, std::size_t End)
+		{
+			for (std::size_t Index = Begin; Index < End; Index += Width)
+				e(Points + Index, static_cast<int>(End - Index < std::size_t(Width) ? End - Index : Width), Codes + Index);
+		});
+	}
+}
+
+unsigned int Math::Morton30(Vector3 const &p, AABB const &Bounds)
+{
+	return Encode<unsigned int, 10, false>(p, Bounds);
+}
+
+unsigned long long Math::Morton63(Vector3 const &p, AABB const &Bounds)
+{
+	return Encode<unsigned long long, 21, false>(p, Bounds);
+}
+
+unsigned int Math::Hilbert30(Vector3 const &p, AABB const &Bounds)
+{
+	return Encode<unsigned int, 10, true>(p, Bounds);
+}
+
+unsigned long long Math::Hilbert63(Vector3 const &p, AABB const &Bounds)
+{
+	return Encode<unsigned long long, 21, true>(p, Bounds);
+}
+
+void Math::Morton30(Vector3 const *Points, std::size_t Count, AABB const &Bounds, unsigned int *Codes)
+{
+	Encode<unsigned int, 10, false>(Points, Count, Bounds, Codes);
+}
+
+void Math::Morton63(Vector3 const *Points, std::size_t Count, AABB const &Bounds, unsigned long long *Codes)
+{
+	Encode<unsigned long long, 21, false>(Points, Count, Bounds, Codes);
+}
+
+void Math::Hilbert30(Vector3 const *Points, std::size_t Count, AABB const &Bounds, unsigned int *Codes)
+{
+	Encode<unsigned int, 10, true>(Points, Count, Bounds, Codes);
+}
+
+void Math::Hilbert63(Vector3 const *Points, std::size_t Count, AABB const &Bounds, unsigned long long *Codes)
+{
+	Encode<unsigned long long, 21, true>(Points, Count, Bounds, Codes);
+}
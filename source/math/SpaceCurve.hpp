@@ -0,0 +1,49 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_SPACECURVE
+#define SMALLMATH_SPACECURVE
+
+#include <cstddef>
+
+#include "math/Bounds.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Space-filling curve codes for points inside a box.  Each point is quantized to 10 (30-bit
+	// codes) or 21 (63-bit codes) bits per axis relative to Bounds; points outside are clamped to
+	// it.  Bits are interleaved with x highest, so sorting by code orders points along the curve.
+	//
+	// Morton (Z-order) codes are cheaper; Hilbert codes never jump between distant cells, which
+	// gives somewhat better locality.  The batch forms are branch-free lane loops, split across
+	// threads for large inputs; sort the codes with RadixSort().
+
+	unsigned int Morton30(Vector3 const &p, AABB const &Bounds);
+	unsigned long long Morton63(Vector3 const &p, AABB const &Bounds);
+	unsigned int Hilbert30(Vector3 const &p, AABB const &Bounds);
+	unsigned long long Hilbert63(Vector3 const &p, AABB const &Bounds);
+
+	void Morton30(Vector3 const *Points, std::size_t Count, AABB const &Bounds, unsigned int *Codes);
+	void Morton63(Vector3 const *Points, std::size_t Count, AABB const &Bounds, unsigned long long *Codes);
+	void Hilbert30(Vector3 const *Points, std::size_t Count, AABB const &Bounds, unsigned int *Codes);
+	void Hilbert63(Vector3 const *Points, std::size_t Count, AABB const &Bounds, unsigned long long *Codes);
+}
+
+#endif
@@ -0,0 +1,264 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#include <algorithm>
+#include <limits>
+
+#include "math/Bounds.hpp"
+#include "math/Parallel.hpp"
+#include "math/SpatialHash.hpp"
+
+using namespace Math;
+
+namespace
+{
+	std::size_t const ParallelGrain = 65536;
+}
+
+SpatialHash::SpatialHash() :
+	Size(1.0f),
+	InverseSize(1.0f),
+	Mask(0)
+{
+
+}
+
+void SpatialHash::Build(Vector3 const *Points, std::size_t Count, float CellSize)
+{
+	Size = (CellSize > 0.0f ? CellSize : 1.0f);
+	InverseSize = 1.0f / Size;
+
+	// At least one bucket per point keeps the expected bucket load below one cell.
+	unsigned int Buckets = 1;
+	while (Buckets < Count && Buckets < 0x80000000u)
+		Buckets <<= 1;
+	Mask = Buckets - 1;
+
+	std::vector<unsigned int> Keys(Count);
+	Parallel::For(Count, ParallelGrain, [&](std::size_t Begin, std::size_t End)
+	{
+		for (std::size_t Index = Begin; Index < End; Index++)
+		{
+			Vector3 const &p = Points[Index];
+			Keys[Index] = this->Bucket(this->Cell(p.x), this->Cell(p.y), this->Cell(p.z));
+		}
+	});
+
+	// Counting sort.  Start[b + 1] counts bucket b, then the prefix sum turns it into b's end.
+	Start.assign(static_cast<std::size_t>(Buckets) + 1, 0);
+	for (std::size_t Index = 0; Index < Count; Index++)
+		Start[Keys[Index] + 1]++;
+
+	for (unsigned int b = 0; b < Buckets; b++)
+		Start[b + 1] += Start[b];
+
+	Entries.resize(Count);
+
+	// Scattering in input order keeps every bucket sorted by id.  It also advances Start[b] to
+	// the end of bucket b, so everything is shifted back by one afterwards.
+	for (std::size_t Index = 0; Index < Count; Index++)
+	{
+		Entry &e = Entries[Start[Keys[Index]]++];
+		e.x = Points[Index].x;
+		e.y = Points[Index].y;
+		e.z = Points[Index].z;
+		e.Id = static_cast<unsigned int>(Index);
+	}
+
+	for (unsigned int b = Buckets; b > 0; b--)
+		Start[b] = Start[b - 1];
+	Start[0] = 0;
+}
+
+void SpatialHash::Clear()
+{
+	Mask = 0;
+	Start.clear();
+	Entries.clear();
+}
+
+std::size_t SpatialHash::Query(Vector3 const &Center, float Radius, std::vector<unsigned int> &Ids) const
+{
+	std::size_t First = Ids.size();
+
+	if (Entries.empty() || !(Radius >= 0.0f))
+		return 0;
+
+	float RadiusSquared = Radius * Radius;
+	int Low[3] = {this->Cell(Center.x - Radius), this->Cell(Center.y - Radius), this->Cell(Center.z - Radius)};
+	int High[3] = {this->Cell(Center.x + Radius), this->Cell(Center.y + Radius), this->Cell(Center.z + Radius)};
+
+	double Cells = (double(High[0]) - Low[0] + 1) * (double(High[1]) - Low[1] + 1) * (double(High[2]) - Low[2] + 1);
+
+	// A radius spanning more cells than there are buckets is cheaper as a plain scan.
+	if (Cells > double(Mask) + 1.0)
+	{
+		for (std::size_t Slot = 0; Slot < Entries.size(); Slot++)
+		{
+			Entry const &e = Entries[Slot];
+			float dx = e.x - Center.x, dy = e.y - Center.y, dz = e.z - Center.z;
+			if (dx * dx + dy * dy + dz * dz <= RadiusSquared)
+				Ids.push_back(e.Id);
+		}
+
+		return Ids.size() - First;
+	}
+
+	for (int cz = Low[2]; cz <= High[2]; cz++)
+	{
+		for (int cy = Low[1]; cy <= High[1]; cy++)
+		{
+			for (int cx = Low[0]; cx <= High[0]; cx++)
+			{
+				unsigned int b = this->Bucket(cx, cy, cz);
+
+				for (unsigned int Slot = Start[b]; Slot < Start[b + 1]; Slot++)
+				{
+					Entry const &e = Entries[Slot];
+					float dx = e.x - Center.x, dy = e.y - Center.y, dz = e.z - Center.z;
+					if (dx * dx + dy * dy + dz * dz > RadiusSquared)
+						continue;
+
+					// Another cell in range may share this bucket; only report the point from its own.
+					if (this->Cell(e.x) == cx && this->Cell(e.y) == cy && this->Cell(e.z) == cz)
+						Ids.push_back(e.Id);
+				}
+			}
+		}
+	}
+
+	return Ids.size() - First;
+}
+
+unsigned int SpatialHash::Earliest(Vector3 const &p, unsigned int Before, float Tolerance, bool Exact, unsigned char const *Accept) const
+{
+	float ToleranceSquared = Tolerance * Tolerance;
+	unsigned int Match = Before;
+
+	int Low[3] = {this->Cell(p.x - Tolerance), this->Cell(p.y - Tolerance), this->Cell(p.z - Tolerance)};
+	int High[3] = {this->Cell(p.x + Tolerance), this->Cell(p.y + Tolerance), this->Cell(p.z + Tolerance)};
+
+	for (int cz = Low[2]; cz <= High[2]; cz++)
+	{
+		for (int cy = Low[1]; cy <= High[1]; cy++)
+		{
+			for (int cx = Low[0]; cx <= High[0]; cx++)
+			{
+				unsigned int b = this->Bucket(cx, cy, cz);
+
+				// Buckets are sorted by id, so the first match in each is the earliest one there.
+				for (unsigned int Slot = Start[b]; Slot < Start[b + 1]; Slot++)
+				{
+					Entry const &e = Entries[Slot];
+					if (e.Id >= Match)
+						break;
+
+					if (Accept != NULL && !Accept[e.Id])
+						continue;
+
+					float dx = e.x - p.x, dy = e.y - p.y, dz = e.z - p.z;
+					bool Near = (Exact ? (dx == 0.0f && dy == 0.0f && dz == 0.0f) :
+										 (dx * dx + dy * dy + dz * dz <= ToleranceSquared));
+
+					if (Near)
+					{
+						Match = e.Id;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	return Match;
+}
+
+std::size_t Math::Weld(Vector3 const *Points, std::size_t Count, float Tolerance, unsigned int *Remap, Vector3 *Unique)
+{
+	if (Count == 0)
+		return 0;
+
+	// Cells a few times the tolerance wide mean that most searches stay within one or two cells;
+	// at exactly the tolerance every search would touch eight or more scattered buckets.
+	bool Exact = !(Tolerance > 0.0f);
+	float CellSize = 4.0f * Tolerance;
+
+	// Without a tolerance to size the cells, aim for about one point per cell.
+	if (Exact)
+	{
+		AABB Bounds;
+		for (std::size_t Index = 0; Index < Count; Index++)
+			Bounds.Extend(Points[Index]);
+
+		Vector3 e = Bounds.Extent();
+		float Largest = std::max(e.x, std::max(e.y, e.z));
+		CellSize = Largest / std::cbrt(static_cast<float>(Count));
+
+		if (!(CellSize > 0.0f) || !(CellSize < std::numeric_limits<float>::max()))
+			CellSize = 1.0f;
+
+		Tolerance = 0.0f;
+	}
+
+	SpatialHash Hash;
+	Hash.Build(Points, Count, CellSize);
+
+	// First pass, in bucket order so that neighboring cells stay in cache: the earliest point
+	// within Tolerance of each point, whether or not that one turns out to be unique.
+	std::vector<unsigned int> Earliest(Count);
+	Parallel::For(Count, ParallelGrain, [&](std::size_t Begin, std::size_t End)
+	{
+		for (std::size_t Slot = Begin; Slot < End; Slot++)
+		{
+			SpatialHash::Entry const &e = Hash.Entries[Slot];
+			Earliest[e.Id] = Hash.Earliest(Vector3(e.x, e.y, e.z), e.Id, Tolerance, Exact, NULL);
+		}
+	});
+
+	// Second pass, in input order.  A point is unique if nothing earlier is in range.  Otherwise
+	// it joins the earliest unique point in range, which is the one found above unless that one
+	// was itself merged away; only then is the neighborhood searched again.
+	std::vector<unsigned char> IsUnique(Count, 0);
+	std::size_t UniqueCount = 0;
+
+	for (std::size_t Index = 0; Index < Count; Index++)
+	{
+		unsigned int Match = Earliest[Index];
+
+		if (Match != Index && !IsUnique[Match])
+			Match = Hash.Earliest(Points[Index], static_cast<unsigned int>(Index), Tolerance, Exact, &IsUnique[0]);
+
+		if (Match != Index)
+		{
+			Remap[Index] = Remap[Match];
+		}
+		else
+		{
+			IsUnique[Index] = 1;
+			Remap[Index] = static_cast<unsigned int>(UniqueCount);
+
+			if (Unique != NULL)
+				Unique[UniqueCount] = Points[Index];
+
+			UniqueCount++;
+		}
+	}
+
+	return UniqueCount;
+}
@@ -0,0 +1,113 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_SPATIALHASH
+#define SMALLMATH_SPATIALHASH
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "math/Allocator.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Uniform grid over points, hashed so that only occupied cells cost memory.
+	//
+	// Build() counting-sorts the points by bucket into one flat array, with no per-cell allocation.
+	// Each entry holds a copy of the point's position next to its id, so scanning a bucket touches
+	// one contiguous run of memory instead of chasing indices.  Buckets are kept in input order,
+	// and cells that share a bucket are told apart by recomputing each point's cell.
+	//
+	// Point ids reported by queries are indices into the array given to Build().
+
+	class SpatialHash
+	{
+	public:
+		SpatialHash();
+
+		void Build(Vector3 const *Points, std::size_t Count, float CellSize);
+		void Clear();
+
+		// Appends to Ids every point within Radius of Center, and returns how many were appended.
+		std::size_t Query(Vector3 const &Center, float Radius, std::vector<unsigned int> &Ids) const;
+
+		inline float CellSize() const;
+		inline std::size_t PointCount() const;
+
+	private:
+		friend std::size_t Weld(Vector3 const *Points, std::size_t Count, float Tolerance, unsigned int *Remap, Vector3 *Unique);
+
+		struct Entry
+		{
+			float x, y, z;
+			unsigned int Id;
+		};
+
+		// Smallest id below Before within Tolerance of p (or equal to p when Exact) that Accept, if
+		// given, marks nonzero.  Returns Before if there is none.
+		unsigned int Earliest(Vector3 const &p, unsigned int Before, float Tolerance, bool Exact, unsigned char const *Accept) const;
+
+		inline int Cell(float x) const;
+		inline unsigned int Bucket(int x, int y, int z) const;
+
+		float Size, InverseSize;
+		unsigned int Mask;							// Bucket count - 1
+		std::vector<unsigned int> Start;			// Bucket -> first entry, Mask + 2 of them
+		std::vector<Entry, AlignedAllocator<Entry> > Entries;
+	};
+
+	// Merges points that lie within Tolerance of an earlier point.  Points are visited in order;
+	// each becomes a new unique point unless it is within Tolerance of a unique point already
+	// found, in which case it maps to the earliest such point.  Remap[i] receives the unique index
+	// for point i, and if Unique is not NULL the unique points are written there in order (it may
+	// alias Points).  A Tolerance of 0 merges exact duplicates only.  Returns the number of unique
+	// points.
+	std::size_t Weld(Vector3 const *Points, std::size_t Count, float Tolerance, unsigned int *Remap, Vector3 *Unique = NULL);
+
+	// Inline methods =====================================
+
+	inline float SpatialHash::CellSize() const
+	{
+		return Size;
+	}
+
+	inline std::size_t SpatialHash::PointCount() const
+	{
+		return Entries.size();
+	}
+
+	inline int SpatialHash::Cell(float x) const
+	{
+		// Clamped so that far-away or non-finite coordinates still land in some valid cell.
+		float c = std::floor(x * InverseSize);
+		c = (c > 1.0e9f ? 1.0e9f : (c < -1.0e9f ? -1.0e9f : c));
+		return (c == c ? static_cast<int>(c) : 0);
+	}
+
+	inline unsigned int SpatialHash::Bucket(int x, int y, int z) const
+	{
+		return ((static_cast<unsigned int>(x) * 73856093u) ^
+				(static_cast<unsigned int>(y) * 19349663u) ^
+				(static_cast<unsigned int>(z) * 83492791u)) & Mask;
+	}
+}
+
+#endif
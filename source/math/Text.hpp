@@ -0,0 +1,157 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+#ifndef SMALLMATH_TEXT
+#define SMALLMATH_TEXT
+
+#include <charconv>
+#include <cstddef>
+#include <system_error>
+
+namespace Math
+{
+	// Every class has a pair of free functions declared alongside it:
+	//
+	//   char *Format(char *First, char *Last, T const &b);
+	//   char const *Parse(char const *First, char const *Last, T &b);
+	//
+	// Format writes the same layout as operator<< into [First, Last) with shortest round-trip
+	// floats and returns one past the last character written.  Parse reads that layout back,
+	// ignoring whitespace between tokens, and returns one past the last character consumed.
+	// Both return NULL on failure (no room, or malformed input) and never allocate.
+
+	namespace Text
+	{
+		// Large enough for any single value, Matrix4 included.
+		static const std::size_t MaxLength = 384;
+
+		inline char *Write(char *First, char *Last, char const *Literal)
+		{
+			if (First == NULL)
+				return NULL;
+
+			for (; *Literal != '\0'; Literal++)
+			{
+				if (First == Last)
+					return NULL;
+
+				*First++ = *Literal;
+			}
+
+			return First;
+		}
+
+		inline char *Write(char *First, char *Last, float Value)
+		{
+			if (First == NULL)
+				return NULL;
+
+			std::to_chars_result r = std::to_chars(First, Last, Value);
+			return (r.ec == std::errc() ? r.ptr : NULL);
+		}
+
+		inline bool IsSpace(char c)
+		{
+			return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+		}
+
+		inline char const *SkipSpace(char const *First, char const *Last)
+		{
+			while (First != Last && IsSpace(*First))
+				First++;
+
+			return First;
+		}
+
+		// Whitespace in Literal matches any amount of whitespace (including none) in the input.
+		inline char const *Read(char const *First, char const *Last, char const *Literal)
+		{
+			if (First == NULL)
+				return NULL;
+
+			for (; *Literal != '\0'; Literal++)
+			{
+				if (IsSpace(*Literal))
+				{
+					First = SkipSpace(First, Last);
+					continue;
+				}
+
+				if (First == Last || *First != *Literal)
+					return NULL;
+
+				First++;
+			}
+
+			return First;
+		}
+
+		inline char const *Read(char const *First, char const *Last, float &Value)
+		{
+			if (First == NULL)
+				return NULL;
+
+			First = SkipSpace(First, Last);
+
+			std::from_chars_result r = std::from_chars(First, Last, Value);
+			return (r.ec == std::errc() ? r.ptr : NULL);
+		}
+	}
+
+	// Batch formatting ===================================
+
+	// Formats as many whole elements as fit, each followed by Separator.  Formatted receives the
+	// number of elements written so the caller can flush the buffer and continue from there.
+	template <typename T>
+	char *FormatArray(char *First, char *Last, T const *Data, std::size_t Count, std::size_t &Formatted, char Separator = '\n')
+	{
+		char const SeparatorString[2] = {Separator, '\0'};
+
+		for (Formatted = 0; Formatted < Count; Formatted++)
+		{
+			char *End = Text::Write(Format(First, Last, Data[Formatted]), Last, SeparatorString);
+			if (End == NULL)
+				break;
+
+			First = End;
+		}
+
+		return First;
+	}
+
+	// Parses up to Capacity whitespace-separated elements, stopping at the first one that fails.
+	// Returns one past the last element parsed and any whitespace after it; Parsed receives how
+	// many elements were read.
+	template <typename T>
+	char const *ParseArray(char const *First, char const *Last, T *Data, std::size_t Capacity, std::size_t &Parsed)
+	{
+		for (Parsed = 0; Parsed < Capacity; Parsed++)
+		{
+			char const *End = Parse(First, Last, Data[Parsed]);
+			if (End == NULL)
+				break;
+
+			First = Text::SkipSpace(End, Last);
+		}
+
+		return First;
+	}
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#include "math/Transform.hpp"
+
+using namespace Math;
+
+// General operations =====================================
+
+Transform Transform::Inverted() const
+{
+	Quaternion r = Rotation.Conjugate();
+	Vector3 s(1.0f / Scale.x, 1.0f / Scale.y, 1.0f / Scale.z);
+	return Transform(s, r, (r * Translation) * s * -1.0f);
+}
+
+// Binary and unary multiplication operators ==============
+
+Transform Transform::operator*(Transform const &b) const
+{
+	return Transform(Scale * b.Scale, Rotation * b.Rotation, Rotation * (Scale * b.Translation) + Translation);
+}
+
+// Private ================================================
+
+void Transform::BuildMatrix() const
+{
+	Forward = Matrix4(Scale, Rotation, Translation);
+	Cached |= MatrixCached;
+}
+
+void Transform::BuildInverse() const
+{
+	// (T R S)^-1 = S^-1 R^T T^-1: the rotation transposed with its rows divided by the scale, and
+	// the translation taken back through both.
+	Matrix3 r(Rotation);
+	Vector3 s(1.0f / Scale.x, 1.0f / Scale.y, 1.0f / Scale.z);
+
+	for (int Row = 0; Row < 3; Row++)
+	{
+		for (int Column = 0; Column < 3; Column++)
+			Inverse.m[Row][Column] = r.m[Column][Row] * s[Row];
+
+		Inverse.m[Row][3] = -(Inverse.m[Row][0] * Translation.x + Inverse.m[Row][1] * Translation.y + Inverse.m[Row][2] * Translation.z);
+	}
+
+	Inverse.m[3][0] = 0.0f;
+	Inverse.m[3][1] = 0.0f;
+	Inverse.m[3][2] = 0.0f;
+	Inverse.m[3][3] = 1.0f;
+
+	Cached |= InverseCached;
+}
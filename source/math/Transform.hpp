@@ -0,0 +1,156 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#ifndef SMALLMATH_TRANSFORM
+#define SMALLMATH_TRANSFORM
+
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// Scale, then rotate, then translate: the same matrix as Matrix4(Scale, Rotation, Translation).
+	// Matrix() and InverseMatrix() are built on first use and kept until the next Set*() call, so
+	// asking for them repeatedly costs nothing.  Because of that caching, a Transform shared between
+	// threads must not be read from one while another calls anything else on it.
+	//
+	// Composition and inversion work on the scale, rotation and translation directly.  A scale that
+	// isn't uniform, followed by a rotation, is a shear that they can't represent, so operator* and
+	// Inverted() are exact only when the left (or inverted) operand's scale is uniform, as in
+	// most engines' transform hierarchies.  InverseMatrix() is exact for any nonzero scale.
+	class Transform
+	{
+	public:
+		Transform() : Scale(1.0f, 1.0f, 1.0f), Cached(0) { }
+		Transform(Vector3 const &Scale, Quaternion const &Rotation, Vector3 const &Translation) :
+			Scale(Scale), Rotation(Rotation), Translation(Translation), Cached(0) { }
+
+		// General operations
+		inline void SetIdentity();
+		inline Vector3 const &GetScale() const;
+		inline Quaternion const &GetRotation() const;
+		inline Vector3 const &GetTranslation() const;
+		inline void SetScale(Vector3 const &b);
+		inline void SetRotation(Quaternion const &b);
+		inline void SetTranslation(Vector3 const &b);
+		inline Matrix4 const &Matrix() const;
+		inline Matrix4 const &InverseMatrix() const;
+		Transform Inverted() const;
+
+		// Binary and unary multiplication operators
+		Transform operator*(Transform const &b) const;	// b first, then *this
+		inline Vector3 operator*(Vector3 const &b) const;	// Transforms b as a point
+		inline Transform &operator*=(Transform const &b);
+
+	private:
+		void BuildMatrix() const;
+		void BuildInverse() const;
+
+		static const unsigned int MatrixCached = 1;
+		static const unsigned int InverseCached = 2;
+
+		Vector3 Scale;
+		Quaternion Rotation;
+		Vector3 Translation;
+
+		mutable Matrix4 Forward, Inverse;
+		mutable unsigned int Cached;
+	};
+
+	// General operations =================================
+
+	inline void Transform::SetIdentity()
+	{
+		*this = Transform();
+	}
+
+	inline Vector3 const &Transform::GetScale() const
+	{
+		return Scale;
+	}
+
+	inline Quaternion const &Transform::GetRotation() const
+	{
+		return Rotation;
+	}
+
+	inline Vector3 const &Transform::GetTranslation() const
+	{
+		return Translation;
+	}
+
+	inline void Transform::SetScale(Vector3 const &b)
+	{
+		Scale = b;
+		Cached = 0;
+	}
+
+	inline void Transform::SetRotation(Quaternion const &b)
+	{
+		Rotation = b;
+		Cached = 0;
+	}
+
+	inline void Transform::SetTranslation(Vector3 const &b)
+	{
+		Translation = b;
+		Cached = 0;
+	}
+
+	inline Matrix4 const &Transform::Matrix() const
+	{
+		if ((Cached & MatrixCached) == 0)
+			this->BuildMatrix();
+
+		return Forward;
+	}
+
+	inline Matrix4 const &Transform::InverseMatrix() const
+	{
+		if ((Cached & InverseCached) == 0)
+			this->BuildInverse();
+
+		return Inverse;
+	}
+
+	// Binary and unary multiplication operators ==========
+
+	inline Vector3 Transform::operator*(Vector3 const &b) const
+	{
+		// The cached matrix is cheaper than rotating by the quaternion, but not worth building for one
+		// point.
+		if ((Cached & MatrixCached) == 0)
+			return Rotation * (Scale * b) + Translation;
+
+		float const (&m)[4][4] = Forward.m;
+		return Vector3(m[0][0] * b.x + m[0][1] * b.y + m[0][2] * b.z + m[0][3],
+					   m[1][0] * b.x + m[1][1] * b.y + m[1][2] * b.z + m[1][3],
+					   m[2][0] * b.x + m[2][1] * b.y + m[2][2] * b.z + m[2][3]);
+	}
+
+	inline Transform &Transform::operator*=(Transform const &b)
+	{
+		*this = *this * b;
+		return *this;
+	}
+}
+
+#endif
@@ -0,0 +1,98 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#include <algorithm>
+
+#include "math/TransformStore.hpp"
+
+using namespace Math;
+
+TransformStore::Snapshot::Snapshot(Buffer const &Data) :
+	Data(Data)
+{
+
+}
+
+TransformStore::Snapshot::~Snapshot()
+{
+	Data.Departed.fetch_add(1, std::memory_order_release);
+}
+
+TransformStore::TransformStore(std::size_t Count, unsigned int Readers) :
+	Buffers(std::min(Readers, static_cast<unsigned int>(IndexMask) - 1) + 2),
+	Latest(0),
+	Working(Count),
+	Prior(Count),
+	Changed(Count, 0),
+	Pending(1)
+{
+	for (std::size_t Index = 0; Index < Buffers.size(); Index++)
+	{
+		Buffers[Index].Current.assign(Count, Pose());
+		Buffers[Index].Previous.assign(Count, Pose());
+	}
+}
+
+bool TransformStore::Publish()
+{
+	// Only this thread moves Latest to another buffer, so the index can't change under us.
+	std::size_t Current = static_cast<std::size_t>(Latest.load(std::memory_order_relaxed) & IndexMask);
+
+	std::size_t Free = Buffers.size();
+	for (std::size_t Index = 0; Index < Buffers.size() && Free == Buffers.size(); Index++)
+	{
+		if (Index != Current && Buffers[Index].Departed.load(std::memory_order_acquire) == Buffers[Index].Expected)
+			Free = Index;
+	}
+
+	if (Free == Buffers.size())
+		return false;
+
+	// The buffer is correct as of its tick for every pose that hasn't changed since, so only the
+	// others need writing.  A pose changed in the pending tick gets its prior value as Previous.
+	Buffer &Next = Buffers[Free];
+	unsigned long long Since = Next.Tick;
+
+	for (std::size_t Index = 0; Index < Working.size(); Index++)
+	{
+		if (Changed[Index] >= Since)
+		{
+			Next.Current[Index] = Working[Index];
+			Next.Previous[Index] = (Changed[Index] == Pending ? Prior[Index] : Working[Index]);
+		}
+	}
+
+	Next.Tick = Pending;
+	Next.Expected = 0;
+	Next.Departed.store(0, std::memory_order_relaxed);
+
+	// Swap it in.  Every reader counted against the old buffer will depart it exactly once.
+	unsigned long long Old = Latest.exchange(Free, std::memory_order_acq_rel);
+	Buffers[Old & IndexMask].Expected = Old >> IndexBits;
+
+	Pending++;
+	return true;
+}
+
+TransformStore::Snapshot TransformStore::Read() const
+{
+	unsigned long long State = Latest.fetch_add(1ull << IndexBits, std::memory_order_acquire);
+	return Snapshot(Buffers[State & IndexMask]);
+}
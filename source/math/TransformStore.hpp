@@ -0,0 +1,211 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+
+#ifndef SMALLMATH_TRANSFORMSTORE
+#define SMALLMATH_TRANSFORMSTORE
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "math/Allocator.hpp"
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+#include "math/Vector.hpp"
+
+namespace Math
+{
+	// A rotation followed by a translation
+	class Pose
+	{
+	public:
+		Pose() { }
+		Pose(Quaternion const &Rotation, Vector3 const &Translation) : Rotation(Rotation), Translation(Translation) { }
+
+		// General operations
+		inline Matrix4 Matrix() const;
+		inline Pose Interpolated(Pose const &b, float t) const;	// Slerp and Lerp
+
+		Quaternion Rotation;
+		Vector3 Translation;
+	};
+
+	// Hands a fixed number of poses from one writer thread to any number of reader threads a tick at
+	// a time.  The writer changes poses with Set() and makes the changes visible with Publish();
+	// readers take a Snapshot, which always shows one complete published tick, together with the
+	// tick before it for interpolation.
+	//
+	// Ticks are kept in Readers + 2 buffers: the latest tick, one that each reader may be holding,
+	// and one for the writer to fill.  Readers never wait or retry: taking a snapshot is one atomic
+	// increment that both reads the latest buffer's index and registers the reader on it, and
+	// releasing it is another.  The writer only reuses a buffer once every reader that entered it has
+	// left.  Publishing copies just the poses that changed since the buffer last held a tick.
+	class TransformStore
+	{
+	private:
+		class Buffer;
+
+	public:
+		class Snapshot
+		{
+		public:
+			~Snapshot();
+
+			// General operations
+			inline unsigned long long Tick() const;	// 0 until the first Publish()
+			inline std::size_t Count() const;
+			inline Pose const &Current(std::size_t Index) const;
+			inline Pose const &Previous(std::size_t Index) const;	// At Tick() - 1
+			inline Pose Interpolated(std::size_t Index, float t) const;	// Previous at 0, Current at 1
+			inline Matrix4 Matrix(std::size_t Index) const;
+
+		private:
+			friend class TransformStore;
+
+			Snapshot(Buffer const &Data);
+			Snapshot(Snapshot const &);
+			Snapshot &operator=(Snapshot const &);
+
+			Buffer const &Data;
+		};
+
+		// Readers is the most snapshots alive at once, across all reader threads, up to 254.
+		TransformStore(std::size_t Count, unsigned int Readers = 2);
+
+		// Writer ===========================================
+
+		inline void Set(std::size_t Index, Pose const &b);
+		inline void Set(std::size_t Index, Quaternion const &Rotation, Vector3 const &Translation);
+		inline Pose const &Get(std::size_t Index) const;		// The writer's latest value
+
+		// Makes everything Set() so far visible as the next tick.  Returns false, keeping the changes
+		// for the next call, only if more than Readers snapshots are alive and hold every buffer.
+		bool Publish();
+
+		// Readers ==========================================
+
+		Snapshot Read() const;
+		inline std::size_t Count() const;
+
+	private:
+		TransformStore(TransformStore const &);
+		TransformStore &operator=(TransformStore const &);
+
+		class Buffer
+		{
+		public:
+			Buffer() : Tick(0), Expected(0), Departed(0) { }
+
+			std::vector<Pose, AlignedAllocator<Pose> > Current, Previous;
+			unsigned long long Tick;
+			unsigned long long Expected;		// Readers that entered, once it stopped being the latest
+
+			alignas(CacheLineSize) mutable std::atomic<unsigned long long> Departed;
+		};
+
+		// The latest buffer's index in the low bits and the number of readers that have entered it
+		// above them
+		static const unsigned int IndexBits = 8;
+		static const unsigned long long IndexMask = (1ull << IndexBits) - 1;
+
+		std::vector<Buffer, AlignedAllocator<Buffer> > Buffers;
+		alignas(CacheLineSize) mutable std::atomic<unsigned long long> Latest;
+
+		// Writer state: the working poses, each one's value before its last change, and the tick of
+		// that change
+		std::vector<Pose, AlignedAllocator<Pose> > Working, Prior;
+		std::vector<unsigned long long> Changed;
+		unsigned long long Pending;
+	};
+
+	// Inline methods =====================================
+
+	inline Matrix4 Pose::Matrix() const
+	{
+		Matrix3 r(Rotation);
+		return Matrix4(r.m[0][0], r.m[0][1], r.m[0][2], Translation.x,
+					   r.m[1][0], r.m[1][1], r.m[1][2], Translation.y,
+					   r.m[2][0], r.m[2][1], r.m[2][2], Translation.z,
+					   0.0f,      0.0f,      0.0f,      1.0f);
+	}
+
+	inline Pose Pose::Interpolated(Pose const &b, float t) const
+	{
+		return Pose(Rotation.Slerp(b.Rotation, t), Translation.Lerp(b.Translation, t));
+	}
+
+	inline unsigned long long TransformStore::Snapshot::Tick() const
+	{
+		return Data.Tick;
+	}
+
+	inline std::size_t TransformStore::Snapshot::Count() const
+	{
+		return Data.Current.size();
+	}
+
+	inline Pose const &TransformStore::Snapshot::Current(std::size_t Index) const
+	{
+		return Data.Current[Index];
+	}
+
+	inline Pose const &TransformStore::Snapshot::Previous(std::size_t Index) const
+	{
+		return Data.Previous[Index];
+	}
+
+	inline Pose TransformStore::Snapshot::Interpolated(std::size_t Index, float t) const
+	{
+		return Data.Previous[Index].Interpolated(Data.Current[Index], t);
+	}
+
+	inline Matrix4 TransformStore::Snapshot::Matrix(std::size_t Index) const
+	{
+		return Data.Current[Index].Matrix();
+	}
+
+	inline void TransformStore::Set(std::size_t Index, Pose const &b)
+	{
+		if (Changed[Index] != Pending)
+		{
+			Prior[Index] = Working[Index];
+			Changed[Index] = Pending;
+		}
+
+		Working[Index] = b;
+	}
+
+	inline void TransformStore::Set(std::size_t Index, Quaternion const &Rotation, Vector3 const &Translation)
+	{
+		this->Set(Index, Pose(Rotation, Translation));
+	}
+
+	inline Pose const &TransformStore::Get(std::size_t Index) const
+	{
+		return Working[Index];
+	}
+
+	inline std::size_t TransformStore::Count() const
+	{
+		return Working.size();
+	}
+}
+
+#endif
@@ -39,3 +39,92 @@ Vector3::Vector3(Vector4 const &Vec)
 	y = Vec.y;
 	z = Vec.z;
 }
+
+// Text formatting ========================================
+
+char *Math::Format(char *First, char *Last, Vector2 const &b)
+{
+	First = Text::Write(First, Last, "(");
+	First = Text::Write(First, Last, b.x);
+	First = Text::Write(First, Last, ", ");
+	First = Text::Write(First, Last, b.y);
+	return Text::Write(First, Last, ")");
+}
+
+char const *Math::Parse(char const *First, char const *Last, Vector2 &b)
+{
+	Vector2 r;
+
+	First = Text::Read(First, Last, " (");
+	First = Text::Read(First, Last, r.x);
+	First = Text::Read(First, Last, " , ");
+	First = Text::Read(First, Last, r.y);
+	First = Text::Read(First, Last, " )");
+
+	if (First != NULL)
+		b = r;
+
+	return First;
+}
+
+char *Math::Format(char *First, char *Last, Vector3 const &b)
+{
+	First = Text::Write(First, Last, "(");
+	First = Text::Write(First, Last, b.x);
+	First = Text::Write(First, Last, ", ");
+	First = Text::Write(First, Last, b.y);
+	First = Text::Write(First, Last, ", ");
+	First = Text::Write(First, Last, b.z);
+	return Text::Write(First, Last, ")");
+}
+
+char const *Math::Parse(char const *First, char const *Last, Vector3 &b)
+{
+	Vector3 r;
+
+	First = Text::Read(First, Last, " (");
+	First = Text::Read(First, Last, r.x);
+	First = Text::Read(First, Last, " , ");
+	First = Text::Read(First, Last, r.y);
+	First = Text::Read(First, Last, " , ");
+	First = Text::Read(First, Last, r.z);
+	First = Text::Read(First, Last, " )");
+
+	if (First != NULL)
+		b = r;
+
+	return First;
+}
+
+char *Math::Format(char *First, char *Last, Vector4 const &b)
+{
+	First = Text::Write(First, Last, "(");
+	First = Text::Write(First, Last, b.x);
+	First = Text::Write(First, Last, ", ");
+	First = Text::Write(First, Last, b.y);
+	First = Text::Write(First, Last, ", ");
+	First = Text::Write(First, Last, b.z);
+	First = Text::Write(First, Last, ", ");
+	First = Text::Write(First, Last, b.w);
+	return Text::Write(First, Last, ")");
+}
+
+char const *Math::Parse(char const *First, char const *Last, Vector4 &b)
+{
+	Vector4 r;
+
+	First = Text::Read(First, Last, " (");
+	First = Text::Read(First, Last, r.x);
+	First = Text::Read(First, Last, " , ");
+	First = Text::Read(First, Last, r.y);
+	First = Text::Read(First, Last, " , ");
+	First = Text::Read(First, Last, r.z);
+	First = Text::Read(First, Last, " , ");
+	First = Text::Read(First, Last, r.w);
+	First = Text::Read(First, Last, " )");
+
+	if (First != NULL)
+		b = r;
+
+	return First;
+}
@@ -24,6 +24,8 @@
 #include <iostream>
 #include <limits>
 
+#include "math/Text.hpp"
+
 namespace Math
 {
 	class Vector3;
@@ -195,23 +197,38 @@ namespace Math
 		float x, y, z, w;
 	};
 
+	// Text formatting ====================================
+
+	char *Format(char *First, char *Last, Vector2 const &b);
+	char const *Parse(char const *First, char const *Last, Vector2 &b);
+	char *Format(char *First, char *Last, Vector3 const &b);
+	char const *Parse(char const *First, char const *Last, Vector3 &b);
+	char *Format(char *First, char *Last, Vector4 const &b);
+	char const *Parse(char const *First, char const *Last, Vector4 &b);
+
 	// Stream print =======================================
 
 	inline std::ostream &operator<<(std::ostream &a, Vector2 const &b)
 	{
-		a << "(" << b.x << ", " << b.y << ")";
+		char Buffer[Text::MaxLength];
+		char *End = Format(Buffer, Buffer + sizeof(Buffer), b);
+		a.write(Buffer, End - Buffer);
 		return a;
 	}
 
 	inline std::ostream &operator<<(std::ostream &a, Vector3 const &b)
 	{
-		a << "(" << b.x << ", " << b.y << ", " << b.z << ")";
+		char Buffer[Text::MaxLength];
+		char *End = Format(Buffer, Buffer + sizeof(Buffer), b);
+		a.write(Buffer, End - Buffer);
 		return a;
 	}
 
 	inline std::ostream &operator<<(std::ostream &a, Vector4 const &b)
 	{
-		a << "(" << b.x << ", " << b.y << ", " << b.z << ", " << b.w << ")";
+		char Buffer[Text::MaxLength];
+		char *End = Format(Buffer, Buffer + sizeof(Buffer), b);
+		a.write(Buffer, End - Buffer);
 		return a;
 	}
 
@@ -0,0 +1,273 @@
+/*
+* This file is part of SmallMath.
+*
+* SmallMath is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* SmallMath is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with SmallMath. If not, see <http://www.gnu.org/licenses/>.
+*
+* Copyright 2013 Chris Foster
+*/
+
+// Checks Fast against the error bounds documented in Precision.hpp over a fixed random sample.
+// Returns nonzero if any bound is exceeded.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "math/Precision.hpp"
+
+using namespace Math;
+
+namespace
+{
+	int const SampleCount = 200000;
+
+	std::mt19937 Generator(1);
+	int Failures = 0;
+
+	// mt19937's output is fully specified, unlike the standard distributions, so the sample is
+	// the same everywhere.
+	float Uniform(float Low, float High)
+	{
+		return Low + (High - Low) * static_cast<float>(Generator() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// A power of two scale, so lengths far from 1 are covered too
+	float Scale()
+	{
+		return std::ldexp(1.0f, static_cast<int>(Uniform(-20.0f, 20.0f)));
+	}
+
+	Quaternion UnitQuaternion()
+	{
+		Quaternion q(Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f));
+		q.Normalize();
+		return q;
+	}
+
+	double Length(Vector3 const &v)
+	{
+		return std::sqrt(static_cast<double>(v.x) * v.x + static_cast<double>(v.y) * v.y + static_cast<double>(v.z) * v.z);
+	}
+
+	double Length(Quaternion const &q)
+	{
+		return std::sqrt(static_cast<double>(q.w) * q.w + static_cast<double>(q.x) * q.x +
+						 static_cast<double>(q.y) * q.y + static_cast<double>(q.z) * q.z);
+	}
+
+	// Slerp from a to b in double precision, taking the short way round as Quaternion::Slerp() does
+	void ReferenceSlerp(Quaternion const &a, Quaternion const &b, float t, double (&r)[4])
+	{
+		double CosTheta = static_cast<double>(a.w) * b.w + static_cast<double>(a.x) * b.x +
+						  static_cast<double>(a.y) * b.y + static_cast<double>(a.z) * b.z;
+		double Sign = (CosTheta < 0.0 ? -1.0 : 1.0);
+		double Theta = std::acos(std::min(1.0, CosTheta * Sign));
+		double ka = 1.0 - t, kb = t;
+
+		if (Theta > 1e-9)
+		{
+			ka = std::sin((1.0 - t) * Theta) / std::sin(Theta);
+			kb = std::sin(t * Theta) / std::sin(Theta);
+		}
+
+		ka *= Sign;
+		r[0] = a.w * ka + b.w * kb;
+		r[1] = a.x * ka + b.x * kb;
+		r[2] = a.y * ka + b.y * kb;
+		r[3] = a.z * ka + b.z * kb;
+	}
+
+	// Angle of the rotation taking the unit reference r to q, from conj(r) * q.  atan2 keeps it
+	// accurate for small angles, where acos of the dot product would not be.
+	double RotationBetween(double const (&r)[4], Quaternion const &q)
+	{
+		double w = r[0] * q.w + r[1] * q.x + r[2] * q.y + r[3] * q.z;
+		double x = r[0] * q.x - r[1] * q.w - r[2] * q.z + r[3] * q.y;
+		double y = r[0] * q.y + r[1] * q.z - r[2] * q.w - r[3] * q.x;
+		double z = r[0] * q.z - r[1] * q.y + r[2] * q.x - r[3] * q.w;
+		return 2.0 * std::atan2(std::sqrt(x * x + y * y + z * z), std::abs(w));
+	}
+
+	int UlpDistance(float a, float b)
+	{
+		std::int32_t ia, ib;
+		std::memcpy(&ia, &a, sizeof(float));
+		std::memcpy(&ib, &b, sizeof(float));
+
+		if ((ia < 0) != (ib < 0))
+			return (a == b ? 0 : 0x7FFFFFFF);
+
+		return std::abs(ia - ib);
+	}
+
+	// Largest element of |Mat * Inverse - I|, accumulated in double
+	double Residual(Matrix4 const &Mat, Matrix4 const &Inverse)
+	{
+		double r = 0.0;
+
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				double Sum = (i == j ? -1.0 : 0.0);
+				for (int k = 0; k < 4; k++)
+					Sum += static_cast<double>(Mat.m[i][k]) * Inverse.m[k][j];
+				r = std::max(r, std::abs(Sum));
+			}
+		}
+
+		return r;
+	}
+
+	void Check(char const *Name, double Measured, double Bound)
+	{
+		bool Passed = (Measured <= Bound);
+		std::printf("%-44s %-10.3g bound %-10.3g %s\n", Name, Measured, Bound, (Passed ? "ok" : "FAILED"));
+
+		if (!Passed)
+			Failures++;
+	}
+
+	void CheckNormalize()
+	{
+		double VectorError = 0.0, QuaternionError = 0.0;
+
+		for (int Sample = 0; Sample < SampleCount; Sample++)
+		{
+			float s = Scale();
+			Vector3 v(Uniform(-s, s), Uniform(-s, s), Uniform(-s, s));
+			Quaternion q(Uniform(-s, s), Uniform(-s, s), Uniform(-s, s), Uniform(-s, s));
+
+			VectorError = std::max(VectorError, std::abs(Length(Fast::Normalized(v)) - 1.0));
+			QuaternionError = std::max(QuaternionError, std::abs(Length(Fast::Normalized(q)) - 1.0));
+		}
+
+		Check("Normalized (Vector3) |length - 1|", VectorError, 4e-7);
+		Check("Normalized (Quaternion) |length - 1|", QuaternionError, 4e-7);
+	}
+
+	void CheckSlerp()
+	{
+		double Rotation = 0.0, LengthError = 0.0;
+
+		for (int Sample = 0; Sample < SampleCount; Sample++)
+		{
+			Quaternion a = UnitQuaternion();
+			Quaternion b = UnitQuaternion();
+			float t = Uniform(0.0f, 1.0f);
+
+			double Reference[4];
+			ReferenceSlerp(a, b, t, Reference);
+
+			Quaternion q = Fast::Slerp(a, b, t);
+			Rotation = std::max(Rotation, RotationBetween(Reference, q));
+			LengthError = std::max(LengthError, std::abs(Length(q) - 1.0));
+		}
+
+		Check("Slerp rotation (radians)", Rotation, 1e-3);
+		Check("Slerp |length - 1|", LengthError, 4e-7);
+	}
+
+	void CheckQuaternionInverse()
+	{
+		int Ulps = 0;
+
+		for (int Sample = 0; Sample < SampleCount; Sample++)
+		{
+			float s = Scale();
+			Quaternion q(Uniform(-s, s), Uniform(-s, s), Uniform(-s, s), Uniform(-s, s));
+			Quaternion f = Fast::Inverted(q);
+			Quaternion p = Precise::Inverted(q);
+
+			Ulps = std::max(Ulps, UlpDistance(f.w, p.w));
+			Ulps = std::max(Ulps, UlpDistance(f.x, p.x));
+			Ulps = std::max(Ulps, UlpDistance(f.y, p.y));
+			Ulps = std::max(Ulps, UlpDistance(f.z, p.z));
+		}
+
+		Check("Inverted (Quaternion) ulps", Ulps, 1.0);
+	}
+
+	void CheckMatrixInverse()
+	{
+		double FastResidual[2] = {0.0, 0.0}, PreciseResidual[2] = {0.0, 0.0};
+
+		for (int Sample = 0; Sample < SampleCount; Sample++)
+		{
+			Vector3 s(Uniform(0.1f, 10.0f), Uniform(0.1f, 10.0f), Uniform(0.1f, 10.0f));
+			Vector3 t(Uniform(-100.0f, 100.0f), Uniform(-100.0f, 100.0f), Uniform(-100.0f, 100.0f));
+			Matrix4 Affine(s, UnitQuaternion(), t);
+
+			Matrix4 General;
+			for (int i = 0; i < 4; i++)
+			{
+				for (int j = 0; j < 4; j++)
+					General.m[i][j] = Uniform(-1.0f, 1.0f);
+			}
+
+			FastResidual[0] = std::max(FastResidual[0], Residual(Affine, Fast::Inverted(Affine)));
+			PreciseResidual[0] = std::max(PreciseResidual[0], Residual(Affine, Precise::Inverted(Affine)));
+			FastResidual[1] = std::max(FastResidual[1], Residual(General, Fast::Inverted(General)));
+			PreciseResidual[1] = std::max(PreciseResidual[1], Residual(General, Precise::Inverted(General)));
+		}
+
+		Check("Inverted (Matrix4) transforms, x Precise", FastResidual[0] / PreciseResidual[0], 1.0);
+		Check("Inverted (Matrix4) general, x Precise", FastResidual[1] / PreciseResidual[1], 4.0);
+	}
+
+	// Matrices with one row a combination of two others have a determinant that rounds to a small
+	// nonzero value; they should still come back as the identity.
+	void CheckSingularInverse()
+	{
+		int Missed = 0;
+
+		for (int Sample = 0; Sample < SampleCount; Sample++)
+		{
+			float s = Scale();
+			Matrix4 Mat;
+			for (int i = 0; i < 4; i++)
+			{
+				for (int j = 0; j < 4; j++)
+					Mat.m[i][j] = Uniform(-s, s);
+			}
+
+			// The first is row 2 = 0.3 row 0 + 0.7 row 1
+			int Row = (Sample + 2) % 4;
+			float a = (Sample == 0 ? 0.3f : Uniform(-1.0f, 1.0f));
+			float b = (Sample == 0 ? 0.7f : Uniform(-1.0f, 1.0f));
+			for (int j = 0; j < 4; j++)
+				Mat.m[Row][j] = a * Mat.m[(Row + 2) % 4][j] + b * Mat.m[(Row + 3) % 4][j];
+
+			Matrix4 Inverse = Fast::Inverted(Mat);
+			if (std::memcmp(Inverse.m, Matrix4().m, sizeof(Inverse.m)) != 0)
+				Missed++;
+		}
+
+		Check("Inverted (Matrix4) rank-deficient missed", Missed, 0.0);
+	}
+}
+
+int main()
+{
+	CheckNormalize();
+	CheckSlerp();
+	CheckQuaternionInverse();
+	CheckMatrixInverse();
+	CheckSingularInverse();
+
+	return (Failures == 0 ? 0 : 1);
+}